@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ConvertUtils.h"
+
+#include <android-base/logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+using AidlSensorInfo = ::aidl::android::hardware::sensors::SensorInfo;
+using AidlSensorType = ::aidl::android::hardware::sensors::SensorType;
+using AidlEvent = ::aidl::android::hardware::sensors::Event;
+using AidlSensorStatus = ::aidl::android::hardware::sensors::SensorStatus;
+using ::aidl::android::hardware::sensors::AdditionalInfo;
+using ::aidl::android::hardware::sensors::DynamicSensorInfo;
+using HidlSensorInfo = ::android::hardware::sensors::V2_1::SensorInfo;
+using HidlSensorType = ::android::hardware::sensors::V2_1::SensorType;
+using HidlEvent = ::android::hardware::sensors::V2_1::Event;
+using ::android::hardware::sensors::V1_0::AdditionalInfoType;
+using ::android::hardware::sensors::V1_0::MetaDataEventType;
+using ::android::hardware::sensors::V1_0::SensorStatus;
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace implementation {
+
+namespace {
+
+//! Element counts of the fixed size arrays in the HIDL event payload.
+constexpr size_t kDataSize = 16;
+constexpr size_t kPose6DofSize = 15;
+constexpr size_t kUuidSize = 16;
+constexpr size_t kAdditionalInfoSize = 14;
+
+//! The HIDL payload is a union of floats, integer fields of newer events are stored bitwise.
+int32_t floatBitsToInt(float value) {
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float intBitsToFloat(int32_t value) {
+    float bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+}  // namespace
+
+AidlSensorInfo convertSensorInfo(const HidlSensorInfo& sensorInfo) {
+    AidlSensorInfo aidlSensorInfo;
+    aidlSensorInfo.sensorHandle = sensorInfo.sensorHandle;
+    aidlSensorInfo.name = sensorInfo.name;
+    aidlSensorInfo.vendor = sensorInfo.vendor;
+    aidlSensorInfo.version = sensorInfo.version;
+    aidlSensorInfo.type = (AidlSensorType)sensorInfo.type;
+    aidlSensorInfo.typeAsString = sensorInfo.typeAsString;
+    aidlSensorInfo.maxRange = sensorInfo.maxRange;
+    aidlSensorInfo.resolution = sensorInfo.resolution;
+    aidlSensorInfo.power = sensorInfo.power;
+    aidlSensorInfo.minDelayUs = sensorInfo.minDelay;
+    aidlSensorInfo.fifoReservedEventCount = sensorInfo.fifoReservedEventCount;
+    aidlSensorInfo.fifoMaxEventCount = sensorInfo.fifoMaxEventCount;
+    aidlSensorInfo.requiredPermission = sensorInfo.requiredPermission;
+    aidlSensorInfo.maxDelayUs = sensorInfo.maxDelay;
+    aidlSensorInfo.flags = sensorInfo.flags;
+    return aidlSensorInfo;
+}
+
+void convertToHidlEvent(const AidlEvent& aidlEvent, HidlEvent* hidlEvent) {
+    hidlEvent->timestamp = aidlEvent.timestamp;
+    hidlEvent->sensorHandle = aidlEvent.sensorHandle;
+    hidlEvent->sensorType = (HidlSensorType)aidlEvent.sensorType;
+
+    switch (aidlEvent.sensorType) {
+        case AidlSensorType::META_DATA:
+            hidlEvent->u.meta.what =
+                    (MetaDataEventType)aidlEvent.payload.get<AidlEvent::EventPayload::meta>().what;
+            break;
+        case AidlSensorType::ACCELEROMETER:
+        case AidlSensorType::MAGNETIC_FIELD:
+        case AidlSensorType::ORIENTATION:
+        case AidlSensorType::GYROSCOPE:
+        case AidlSensorType::GRAVITY:
+        case AidlSensorType::LINEAR_ACCELERATION: {
+            const auto& vec3 = aidlEvent.payload.get<AidlEvent::EventPayload::vec3>();
+            hidlEvent->u.vec3.x = vec3.x;
+            hidlEvent->u.vec3.y = vec3.y;
+            hidlEvent->u.vec3.z = vec3.z;
+            hidlEvent->u.vec3.status = (SensorStatus)vec3.status;
+            break;
+        }
+        case AidlSensorType::GAME_ROTATION_VECTOR: {
+            const auto& vec4 = aidlEvent.payload.get<AidlEvent::EventPayload::vec4>();
+            hidlEvent->u.vec4.x = vec4.x;
+            hidlEvent->u.vec4.y = vec4.y;
+            hidlEvent->u.vec4.z = vec4.z;
+            hidlEvent->u.vec4.w = vec4.w;
+            break;
+        }
+        case AidlSensorType::ROTATION_VECTOR:
+        case AidlSensorType::GEOMAGNETIC_ROTATION_VECTOR: {
+            const auto& data = aidlEvent.payload.get<AidlEvent::EventPayload::data>();
+            std::copy(data.values.begin(), data.values.begin() + 5, hidlEvent->u.data.data());
+            break;
+        }
+        case AidlSensorType::MAGNETIC_FIELD_UNCALIBRATED:
+        case AidlSensorType::GYROSCOPE_UNCALIBRATED:
+        case AidlSensorType::ACCELEROMETER_UNCALIBRATED: {
+            const auto& uncal = aidlEvent.payload.get<AidlEvent::EventPayload::uncal>();
+            hidlEvent->u.uncal.x = uncal.x;
+            hidlEvent->u.uncal.y = uncal.y;
+            hidlEvent->u.uncal.z = uncal.z;
+            hidlEvent->u.uncal.x_bias = uncal.xBias;
+            hidlEvent->u.uncal.y_bias = uncal.yBias;
+            hidlEvent->u.uncal.z_bias = uncal.zBias;
+            break;
+        }
+        case AidlSensorType::DEVICE_ORIENTATION:
+        case AidlSensorType::LIGHT:
+        case AidlSensorType::PRESSURE:
+        case AidlSensorType::PROXIMITY:
+        case AidlSensorType::RELATIVE_HUMIDITY:
+        case AidlSensorType::AMBIENT_TEMPERATURE:
+        case AidlSensorType::SIGNIFICANT_MOTION:
+        case AidlSensorType::STEP_DETECTOR:
+        case AidlSensorType::TILT_DETECTOR:
+        case AidlSensorType::WAKE_GESTURE:
+        case AidlSensorType::GLANCE_GESTURE:
+        case AidlSensorType::PICK_UP_GESTURE:
+        case AidlSensorType::WRIST_TILT_GESTURE:
+        case AidlSensorType::STATIONARY_DETECT:
+        case AidlSensorType::MOTION_DETECT:
+        case AidlSensorType::HEART_BEAT:
+        case AidlSensorType::LOW_LATENCY_OFFBODY_DETECT:
+        case AidlSensorType::HINGE_ANGLE:
+            hidlEvent->u.scalar = aidlEvent.payload.get<AidlEvent::EventPayload::scalar>();
+            break;
+        case AidlSensorType::STEP_COUNTER:
+            hidlEvent->u.stepCount = aidlEvent.payload.get<AidlEvent::EventPayload::stepCount>();
+            break;
+        case AidlSensorType::HEART_RATE: {
+            const auto& heartRate = aidlEvent.payload.get<AidlEvent::EventPayload::heartRate>();
+            hidlEvent->u.heartRate.bpm = heartRate.bpm;
+            hidlEvent->u.heartRate.status = (SensorStatus)heartRate.status;
+            break;
+        }
+        case AidlSensorType::POSE_6DOF: {
+            const auto& pose = aidlEvent.payload.get<AidlEvent::EventPayload::pose6DOF>();
+            std::copy(pose.values.begin(), pose.values.end(), hidlEvent->u.pose6DOF.data());
+            break;
+        }
+        case AidlSensorType::DYNAMIC_SENSOR_META: {
+            const auto& dynamic = aidlEvent.payload.get<AidlEvent::EventPayload::dynamic>();
+            hidlEvent->u.dynamic.connected = dynamic.connected;
+            hidlEvent->u.dynamic.sensorHandle = dynamic.sensorHandle;
+            std::copy(dynamic.uuid.values.begin(), dynamic.uuid.values.end(),
+                      hidlEvent->u.dynamic.uuid.data());
+            break;
+        }
+        case AidlSensorType::ADDITIONAL_INFO: {
+            const AdditionalInfo& additional =
+                    aidlEvent.payload.get<AidlEvent::EventPayload::additional>();
+            hidlEvent->u.additional.type = (AdditionalInfoType)additional.type;
+            hidlEvent->u.additional.serial = additional.serial;
+            if (additional.payload.getTag() ==
+                AdditionalInfo::AdditionalInfoPayload::Tag::dataInt32) {
+                const auto& values =
+                        additional.payload.get<AdditionalInfo::AdditionalInfoPayload::dataInt32>()
+                                .values;
+                std::copy(values.begin(), values.end(),
+                          hidlEvent->u.additional.u.data_int32.data());
+            } else {
+                const auto& values =
+                        additional.payload.get<AdditionalInfo::AdditionalInfoPayload::dataFloat>()
+                                .values;
+                std::copy(values.begin(), values.end(),
+                          hidlEvent->u.additional.u.data_float.data());
+            }
+            break;
+        }
+        case AidlSensorType::HEAD_TRACKER: {
+            const auto& headTracker =
+                    aidlEvent.payload.get<AidlEvent::EventPayload::headTracker>();
+            hidlEvent->u.data[0] = headTracker.rx;
+            hidlEvent->u.data[1] = headTracker.ry;
+            hidlEvent->u.data[2] = headTracker.rz;
+            hidlEvent->u.data[3] = headTracker.vx;
+            hidlEvent->u.data[4] = headTracker.vy;
+            hidlEvent->u.data[5] = headTracker.vz;
+            hidlEvent->u.data[6] = intBitsToFloat(headTracker.discontinuityCount);
+            break;
+        }
+        case AidlSensorType::ACCELEROMETER_LIMITED_AXES:
+        case AidlSensorType::GYROSCOPE_LIMITED_AXES: {
+            const auto& imu = aidlEvent.payload.get<AidlEvent::EventPayload::limitedAxesImu>();
+            hidlEvent->u.data[0] = imu.x;
+            hidlEvent->u.data[1] = imu.y;
+            hidlEvent->u.data[2] = imu.z;
+            hidlEvent->u.data[3] = imu.xSupported;
+            hidlEvent->u.data[4] = imu.ySupported;
+            hidlEvent->u.data[5] = imu.zSupported;
+            break;
+        }
+        case AidlSensorType::ACCELEROMETER_LIMITED_AXES_UNCALIBRATED:
+        case AidlSensorType::GYROSCOPE_LIMITED_AXES_UNCALIBRATED: {
+            const auto& imu =
+                    aidlEvent.payload.get<AidlEvent::EventPayload::limitedAxesImuUncal>();
+            hidlEvent->u.data[0] = imu.x;
+            hidlEvent->u.data[1] = imu.y;
+            hidlEvent->u.data[2] = imu.z;
+            hidlEvent->u.data[3] = imu.xBias;
+            hidlEvent->u.data[4] = imu.yBias;
+            hidlEvent->u.data[5] = imu.zBias;
+            hidlEvent->u.data[6] = imu.xSupported;
+            hidlEvent->u.data[7] = imu.ySupported;
+            hidlEvent->u.data[8] = imu.zSupported;
+            break;
+        }
+        default: {
+            // Private sensors and anything newer than this file use the raw data payload.
+            const auto& data = aidlEvent.payload.get<AidlEvent::EventPayload::data>();
+            std::copy(data.values.begin(), data.values.end(), hidlEvent->u.data.data());
+            break;
+        }
+    }
+}
+
+void convertToAidlEvent(const HidlEvent& hidlEvent, AidlEvent* aidlEvent) {
+    aidlEvent->timestamp = hidlEvent.timestamp;
+    aidlEvent->sensorHandle = hidlEvent.sensorHandle;
+    aidlEvent->sensorType = (AidlSensorType)hidlEvent.sensorType;
+
+    switch (aidlEvent->sensorType) {
+        case AidlSensorType::META_DATA: {
+            AidlEvent::EventPayload::MetaData meta;
+            meta.what = (AidlEvent::EventPayload::MetaData::MetaDataEventType)hidlEvent.u.meta.what;
+            aidlEvent->payload.set<AidlEvent::EventPayload::meta>(meta);
+            break;
+        }
+        case AidlSensorType::ACCELEROMETER:
+        case AidlSensorType::MAGNETIC_FIELD:
+        case AidlSensorType::ORIENTATION:
+        case AidlSensorType::GYROSCOPE:
+        case AidlSensorType::GRAVITY:
+        case AidlSensorType::LINEAR_ACCELERATION: {
+            AidlEvent::EventPayload::Vec3 vec3;
+            vec3.x = hidlEvent.u.vec3.x;
+            vec3.y = hidlEvent.u.vec3.y;
+            vec3.z = hidlEvent.u.vec3.z;
+            vec3.status = (AidlSensorStatus)hidlEvent.u.vec3.status;
+            aidlEvent->payload.set<AidlEvent::EventPayload::vec3>(vec3);
+            break;
+        }
+        case AidlSensorType::GAME_ROTATION_VECTOR: {
+            AidlEvent::EventPayload::Vec4 vec4;
+            vec4.x = hidlEvent.u.vec4.x;
+            vec4.y = hidlEvent.u.vec4.y;
+            vec4.z = hidlEvent.u.vec4.z;
+            vec4.w = hidlEvent.u.vec4.w;
+            aidlEvent->payload.set<AidlEvent::EventPayload::vec4>(vec4);
+            break;
+        }
+        case AidlSensorType::ROTATION_VECTOR:
+        case AidlSensorType::GEOMAGNETIC_ROTATION_VECTOR: {
+            AidlEvent::EventPayload::Data data;
+            std::copy(hidlEvent.u.data.data(), hidlEvent.u.data.data() + 5, data.values.begin());
+            aidlEvent->payload.set<AidlEvent::EventPayload::data>(data);
+            break;
+        }
+        case AidlSensorType::MAGNETIC_FIELD_UNCALIBRATED:
+        case AidlSensorType::GYROSCOPE_UNCALIBRATED:
+        case AidlSensorType::ACCELEROMETER_UNCALIBRATED: {
+            AidlEvent::EventPayload::Uncal uncal;
+            uncal.x = hidlEvent.u.uncal.x;
+            uncal.y = hidlEvent.u.uncal.y;
+            uncal.z = hidlEvent.u.uncal.z;
+            uncal.xBias = hidlEvent.u.uncal.x_bias;
+            uncal.yBias = hidlEvent.u.uncal.y_bias;
+            uncal.zBias = hidlEvent.u.uncal.z_bias;
+            aidlEvent->payload.set<AidlEvent::EventPayload::uncal>(uncal);
+            break;
+        }
+        case AidlSensorType::DEVICE_ORIENTATION:
+        case AidlSensorType::LIGHT:
+        case AidlSensorType::PRESSURE:
+        case AidlSensorType::PROXIMITY:
+        case AidlSensorType::RELATIVE_HUMIDITY:
+        case AidlSensorType::AMBIENT_TEMPERATURE:
+        case AidlSensorType::SIGNIFICANT_MOTION:
+        case AidlSensorType::STEP_DETECTOR:
+        case AidlSensorType::TILT_DETECTOR:
+        case AidlSensorType::WAKE_GESTURE:
+        case AidlSensorType::GLANCE_GESTURE:
+        case AidlSensorType::PICK_UP_GESTURE:
+        case AidlSensorType::WRIST_TILT_GESTURE:
+        case AidlSensorType::STATIONARY_DETECT:
+        case AidlSensorType::MOTION_DETECT:
+        case AidlSensorType::HEART_BEAT:
+        case AidlSensorType::LOW_LATENCY_OFFBODY_DETECT:
+        case AidlSensorType::HINGE_ANGLE:
+            aidlEvent->payload.set<AidlEvent::EventPayload::scalar>(hidlEvent.u.scalar);
+            break;
+        case AidlSensorType::STEP_COUNTER:
+            aidlEvent->payload.set<AidlEvent::EventPayload::stepCount>(hidlEvent.u.stepCount);
+            break;
+        case AidlSensorType::HEART_RATE: {
+            AidlEvent::EventPayload::HeartRate heartRate;
+            heartRate.bpm = hidlEvent.u.heartRate.bpm;
+            heartRate.status = (AidlSensorStatus)hidlEvent.u.heartRate.status;
+            aidlEvent->payload.set<AidlEvent::EventPayload::heartRate>(heartRate);
+            break;
+        }
+        case AidlSensorType::POSE_6DOF: {
+            AidlEvent::EventPayload::Pose6Dof pose6Dof;
+            std::copy(hidlEvent.u.pose6DOF.data(),
+                      hidlEvent.u.pose6DOF.data() + kPose6DofSize,
+                      pose6Dof.values.begin());
+            aidlEvent->payload.set<AidlEvent::EventPayload::pose6DOF>(pose6Dof);
+            break;
+        }
+        case AidlSensorType::DYNAMIC_SENSOR_META: {
+            DynamicSensorInfo dynamicSensorInfo;
+            dynamicSensorInfo.connected = hidlEvent.u.dynamic.connected;
+            dynamicSensorInfo.sensorHandle = hidlEvent.u.dynamic.sensorHandle;
+            std::copy(hidlEvent.u.dynamic.uuid.data(),
+                      hidlEvent.u.dynamic.uuid.data() + kUuidSize,
+                      dynamicSensorInfo.uuid.values.begin());
+            aidlEvent->payload.set<AidlEvent::EventPayload::dynamic>(dynamicSensorInfo);
+            break;
+        }
+        case AidlSensorType::ADDITIONAL_INFO: {
+            AdditionalInfo additionalInfo;
+            additionalInfo.type = (AdditionalInfo::AdditionalInfoType)hidlEvent.u.additional.type;
+            additionalInfo.serial = hidlEvent.u.additional.serial;
+
+            // The integer view carries every payload bit for bit.
+            AdditionalInfo::AdditionalInfoPayload::Int32Values int32Values;
+            std::copy(hidlEvent.u.additional.u.data_int32.data(),
+                      hidlEvent.u.additional.u.data_int32.data() + kAdditionalInfoSize,
+                      int32Values.values.begin());
+            additionalInfo.payload.set<AdditionalInfo::AdditionalInfoPayload::dataInt32>(
+                    int32Values);
+            aidlEvent->payload.set<AidlEvent::EventPayload::additional>(additionalInfo);
+            break;
+        }
+        case AidlSensorType::HEAD_TRACKER: {
+            AidlEvent::EventPayload::HeadTracker headTracker;
+            headTracker.rx = hidlEvent.u.data[0];
+            headTracker.ry = hidlEvent.u.data[1];
+            headTracker.rz = hidlEvent.u.data[2];
+            headTracker.vx = hidlEvent.u.data[3];
+            headTracker.vy = hidlEvent.u.data[4];
+            headTracker.vz = hidlEvent.u.data[5];
+            headTracker.discontinuityCount = floatBitsToInt(hidlEvent.u.data[6]);
+            aidlEvent->payload.set<AidlEvent::EventPayload::headTracker>(headTracker);
+            break;
+        }
+        case AidlSensorType::ACCELEROMETER_LIMITED_AXES:
+        case AidlSensorType::GYROSCOPE_LIMITED_AXES: {
+            AidlEvent::EventPayload::LimitedAxesImu imu;
+            imu.x = hidlEvent.u.data[0];
+            imu.y = hidlEvent.u.data[1];
+            imu.z = hidlEvent.u.data[2];
+            imu.xSupported = hidlEvent.u.data[3];
+            imu.ySupported = hidlEvent.u.data[4];
+            imu.zSupported = hidlEvent.u.data[5];
+            aidlEvent->payload.set<AidlEvent::EventPayload::limitedAxesImu>(imu);
+            break;
+        }
+        case AidlSensorType::ACCELEROMETER_LIMITED_AXES_UNCALIBRATED:
+        case AidlSensorType::GYROSCOPE_LIMITED_AXES_UNCALIBRATED: {
+            AidlEvent::EventPayload::LimitedAxesImuUncal imu;
+            imu.x = hidlEvent.u.data[0];
+            imu.y = hidlEvent.u.data[1];
+            imu.z = hidlEvent.u.data[2];
+            imu.xBias = hidlEvent.u.data[3];
+            imu.yBias = hidlEvent.u.data[4];
+            imu.zBias = hidlEvent.u.data[5];
+            imu.xSupported = hidlEvent.u.data[6];
+            imu.ySupported = hidlEvent.u.data[7];
+            imu.zSupported = hidlEvent.u.data[8];
+            aidlEvent->payload.set<AidlEvent::EventPayload::limitedAxesImuUncal>(imu);
+            break;
+        }
+        default: {
+            // Private sensors and anything newer than this file use the raw data payload.
+            AidlEvent::EventPayload::Data data;
+            std::copy(hidlEvent.u.data.data(), hidlEvent.u.data.data() + kDataSize,
+                      data.values.begin());
+            aidlEvent->payload.set<AidlEvent::EventPayload::data>(data);
+            break;
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "EventBatcher.h"
+
+#include <algorithm>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+void EventBatcher::setSensors(const std::set<int32_t>& sensorHandles) {
+    for (int32_t sensorHandle : sensorHandles) {
+        mBatches.try_emplace(sensorHandle);
+    }
+}
+
+void EventBatcher::setReportLatency(int32_t sensorHandle, int64_t maxReportLatencyNs,
+                                    const Sink& sink) {
+    Batch* batch = findBatch(sensorHandle);
+    if (batch == nullptr) {
+        return;
+    }
+    thread_local std::vector<Event> flushed;
+    flushed.clear();
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    if (batch->maxReportLatencyNs > 0 && maxReportLatencyNs <= 0) {
+        mNumBatchingSensors.fetch_sub(1, std::memory_order_relaxed);
+    } else if (batch->maxReportLatencyNs <= 0 && maxReportLatencyNs > 0) {
+        mNumBatchingSensors.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (maxReportLatencyNs < batch->maxReportLatencyNs) {
+        takeBatch(batch, &flushed);
+        if (!flushed.empty()) {
+            sink(flushed);
+        }
+    }
+    batch->maxReportLatencyNs = std::max<int64_t>(maxReportLatencyNs, 0);
+}
+
+bool EventBatcher::process(std::vector<Event>* events, int64_t now) {
+    thread_local std::vector<Event> out;
+    out.clear();
+
+    uint64_t callId = mNextCallId.fetch_add(1, std::memory_order_relaxed);
+    bool earliest = false;
+    for (const Event& event : *events) {
+        Batch* batch = findBatch(event.sensorHandle);
+        if (batch == nullptr) {
+            out.push_back(event);
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(batch->mutex);
+        // Once an event of the sensor is in out, holding back a later one could let takeDue or
+        // flushSensor queue it before the caller has written out.
+        if (event.sensorType == SensorType::META_DATA || batch->maxReportLatencyNs <= 0 ||
+            batch->releasedInCall == callId) {
+            // Whatever is held back goes out first.
+            takeBatch(batch, &out);
+            out.push_back(event);
+            batch->releasedInCall = callId;
+            continue;
+        }
+        if (batch->events.empty()) {
+            batch->deadlineNs = now + batch->maxReportLatencyNs;
+            earliest |= lowerNextDeadline(batch->deadlineNs);
+        }
+        batch->events.push_back(event);
+        if (batch->events.size() >= kMaxBatchSize || batch->deadlineNs <= now) {
+            takeBatch(batch, &out);
+            batch->releasedInCall = callId;
+        }
+    }
+
+    events->swap(out);
+    return earliest;
+}
+
+void EventBatcher::takeDue(int64_t now, const Sink& sink) {
+    thread_local std::vector<Event> due;
+    // A batch started during the walk either lowers the deadline after this store or is seen
+    // by the walk, which locks it after the store.
+    mNextDeadlineNs.store(INT64_MAX, std::memory_order_release);
+    for (auto& [sensorHandle, batch] : mBatches) {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        if (batch.deadlineNs <= now) {
+            due.clear();
+            takeBatch(&batch, &due);
+            sink(due);
+        } else {
+            lowerNextDeadline(batch.deadlineNs);
+        }
+    }
+}
+
+void EventBatcher::flushSensor(int32_t sensorHandle, const Sink& sink) {
+    Batch* batch = findBatch(sensorHandle);
+    if (batch == nullptr) {
+        return;
+    }
+    thread_local std::vector<Event> flushed;
+    flushed.clear();
+    std::lock_guard<std::mutex> lock(batch->mutex);
+    takeBatch(batch, &flushed);
+    if (!flushed.empty()) {
+        sink(flushed);
+    }
+}
+
+void EventBatcher::clear() {
+    for (auto& [sensorHandle, batch] : mBatches) {
+        std::lock_guard<std::mutex> lock(batch.mutex);
+        batch.events.clear();
+        batch.deadlineNs = INT64_MAX;
+        batch.maxReportLatencyNs = 0;
+    }
+    mNumBatchingSensors.store(0, std::memory_order_relaxed);
+    mNextDeadlineNs.store(INT64_MAX, std::memory_order_release);
+}
+
+EventBatcher::Batch* EventBatcher::findBatch(int32_t sensorHandle) {
+    auto iter = mBatches.find(sensorHandle);
+    return iter == mBatches.end() ? nullptr : &iter->second;
+}
+
+void EventBatcher::takeBatch(Batch* batch, std::vector<Event>* out) {
+    out->insert(out->end(), batch->events.begin(), batch->events.end());
+    batch->events.clear();
+    batch->deadlineNs = INT64_MAX;
+}
+
+bool EventBatcher::lowerNextDeadline(int64_t deadlineNs) {
+    int64_t nextDeadlineNs = mNextDeadlineNs.load(std::memory_order_relaxed);
+    while (deadlineNs < nextDeadlineNs) {
+        if (mNextDeadlineNs.compare_exchange_weak(nextDeadlineNs, deadlineNs,
+                                                  std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
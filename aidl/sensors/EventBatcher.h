@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/2.1/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Emulates a hardware FIFO for non-wake-up sensors whose sub-HAL ignores maxReportLatencyNs.
+ * Events of a batching sensor are held back until its report latency has passed since the
+ * first of them, its batch is full, or the sensor is flushed, and then go out together.
+ *
+ * Every sensor has its own batch and lock, so posts of different sensors never contend. Events
+ * of one sensor must be passed to process by one thread at a time, as sub-HALs post them.
+ */
+class EventBatcher {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+
+    /**
+     * Receives a batch released outside of process. It is called with the sensor's batch
+     * locked, so the events must be queued before it returns: no later event of the sensor can
+     * be released until then.
+     */
+    using Sink = std::function<void(const std::vector<Event>&)>;
+
+    //! The most events held back for one sensor, advertised as its FIFO size.
+    static constexpr uint32_t kMaxBatchSize = 300;
+
+    /**
+     * Set the sensors that can batch. Must be called once, before any other method.
+     */
+    void setSensors(const std::set<int32_t>& sensorHandles);
+
+    //! Whether any sensor is batching, cheap enough to check on every post.
+    bool active() const { return mNumBatchingSensors.load(std::memory_order_relaxed) > 0; }
+
+    /**
+     * Set the report latency of a sensor, 0 stops batching it. The events held back for the
+     * sensor go to sink if its batch can no longer wait as long as before.
+     */
+    void setReportLatency(int32_t sensorHandle, int64_t maxReportLatencyNs, const Sink& sink);
+
+    /**
+     * Hold back the events of batching sensors. Everything that must go out now, including
+     * batches that became due, is left in events. A batch always precedes the meta data event
+     * of its sensor, so flush completions stay ordered after the data they cover.
+     *
+     * @return true if a batch started that is due before any other, so the caller should
+     *     wake whoever calls takeDue.
+     */
+    bool process(std::vector<Event>* events, int64_t now);
+
+    //! Pass every batch due at now to sink.
+    void takeDue(int64_t now, const Sink& sink);
+
+    //! Pass the batch of one sensor to sink, if it holds any events.
+    void flushSensor(int32_t sensorHandle, const Sink& sink);
+
+    /**
+     * When the next batch is due, or INT64_MAX if nothing is held back. It may be early after a
+     * batch was released ahead of time, takeDue then finds nothing and corrects it.
+     */
+    int64_t nextDeadline() const { return mNextDeadlineNs.load(std::memory_order_acquire); }
+
+    //! Forget every batch and report latency.
+    void clear();
+
+  private:
+    struct Batch {
+        std::mutex mutex;
+        int64_t maxReportLatencyNs = 0;
+        int64_t deadlineNs = INT64_MAX;
+        //! The last process call that released an event of this sensor.
+        uint64_t releasedInCall = 0;
+        std::vector<Event> events;
+    };
+
+    //! @return The batch of the sensor or nullptr if it cannot batch.
+    Batch* findBatch(int32_t sensorHandle);
+
+    //! Move a batch to out and reset it. The batch's mutex must be held.
+    void takeBatch(Batch* batch, std::vector<Event>* out);
+
+    //! Lower mNextDeadlineNs to deadlineNs. @return true if it was later.
+    bool lowerNextDeadline(int64_t deadlineNs);
+
+    //! Built by setSensors and never changed afterwards, so it is read without a lock.
+    std::map<int32_t, Batch> mBatches;
+    std::atomic<size_t> mNumBatchingSensors = 0;
+    std::atomic<int64_t> mNextDeadlineNs = INT64_MAX;
+    std::atomic<uint64_t> mNextCallId = 1;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "EventTrace.h"
+#include "SubHalIndex.h"
+
+#include <android-base/file.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+struct Header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t numRecords;
+    uint32_t numLost;
+};
+
+struct Record {
+    int64_t timestampNs;
+    int32_t sensorHandle;
+    uint16_t count;
+    uint8_t subHalIndex;
+    uint8_t stage;
+};
+
+static_assert(sizeof(Header) == 16 && sizeof(Record) == 16, "trace layout changed");
+
+}  // namespace
+
+void EventTrace::record(Stage stage, const Event* events, size_t count, int64_t timestampNs) {
+    size_t runStart = 0;
+    for (size_t i = 1; i <= count; i++) {
+        if (i < count && events[i].sensorHandle == events[runStart].sensorHandle &&
+            i - runStart < UINT16_MAX) {
+            continue;
+        }
+        int32_t sensorHandle = events[runStart].sensorHandle;
+        recordOne(stage, sensorHandle, static_cast<uint8_t>(extractSubHalIndex(sensorHandle)),
+                  static_cast<uint16_t>(i - runStart), timestampNs);
+        runStart = i;
+    }
+}
+
+void EventTrace::recordWakelockAck(uint32_t count, int64_t timestampNs) {
+    recordOne(Stage::WAKELOCK_ACK, -1, UINT8_MAX,
+              static_cast<uint16_t>(std::min<uint32_t>(count, UINT16_MAX)), timestampNs);
+}
+
+void EventTrace::recordOne(Stage stage, int32_t sensorHandle, uint8_t subHalIndex,
+                           uint16_t count, int64_t timestampNs) {
+    uint64_t pos = mNextPos.fetch_add(1, std::memory_order_relaxed);
+    Slot& slot = mSlots[pos % kCapacity];
+    slot.seq.store(2 * pos + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.timestampNs.store(timestampNs, std::memory_order_relaxed);
+    slot.packed.store(static_cast<uint64_t>(static_cast<uint32_t>(sensorHandle)) |
+                              static_cast<uint64_t>(count) << 32 |
+                              static_cast<uint64_t>(subHalIndex) << 48 |
+                              static_cast<uint64_t>(stage) << 56,
+                      std::memory_order_relaxed);
+    slot.seq.store(2 * (pos + 1), std::memory_order_release);
+}
+
+void EventTrace::dump(int fd) const {
+    uint64_t end = mNextPos.load(std::memory_order_acquire);
+    uint64_t begin = end > kCapacity ? end - kCapacity : 0;
+
+    std::vector<Record> records;
+    records.reserve(end - begin);
+    for (uint64_t pos = begin; pos < end; pos++) {
+        const Slot& slot = mSlots[pos % kCapacity];
+        uint64_t seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * (pos + 1)) continue;
+        int64_t timestampNs = slot.timestampNs.load(std::memory_order_relaxed);
+        uint64_t packed = slot.packed.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq) continue;
+        records.push_back({timestampNs, static_cast<int32_t>(packed & 0xffffffff),
+                           static_cast<uint16_t>(packed >> 32), static_cast<uint8_t>(packed >> 48),
+                           static_cast<uint8_t>(packed >> 56)});
+    }
+
+    Header header = {kMagic, kVersion, sizeof(Record), static_cast<uint32_t>(records.size()),
+                     static_cast<uint32_t>(end - records.size())};
+    android::base::WriteFully(fd, &header, sizeof(header));
+    android::base::WriteFully(fd, records.data(), sizeof(Record) * records.size());
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
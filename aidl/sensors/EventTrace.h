@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/2.1/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Fixed size ring of the most recent points events passed through in the proxy. Recording is a
+ * fetch_add and a handful of relaxed stores, so it stays on in production builds.
+ *
+ * dump() writes a little endian file that can be decoded offline:
+ *
+ *   struct Header {          // 16 bytes
+ *       uint32_t magic;      // kMagic, "SNTR"
+ *       uint16_t version;    // kVersion
+ *       uint16_t recordSize; // sizeof(Record)
+ *       uint32_t numRecords;
+ *       uint32_t numLost;    // records overwritten or skipped since startup
+ *   };
+ *   struct Record {          // 16 bytes, oldest first
+ *       int64_t timestampNs; // CLOCK_BOOTTIME
+ *       int32_t sensorHandle;// -1 for WAKELOCK_ACK
+ *       uint16_t count;      // events or acks this record covers
+ *       uint8_t subHalIndex; // 0xff for WAKELOCK_ACK
+ *       uint8_t stage;       // Stage
+ *   };
+ */
+class EventTrace {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+
+    enum class Stage : uint8_t {
+        //! A sub-HAL handed the events to the proxy.
+        CALLBACK = 0,
+        //! The events were written to the event FMQ.
+        FMQ_WRITE = 1,
+        //! The events were queued for the pending writes thread.
+        PENDING_ENQUEUE = 2,
+        //! The framework acknowledged wake-up events.
+        WAKELOCK_ACK = 3,
+    };
+
+    static constexpr uint32_t kMagic = 0x52544e53;  // "SNTR"
+    static constexpr uint16_t kVersion = 1;
+    static constexpr size_t kCapacity = 1 << 12;
+
+    /**
+     * Record every event of a batch, one record per run of consecutive events with the same
+     * sensor handle.
+     */
+    void record(Stage stage, const Event* events, size_t count, int64_t timestampNs);
+
+    void recordWakelockAck(uint32_t count, int64_t timestampNs);
+
+    /**
+     * Write the header and the records currently in the ring to fd. Records being written
+     * concurrently are skipped.
+     */
+    void dump(int fd) const;
+
+  private:
+    //! A seqlock guarded record: seq is odd while the slot is written and 2 * (pos + 1) after.
+    struct Slot {
+        std::atomic<uint64_t> seq = 0;
+        std::atomic<int64_t> timestampNs = 0;
+        std::atomic<uint64_t> packed = 0;
+    };
+
+    void recordOne(Stage stage, int32_t sensorHandle, uint8_t subHalIndex, uint16_t count,
+                   int64_t timestampNs);
+
+    Slot mSlots[kCapacity];
+    alignas(64) std::atomic<uint64_t> mNextPos = 0;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
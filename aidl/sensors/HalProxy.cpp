@@ -19,10 +19,14 @@
 #include <android/hardware/sensors/2.0/types.h>
 
 #include <android-base/file.h>
+#include <android-base/properties.h>
 #include "hardware_legacy/power.h"
 
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <cmath>
 #include <fstream>
@@ -44,29 +48,41 @@ using ::android::hardware::sensors::V2_0::implementation::kWakelockTimeoutNs;
 typedef V2_0::implementation::ISensorsSubHal*(SensorsHalGetSubHalFunc)(uint32_t*);
 typedef V2_1::implementation::ISensorsSubHal*(SensorsHalGetSubHalV2_1Func)(uint32_t*);
 
-static constexpr int32_t kBitsAfterSubHalIndex = 24;
+static constexpr char kSensorListCacheProperty[] = "ro.vendor.sensors.xiaomi.sensor_list_cache";
+static constexpr char kWakelockHysteresisProperty[] =
+        "ro.vendor.sensors.xiaomi.wakelock_hysteresis_ms";
+static constexpr char kWakelockMaxHoldProperty[] = "ro.vendor.sensors.xiaomi.wakelock_max_hold_ms";
+static constexpr char kPendingWriteOverflowProperty[] =
+        "ro.vendor.sensors.xiaomi.pending_write_overflow";
+static constexpr char kPendingWriteBlockProperty[] =
+        "ro.vendor.sensors.xiaomi.pending_write_block_ms";
+static constexpr char kBatchingEmulationProperty[] =
+        "ro.vendor.sensors.xiaomi.batching_emulation";
+static constexpr char kParallelSubHalInitProperty[] =
+        "ro.vendor.sensors.xiaomi.parallel_subhal_init";
+static constexpr char kSensorListCachePath[] = "/data/vendor/sensors/multihal_sensor_list.bin";
 
 /**
- * Set the subhal index as first byte of sensor handle and return this modified version.
- *
- * @param sensorHandle The sensor handle to modify.
- * @param subHalIndex The index in the hal proxy of the sub hal this sensor belongs to.
- *
- * @return The modified sensor handle.
+ * Run fn(i) for every i in [0, count) over up to numThreads threads, including the calling one,
+ * and return once all of them are done.
  */
-int32_t setSubHalIndex(int32_t sensorHandle, size_t subHalIndex) {
-    return sensorHandle | (static_cast<int32_t>(subHalIndex) << kBitsAfterSubHalIndex);
-}
+static void forEachInParallel(size_t count, size_t numThreads,
+                              const std::function<void(size_t)>& fn) {
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            fn(i);
+        }
+    };
 
-/**
- * Extract the subHalIndex from sensorHandle.
- *
- * @param sensorHandle The sensorHandle to extract from.
- *
- * @return The subhal index.
- */
-size_t extractSubHalIndex(int32_t sensorHandle) {
-    return static_cast<size_t>(sensorHandle >> kBitsAfterSubHalIndex);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min(count, numThreads); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
 }
 
 /**
@@ -101,16 +117,57 @@ bool patchXiaomiPickupSensor(V2_1::SensorInfo& sensor) {
     return true;
 }
 
-HalProxy::HalProxy() {
+HalProxy::Options HalProxy::readOptions() {
+    Options options;
+    options.wakelockHysteresisNs =
+            android::base::GetIntProperty<int64_t>(kWakelockHysteresisProperty, 0, 0, 1000) *
+            1000000;
+    options.wakelockMaxHoldNs =
+            android::base::GetIntProperty<int64_t>(kWakelockMaxHoldProperty, 1000, 0, INT32_MAX) *
+            1000000;
+
+    std::string overflowPolicy =
+            android::base::GetProperty(kPendingWriteOverflowProperty, "drop_newest");
+    if (overflowPolicy == "drop_oldest") {
+        options.overflowPolicy = OverflowPolicy::DROP_OLDEST;
+    } else if (overflowPolicy == "decimate") {
+        options.overflowPolicy = OverflowPolicy::DECIMATE;
+    } else if (overflowPolicy == "block") {
+        options.overflowPolicy = OverflowPolicy::BLOCK;
+    } else if (overflowPolicy != "drop_newest") {
+        ALOGE("Unknown pending write overflow policy: %s", overflowPolicy.c_str());
+    }
+    options.overflowBlockTimeoutNs =
+            android::base::GetIntProperty<int64_t>(kPendingWriteBlockProperty, 20, 0, 1000) *
+            1000000;
+    options.emulateBatching = android::base::GetBoolProperty(kBatchingEmulationProperty, true);
+    options.parallelSubHalInit =
+            android::base::GetBoolProperty(kParallelSubHalInitProperty, true);
+    return options;
+}
+
+HalProxy::HalProxy() : mOptions(readOptions()) {
     static const std::string kMultiHalConfigFiles[] = {"/vendor/etc/sensors/hals.conf",
                                                        "/odm/etc/sensors/hals.conf"};
+    std::vector<std::string> libraries;
     for (const std::string& configFile : kMultiHalConfigFiles) {
-        initializeSubHalListFromConfigFile(configFile.c_str());
+        readSubHalLibrariesFromConfigFile(configFile.c_str(), &libraries);
+    }
+
+    if (!android::base::GetBoolProperty(kSensorListCacheProperty, true)) {
+        initializeSubHals(libraries, std::nullopt);
+        return;
+    }
+
+    uint64_t cacheKey = computeSensorListCacheKey(libraries);
+    if (readSensorListCache(kSensorListCachePath, cacheKey, &mCachedSensorList)) {
+        startSubHalInitThread(libraries, cacheKey);
+    } else {
+        initializeSubHals(libraries, cacheKey);
     }
-    init();
 }
 
-HalProxy::HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList) {
+HalProxy::HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList) : mOptions(readOptions()) {
     for (ISensorsSubHalV2_0* subHal : subHalList) {
         mSubHalList.push_back(std::make_unique<SubHalWrapperV2_0>(subHal));
     }
@@ -119,7 +176,8 @@ HalProxy::HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList) {
 }
 
 HalProxy::HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList,
-                   std::vector<ISensorsSubHalV2_1*>& subHalListV2_1) {
+                   std::vector<ISensorsSubHalV2_1*>& subHalListV2_1, const Options& options)
+    : mOptions(options) {
     for (ISensorsSubHalV2_0* subHal : subHalList) {
         mSubHalList.push_back(std::make_unique<SubHalWrapperV2_0>(subHal));
     }
@@ -131,14 +189,30 @@ HalProxy::HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList,
     init();
 }
 
+HalProxy::HalProxy(const std::vector<std::string>& libraries, const Options& options,
+                   std::vector<SensorInfo> cachedSensorList)
+    : mOptions(options) {
+    if (cachedSensorList.empty()) {
+        initializeSubHals(libraries, std::nullopt);
+    } else {
+        mCachedSensorList = std::move(cachedSensorList);
+        startSubHalInitThread(libraries, std::nullopt);
+    }
+}
+
 HalProxy::~HalProxy() {
+    if (mSubHalInitThread.joinable()) {
+        mSubHalInitThread.join();
+    }
     stopThreads();
 }
 
 Return<void> HalProxy::getSensorsList_2_1(ISensorsV2_1::getSensorsList_2_1_cb _hidl_cb) {
     std::vector<V2_1::SensorInfo> sensors;
-    for (const auto& iter : mSensors) {
-        sensors.push_back(iter.second);
+    if (!getCachedSensorListWhileLoading(&sensors)) {
+        for (const auto& iter : mSensors) {
+            sensors.push_back(iter.second);
+        }
     }
     _hidl_cb(sensors);
     return Void();
@@ -146,16 +220,25 @@ Return<void> HalProxy::getSensorsList_2_1(ISensorsV2_1::getSensorsList_2_1_cb _h
 
 Return<void> HalProxy::getSensorsList(ISensorsV2_0::getSensorsList_cb _hidl_cb) {
     std::vector<V1_0::SensorInfo> sensors;
-    for (const auto& iter : mSensors) {
-      if (iter.second.type != SensorType::HINGE_ANGLE) {
-        sensors.push_back(convertToOldSensorInfo(iter.second));
-      }
+    auto addSensor = [&](const V2_1::SensorInfo& sensor) {
+        if (sensor.type != SensorType::HINGE_ANGLE) {
+            sensors.push_back(convertToOldSensorInfo(sensor));
+        }
+    };
+    std::vector<V2_1::SensorInfo> cachedSensors;
+    if (getCachedSensorListWhileLoading(&cachedSensors)) {
+        std::for_each(cachedSensors.begin(), cachedSensors.end(), addSensor);
+    } else {
+        for (const auto& iter : mSensors) {
+            addSensor(iter.second);
+        }
     }
     _hidl_cb(sensors);
     return Void();
 }
 
 Return<Result> HalProxy::setOperationMode(OperationMode mode) {
+    waitForSubHals();
     Result result = Result::OK;
     size_t subHalIndex;
     for (subHalIndex = 0; subHalIndex < mSubHalList.size(); subHalIndex++) {
@@ -179,11 +262,24 @@ Return<Result> HalProxy::setOperationMode(OperationMode mode) {
 }
 
 Return<Result> HalProxy::activate(int32_t sensorHandle, bool enabled) {
+    waitForSubHals();
     if (!isSubHalIndexValid(sensorHandle)) {
         return Result::BAD_VALUE;
     }
-    return getSubHalForSensorHandle(sensorHandle)
-            ->activate(clearSubHalIndex(sensorHandle), enabled);
+    if (enabled) {
+        SensorTable::ReadGuard guard;
+        const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+        SensorTable::RateLimit* rateLimit = table->findRateLimit(sensorHandle);
+        if (rateLimit != nullptr) {
+            rateLimit->lastTimestampNs.store(INT64_MIN, std::memory_order_relaxed);
+        }
+    }
+    Result result = getSubHalForSensorHandle(sensorHandle)
+                            ->activate(clearSubHalIndex(sensorHandle), enabled);
+    if (!enabled && mBatchingEmulatedSensors.count(sensorHandle) > 0) {
+        mEventBatcher.flushSensor(sensorHandle, mBatchedEventsSink);
+    }
+    return result;
 }
 
 Return<Result> HalProxy::initialize_2_1(
@@ -235,6 +331,7 @@ Return<Result> HalProxy::initializeCommon(
         std::unique_ptr<WakeLockMessageQueueWrapperBase>& wakeLockQueue,
         const sp<ISensorsCallbackWrapperBase>& sensorsCallback) {
     Result result = Result::OK;
+    waitForSubHals();
 
     stopThreads();
     resetSharedWakelock();
@@ -244,11 +341,16 @@ Return<Result> HalProxy::initializeCommon(
     disableAllSensors();
 
     // Clears the queue if any events were pending write before.
-    mPendingWriteEventsQueue = std::queue<std::pair<std::vector<V2_1::Event>, size_t>>();
-    mSizePendingWriteEventsQueue = 0;
+    mPendingWakeEventsQueue.clear();
+    mPendingWriteEventsQueue.clear();
+    mEventBatcher.clear();
 
     // Clears previously connected dynamic sensors
-    mDynamicSensors.clear();
+    {
+        std::lock_guard<std::mutex> lock(mDynamicSensorsMutex);
+        mDynamicSensors.clear();
+        publishSensorTable();
+    }
 
     mDynamicSensorsCallback = sensorsCallback;
 
@@ -281,7 +383,7 @@ Return<Result> HalProxy::initializeCommon(
     mWakelockThread = std::thread(startWakelockThread, this);
 
     for (size_t i = 0; i < mSubHalList.size(); i++) {
-        Result currRes = mSubHalList[i]->initialize(this, this, i);
+        Result currRes = mSubHalList[i]->initialize(this, mSubHalWakelockRefCounters[i].get(), i);
         if (currRes != Result::OK) {
             result = currRes;
             ALOGE("Subhal '%s' failed to initialize with reason %" PRId32 ".",
@@ -291,19 +393,37 @@ Return<Result> HalProxy::initializeCommon(
 
     mCurrentOperationMode = OperationMode::NORMAL;
 
+    announceSensorListChanges();
+
     return result;
 }
 
 Return<Result> HalProxy::batch(int32_t sensorHandle, int64_t samplingPeriodNs,
                                int64_t maxReportLatencyNs) {
+    waitForSubHals();
     if (!isSubHalIndexValid(sensorHandle)) {
         return Result::BAD_VALUE;
     }
-    return getSubHalForSensorHandle(sensorHandle)
-            ->batch(clearSubHalIndex(sensorHandle), samplingPeriodNs, maxReportLatencyNs);
+    Result result = getSubHalForSensorHandle(sensorHandle)
+                            ->batch(clearSubHalIndex(sensorHandle), samplingPeriodNs,
+                                    maxReportLatencyNs);
+    if (result == Result::OK) {
+        // Under mDynamicSensorsMutex so a table being replaced cannot miss the new period.
+        std::lock_guard<std::mutex> lock(mDynamicSensorsMutex);
+        SensorTable::RateLimit* rateLimit =
+                mSensorTable.load(std::memory_order_acquire)->findRateLimit(sensorHandle);
+        if (rateLimit != nullptr) {
+            rateLimit->samplingPeriodNs.store(samplingPeriodNs, std::memory_order_relaxed);
+        }
+    }
+    if (result == Result::OK && mBatchingEmulatedSensors.count(sensorHandle) > 0) {
+        mEventBatcher.setReportLatency(sensorHandle, maxReportLatencyNs, mBatchedEventsSink);
+    }
+    return result;
 }
 
 Return<Result> HalProxy::flush(int32_t sensorHandle) {
+    waitForSubHals();
     if (!isSubHalIndexValid(sensorHandle)) {
         return Result::BAD_VALUE;
     }
@@ -315,6 +435,7 @@ Return<Result> HalProxy::injectSensorData_2_1(const V2_1::Event& event) {
 }
 
 Return<Result> HalProxy::injectSensorData(const V1_0::Event& event) {
+    waitForSubHals();
     Result result = Result::OK;
     if (mCurrentOperationMode == OperationMode::NORMAL &&
         event.sensorType != V1_0::SensorType::ADDITIONAL_INFO) {
@@ -336,6 +457,7 @@ Return<Result> HalProxy::injectSensorData(const V1_0::Event& event) {
 
 Return<void> HalProxy::registerDirectChannel(const SharedMemInfo& mem,
                                              ISensorsV2_0::registerDirectChannel_cb _hidl_cb) {
+    waitForSubHals();
     if (mDirectChannelSubHal == nullptr) {
         _hidl_cb(Result::INVALID_OPERATION, -1 /* channelHandle */);
     } else {
@@ -345,6 +467,7 @@ Return<void> HalProxy::registerDirectChannel(const SharedMemInfo& mem,
 }
 
 Return<Result> HalProxy::unregisterDirectChannel(int32_t channelHandle) {
+    waitForSubHals();
     Result result;
     if (mDirectChannelSubHal == nullptr) {
         result = Result::INVALID_OPERATION;
@@ -357,6 +480,7 @@ Return<Result> HalProxy::unregisterDirectChannel(int32_t channelHandle) {
 Return<void> HalProxy::configDirectReport(int32_t sensorHandle, int32_t channelHandle,
                                           RateLevel rate,
                                           ISensorsV2_0::configDirectReport_cb _hidl_cb) {
+    waitForSubHals();
     if (mDirectChannelSubHal == nullptr) {
         _hidl_cb(Result::INVALID_OPERATION, -1 /* reportToken */);
     } else if (sensorHandle == -1 && rate != RateLevel::STOP) {
@@ -378,6 +502,13 @@ Return<void> HalProxy::debug(const hidl_handle& fd, const hidl_vec<hidl_string>&
     }
 
     int writeFd = fd->data[0];
+    for (const hidl_string& arg : args) {
+        if (arg == "--trace") {
+            mEventTrace.dump(writeFd);
+            return Return<void>();
+        }
+    }
+    waitForSubHals();
 
     std::ostringstream stream;
     stream << "===HalProxy===" << std::endl;
@@ -388,21 +519,62 @@ Return<void> HalProxy::debug(const hidl_handle& fd, const hidl_vec<hidl_string>&
            << " ms ago" << std::endl;
     stream << "  Wakelock timeout reset time: " << msFromNs(now - mWakelockTimeoutResetTime)
            << " ms ago" << std::endl;
-    // TODO(b/142969448): Add logging for history of wakelock acquisition per subhal.
     stream << "  Wakelock ref count: " << mWakelockRefCount << std::endl;
-    stream << "  # of events on pending write writes queue: " << mSizePendingWriteEventsQueue
+    double statsSeconds = std::max<int64_t>(now - mWakelockStatsStartTime, 1) / 1e9;
+    uint64_t numAcquires = mNumWakelockAcquires.load(std::memory_order_relaxed);
+    uint64_t numReleases = mNumWakelockReleases.load(std::memory_order_relaxed);
+    stream << "  Wakelock acquisitions: " << numAcquires << " (" << numAcquires / statsSeconds
+           << "/s)" << std::endl;
+    stream << "  Wakelock releases: " << numReleases << " (" << numReleases / statsSeconds
+           << "/s)" << std::endl;
+    stream << "  Wakelock acquisitions coalesced: "
+           << mNumWakelockCoalesced.load(std::memory_order_relaxed) << " (hysteresis "
+           << msFromNs(mOptions.wakelockHysteresisNs) << " ms, max hold "
+           << msFromNs(mOptions.wakelockMaxHoldNs) << " ms)" << std::endl;
+    stream << "  # of events on pending write writes queue: " << mPendingWriteEventsQueue.size()
+           << std::endl;
+    stream << "  # of events on pending wake-up writes queue: " << mPendingWakeEventsQueue.size()
            << std::endl;
     stream << " Most events seen on pending write events queue: "
-           << mMostEventsObservedPendingWriteEventsQueue << std::endl;
-    if (!mPendingWriteEventsQueue.empty()) {
-        stream << "  Size of events list on front of pending writes queue: "
-               << mPendingWriteEventsQueue.front().first.size() << std::endl;
-    }
+           << mMostEventsObservedPendingWriteEventsQueue.load() << std::endl;
+    stream << "  # of batches written directly to the event queue: " << mNumFastPathWrites.load()
+           << std::endl;
+    stream << "  # of batches handed to the pending writes thread: " << mNumSlowPathWrites.load()
+           << std::endl;
     stream << "  # of non-dynamic sensors across all subhals: " << mSensors.size() << std::endl;
     stream << "  # of dynamic sensors across all subhals: " << mDynamicSensors.size() << std::endl;
+    stream << "  # of sensors with emulated batching: " << mBatchingEmulatedSensors.size()
+           << std::endl;
+    stream << "SubHal libraries (" << mSubHalLibraries.size() << "):" << std::endl;
+    for (const SubHalLibrary& library : mSubHalLibraries) {
+        stream << "  " << library.name << ": " << (library.loaded ? "loaded" : "failed") << " in "
+               << library.loadTimeNs / 1000 << " us" << std::endl;
+    }
+    static const char* const kOverflowPolicyNames[] = {"drop_newest", "drop_oldest", "decimate",
+                                                       "block"};
+    stream << "Pending write overflow policy: "
+           << kOverflowPolicyNames[static_cast<size_t>(mOptions.overflowPolicy)] << std::endl;
+    {
+        SensorTable::ReadGuard guard;
+        const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+        std::ostringstream droppedStream;
+        size_t numSensorsWithDrops = 0;
+        for (size_t i = 0; i < table->size(); i++) {
+            uint64_t count = table->rateLimitAt(i).eventsDropped.load(std::memory_order_relaxed);
+            if (count == 0) continue;
+            const SensorInfo& sensor = table->sensorAt(i);
+            droppedStream << "  " << sensor.name << " (handle 0x" << std::hex
+                          << sensor.sensorHandle << std::dec << "): " << count << std::endl;
+            numSensorsWithDrops++;
+        }
+        stream << "Dropped events per sensor (" << numSensorsWithDrops << "):" << std::endl
+               << droppedStream.str();
+    }
     stream << "SubHals (" << mSubHalList.size() << "):" << std::endl;
-    for (auto& subHal : mSubHalList) {
+    for (size_t i = 0; i < mSubHalList.size(); i++) {
+        const std::shared_ptr<ISubHalWrapperBase>& subHal = mSubHalList[i];
         stream << "  Name: " << subHal->getName() << std::endl;
+        mSubHalStats[i].dump(stream);
         stream << "  Debug dump: " << std::endl;
         android::base::WriteStringToFd(stream.str(), writeFd);
         subHal->debug(fd, args);
@@ -428,6 +600,7 @@ Return<void> HalProxy::onDynamicSensorsConnected(const hidl_vec<SensorInfo>& dyn
                 sensors.push_back(sensor);
             }
         }
+        publishSensorTable();
     }
     mDynamicSensorsCallback->onDynamicSensorsConnected(sensors);
     return Return<void>();
@@ -450,86 +623,226 @@ Return<void> HalProxy::onDynamicSensorsDisconnected(
                 }
             }
         }
+        publishSensorTable();
     }
     mDynamicSensorsCallback->onDynamicSensorsDisconnected(sensorHandles);
     return Return<void>();
 }
 
-void HalProxy::initializeSubHalListFromConfigFile(const char* configFileName) {
+void HalProxy::readSubHalLibrariesFromConfigFile(const char* configFileName,
+                                                 std::vector<std::string>* libraries) {
     std::ifstream subHalConfigStream(configFileName);
     if (!subHalConfigStream) {
         ALOGE("Failed to load subHal config file: %s", configFileName);
     } else {
         std::string subHalLibraryFile;
         while (subHalConfigStream >> subHalLibraryFile) {
-            void* handle = getHandleForSubHalSharedObject(subHalLibraryFile);
-            if (handle == nullptr) {
-                ALOGE("dlopen failed for library: %s", subHalLibraryFile.c_str());
-            } else {
-                SensorsHalGetSubHalFunc* sensorsHalGetSubHalPtr =
-                        (SensorsHalGetSubHalFunc*)dlsym(handle, "sensorsHalGetSubHal");
-                if (sensorsHalGetSubHalPtr != nullptr) {
-                    std::function<SensorsHalGetSubHalFunc> sensorsHalGetSubHal =
-                            *sensorsHalGetSubHalPtr;
-                    uint32_t version;
-                    ISensorsSubHalV2_0* subHal = sensorsHalGetSubHal(&version);
-                    if (version != SUB_HAL_2_0_VERSION) {
-                        ALOGE("SubHal version was not 2.0 for library: %s",
-                              subHalLibraryFile.c_str());
-                    } else {
-                        ALOGV("Loaded SubHal from library: %s", subHalLibraryFile.c_str());
-                        mSubHalList.push_back(std::make_unique<SubHalWrapperV2_0>(subHal));
-                    }
-                } else {
-                    SensorsHalGetSubHalV2_1Func* getSubHalV2_1Ptr =
-                            (SensorsHalGetSubHalV2_1Func*)dlsym(handle, "sensorsHalGetSubHal_2_1");
-
-                    if (getSubHalV2_1Ptr == nullptr) {
-                        ALOGE("Failed to locate sensorsHalGetSubHal function for library: %s",
-                              subHalLibraryFile.c_str());
-                    } else {
-                        std::function<SensorsHalGetSubHalV2_1Func> sensorsHalGetSubHal_2_1 =
-                                *getSubHalV2_1Ptr;
-                        uint32_t version;
-                        ISensorsSubHalV2_1* subHal = sensorsHalGetSubHal_2_1(&version);
-                        if (version != SUB_HAL_2_1_VERSION) {
-                            ALOGE("SubHal version was not 2.1 for library: %s",
-                                  subHalLibraryFile.c_str());
-                        } else {
-                            ALOGV("Loaded SubHal from library: %s", subHalLibraryFile.c_str());
-                            mSubHalList.push_back(std::make_unique<SubHalWrapperV2_1>(subHal));
-                        }
-                    }
-                }
-            }
+            libraries->push_back(subHalLibraryFile);
         }
     }
 }
 
+std::shared_ptr<ISubHalWrapperBase> HalProxy::loadSubHal(const std::string& subHalLibraryFile) {
+    void* handle = getHandleForSubHalSharedObject(subHalLibraryFile);
+    if (handle == nullptr) {
+        ALOGE("dlopen failed for library: %s", subHalLibraryFile.c_str());
+        return nullptr;
+    }
+
+    SensorsHalGetSubHalFunc* sensorsHalGetSubHalPtr =
+            (SensorsHalGetSubHalFunc*)dlsym(handle, "sensorsHalGetSubHal");
+    if (sensorsHalGetSubHalPtr != nullptr) {
+        std::function<SensorsHalGetSubHalFunc> sensorsHalGetSubHal = *sensorsHalGetSubHalPtr;
+        uint32_t version;
+        ISensorsSubHalV2_0* subHal = sensorsHalGetSubHal(&version);
+        if (version != SUB_HAL_2_0_VERSION) {
+            ALOGE("SubHal version was not 2.0 for library: %s", subHalLibraryFile.c_str());
+            return nullptr;
+        }
+        ALOGV("Loaded SubHal from library: %s", subHalLibraryFile.c_str());
+        return std::make_shared<SubHalWrapperV2_0>(subHal);
+    }
+
+    SensorsHalGetSubHalV2_1Func* getSubHalV2_1Ptr =
+            (SensorsHalGetSubHalV2_1Func*)dlsym(handle, "sensorsHalGetSubHal_2_1");
+    if (getSubHalV2_1Ptr == nullptr) {
+        ALOGE("Failed to locate sensorsHalGetSubHal function for library: %s",
+              subHalLibraryFile.c_str());
+        return nullptr;
+    }
+    std::function<SensorsHalGetSubHalV2_1Func> sensorsHalGetSubHal_2_1 = *getSubHalV2_1Ptr;
+    uint32_t version;
+    ISensorsSubHalV2_1* subHal = sensorsHalGetSubHal_2_1(&version);
+    if (version != SUB_HAL_2_1_VERSION) {
+        ALOGE("SubHal version was not 2.1 for library: %s", subHalLibraryFile.c_str());
+        return nullptr;
+    }
+    ALOGV("Loaded SubHal from library: %s", subHalLibraryFile.c_str());
+    return std::make_shared<SubHalWrapperV2_1>(subHal);
+}
+
+size_t HalProxy::getNumSubHalInitThreads() const {
+    return mOptions.parallelSubHalInit ? kMaxSubHalInitThreads : 1;
+}
+
+void HalProxy::initializeSubHalList(const std::vector<std::string>& libraries) {
+    std::vector<std::shared_ptr<ISubHalWrapperBase>> subHals(libraries.size());
+    mSubHalLibraries.resize(libraries.size());
+    forEachInParallel(libraries.size(), getNumSubHalInitThreads(), [&](size_t i) {
+        int64_t startTime = getTimeNow();
+        subHals[i] = loadSubHal(libraries[i]);
+        mSubHalLibraries[i] = {libraries[i], getTimeNow() - startTime, subHals[i] != nullptr};
+    });
+
+    // Keep the config file order so sub-HAL indexes, and with them sensor handles, are stable
+    // no matter which library finished loading first.
+    for (std::shared_ptr<ISubHalWrapperBase>& subHal : subHals) {
+        if (subHal != nullptr) {
+            mSubHalList.push_back(std::move(subHal));
+        }
+    }
+}
+
+void HalProxy::initializeSubHals(const std::vector<std::string>& libraries,
+                                 std::optional<uint64_t> cacheKey) {
+    initializeSubHalList(libraries);
+    init();
+
+    bool cacheMatches =
+            mCachedSensorList.size() == mSensors.size() &&
+            std::equal(mCachedSensorList.begin(), mCachedSensorList.end(), mSensors.begin(),
+                       [](const SensorInfo& cached, const auto& iter) {
+                           return cached == iter.second;
+                       });
+    if (cacheKey.has_value() && !cacheMatches) {
+        if (!mCachedSensorList.empty()) {
+            ALOGE("Cached sensor list did not match the sub-HALs, rewriting it");
+        }
+        writeSensorListCache(kSensorListCachePath, *cacheKey, mSensors);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mSubHalsReadyMutex);
+        if (mCachedSensorListServed && !cacheMatches) {
+            // A client already holds handles from the stale list, tell it what changed as
+            // dynamic sensor updates once it initializes.
+            ALOGW("Served a stale cached sensor list, announcing the differences");
+            diffCachedSensorList();
+        }
+        mSubHalsReady.store(true, std::memory_order_release);
+    }
+    mSubHalsReadyCV.notify_all();
+}
+
+void HalProxy::startSubHalInitThread(const std::vector<std::string>& libraries,
+                                     std::optional<uint64_t> cacheKey) {
+    // Answer getSensorsList from the cache right away and load the sub-HALs in the background,
+    // every other entry point waits for them.
+    mSubHalsReady = false;
+    mSubHalInitThread =
+            std::thread([this, libraries, cacheKey] { initializeSubHals(libraries, cacheKey); });
+}
+
+void HalProxy::diffCachedSensorList() {
+    std::map<int32_t, SensorInfo> cachedSensors;
+    for (const SensorInfo& sensor : mCachedSensorList) {
+        cachedSensors[sensor.sensorHandle] = sensor;
+    }
+    for (const auto& [sensorHandle, sensor] : cachedSensors) {
+        auto iter = mSensors.find(sensorHandle);
+        if (iter == mSensors.end() || !(iter->second == sensor)) {
+            mSensorsRemovedFromCachedList.push_back(sensorHandle);
+        }
+    }
+    for (const auto& [sensorHandle, sensor] : mSensors) {
+        auto iter = cachedSensors.find(sensorHandle);
+        if (iter == cachedSensors.end() || !(iter->second == sensor)) {
+            mSensorsAddedToCachedList.push_back(sensor);
+        }
+    }
+}
+
+void HalProxy::announceSensorListChanges() {
+    if (mDynamicSensorsCallback == nullptr) {
+        return;
+    }
+    // A sensor that changed is removed first and then added back with its new description.
+    if (!mSensorsRemovedFromCachedList.empty()) {
+        mDynamicSensorsCallback->onDynamicSensorsDisconnected(mSensorsRemovedFromCachedList);
+        mSensorsRemovedFromCachedList.clear();
+    }
+    if (!mSensorsAddedToCachedList.empty()) {
+        mDynamicSensorsCallback->onDynamicSensorsConnected(mSensorsAddedToCachedList);
+        mSensorsAddedToCachedList.clear();
+    }
+}
+
+bool HalProxy::getCachedSensorListWhileLoading(std::vector<SensorInfo>* sensors) {
+    std::lock_guard<std::mutex> lock(mSubHalsReadyMutex);
+    if (mSubHalsReady.load(std::memory_order_acquire)) {
+        return false;
+    }
+    mCachedSensorListServed = true;
+    *sensors = mCachedSensorList;
+    return true;
+}
+
+void HalProxy::waitForSubHals() {
+    if (mSubHalsReady.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mSubHalsReadyMutex);
+    mSubHalsReadyCV.wait(lock, [this] { return mSubHalsReady.load(std::memory_order_acquire); });
+}
+
 void HalProxy::initializeSensorList() {
-    for (size_t subHalIndex = 0; subHalIndex < mSubHalList.size(); subHalIndex++) {
+    std::vector<std::vector<SensorInfo>> sensorLists(mSubHalList.size());
+    forEachInParallel(mSubHalList.size(), getNumSubHalInitThreads(), [&](size_t subHalIndex) {
         auto result = mSubHalList[subHalIndex]->getSensorsList([&](const auto& list) {
-            for (SensorInfo sensor : list) {
-                if (!subHalIndexIsClear(sensor.sensorHandle)) {
-                    ALOGE("SubHal sensorHandle's first byte was not 0");
-                } else {
-                    ALOGV("Loaded sensor: %s", sensor.name.c_str());
-                    sensor.sensorHandle = setSubHalIndex(sensor.sensorHandle, subHalIndex);
-                    setDirectChannelFlags(&sensor, mSubHalList[subHalIndex]);
-                    bool keep = patchXiaomiPickupSensor(sensor);
-                    if (!keep) {
-                        continue;
-                    }
-
-                    mSensors[sensor.sensorHandle] = sensor;
-                }
-            }
+            sensorLists[subHalIndex].assign(list.begin(), list.end());
         });
         if (!result.isOk()) {
             ALOGE("getSensorsList call failed for SubHal: %s",
                   mSubHalList[subHalIndex]->getName().c_str());
         }
+    });
+
+    // setDirectChannelFlags picks the first sub-HAL with direct channel support, so the lists
+    // are merged sequentially in sub-HAL order.
+    for (size_t subHalIndex = 0; subHalIndex < mSubHalList.size(); subHalIndex++) {
+        for (SensorInfo& sensor : sensorLists[subHalIndex]) {
+            if (!subHalIndexIsClear(sensor.sensorHandle)) {
+                ALOGE("SubHal sensorHandle's first byte was not 0");
+            } else {
+                ALOGV("Loaded sensor: %s", sensor.name.c_str());
+                sensor.sensorHandle = setSubHalIndex(sensor.sensorHandle, subHalIndex);
+                setDirectChannelFlags(&sensor, mSubHalList[subHalIndex]);
+                bool keep = patchXiaomiPickupSensor(sensor);
+                if (!keep) {
+                    continue;
+                }
+
+                // Let the framework batch non-wake-up sensors without a FIFO, the proxy holds
+                // their events back instead.
+                uint32_t reportingMode =
+                        sensor.flags &
+                        static_cast<uint32_t>(V1_0::SensorFlagBits::MASK_REPORTING_MODE);
+                if (mOptions.emulateBatching && sensor.fifoMaxEventCount == 0 &&
+                    (sensor.flags & V1_0::SensorFlagBits::WAKE_UP) == 0 &&
+                    (reportingMode ==
+                             static_cast<uint32_t>(V1_0::SensorFlagBits::CONTINUOUS_MODE) ||
+                     reportingMode ==
+                             static_cast<uint32_t>(V1_0::SensorFlagBits::ON_CHANGE_MODE))) {
+                    sensor.fifoReservedEventCount = EventBatcher::kMaxBatchSize;
+                    sensor.fifoMaxEventCount = EventBatcher::kMaxBatchSize;
+                    mBatchingEmulatedSensors.insert(sensor.sensorHandle);
+                }
+
+                mSensors[sensor.sensorHandle] = sensor;
+            }
+        }
     }
+    mEventBatcher.setSensors(mBatchingEmulatedSensors);
 }
 
 void* HalProxy::getHandleForSubHalSharedObject(const std::string& filename) {
@@ -551,8 +864,37 @@ void* HalProxy::getHandleForSubHalSharedObject(const std::string& filename) {
     return nullptr;
 }
 
+void HalProxy::publishSensorTable() {
+    auto table = std::make_unique<SensorTable>(mSensors, mDynamicSensors);
+    if (mCurrentSensorTable != nullptr) {
+        table->copyRateLimits(*mCurrentSensorTable);
+    }
+    std::unique_ptr<const SensorTable> replacedTable = std::move(mCurrentSensorTable);
+    mCurrentSensorTable = std::move(table);
+    mSensorTable.store(mCurrentSensorTable.get(), std::memory_order_release);
+    if (replacedTable != nullptr) {
+        // Sub-HAL callbacks may still be looking at the replaced snapshot.
+        SensorTable::synchronize();
+    }
+}
+
+const HalProxy::SensorInfo& HalProxy::getSensorInfo(int32_t sensorHandle) {
+    static const SensorInfo kUnknownSensor = {};
+    const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+    const SensorInfo* sensor = table != nullptr ? table->find(sensorHandle) : nullptr;
+    return sensor != nullptr ? *sensor : kUnknownSensor;
+}
+
 void HalProxy::init() {
     initializeSensorList();
+    {
+        std::lock_guard<std::mutex> lock(mDynamicSensorsMutex);
+        publishSensorTable();
+    }
+    mSubHalStats = std::make_unique<SubHalStats[]>(mSubHalList.size());
+    for (size_t i = 0; i < mSubHalList.size(); i++) {
+        mSubHalWakelockRefCounters.push_back(std::make_unique<SubHalWakelockRefCounter>(this, i));
+    }
 }
 
 void HalProxy::stopThreads() {
@@ -595,45 +937,158 @@ void HalProxy::startPendingWritesThread(HalProxy* halProxy) {
 }
 
 void HalProxy::handlePendingWrites() {
-    // TODO(b/143302327): Find a way to optimize locking strategy maybe using two mutexes instead of
-    // one.
-    std::unique_lock<std::mutex> lock(mEventQueueWriteMutex);
     while (mThreadsRun.load()) {
-        mEventQueueWriteCV.wait(
-                lock, [&] { return !mPendingWriteEventsQueue.empty() || !mThreadsRun.load(); });
-        if (mThreadsRun.load()) {
-            std::vector<Event>& pendingWriteEvents = mPendingWriteEventsQueue.front().first;
-            size_t numWakeupEvents = mPendingWriteEventsQueue.front().second;
-            size_t eventQueueSize = mEventQueue->getQuantumCount();
-            size_t numToWrite = std::min(pendingWriteEvents.size(), eventQueueSize);
-            lock.unlock();
-            if (!mEventQueue->writeBlocking(
-                        pendingWriteEvents.data(), numToWrite,
-                        static_cast<uint32_t>(EventQueueFlagBits::EVENTS_READ),
-                        static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS),
-                        kPendingWriteTimeoutNs, mEventQueueFlag)) {
-                ALOGE("Dropping %zu events after blockingWrite failed.", numToWrite);
-                if (numWakeupEvents > 0) {
-                    if (pendingWriteEvents.size() > eventQueueSize) {
-                        decrementRefCountAndMaybeReleaseWakelock(
-                                countNumWakeupEvents(pendingWriteEvents, eventQueueSize));
-                    } else {
-                        decrementRefCountAndMaybeReleaseWakelock(numWakeupEvents);
-                    }
-                }
-            }
-            lock.lock();
-            mSizePendingWriteEventsQueue -= numToWrite;
-            if (pendingWriteEvents.size() > eventQueueSize) {
-                // TODO(b/143302327): Check if this erase operation is too inefficient. It will copy
-                // all the events ahead of it down to fill gap off array at front after the erase.
-                pendingWriteEvents.erase(pendingWriteEvents.begin(),
-                                         pendingWriteEvents.begin() + eventQueueSize);
+        {
+            std::unique_lock<std::mutex> lock(mPendingWritesMutex);
+            // Also wake up when a batch is due or a batch due earlier than the last one starts.
+            int64_t batchDeadline = mEventBatcher.nextDeadline();
+            auto ready = [&] {
+                int64_t nextBatchDeadline = mEventBatcher.nextDeadline();
+                return hasPublishedPendingWrites() || !mThreadsRun.load() ||
+                       nextBatchDeadline < batchDeadline || nextBatchDeadline <= getTimeNow();
+            };
+            if (batchDeadline == INT64_MAX) {
+                mEventQueueWriteCV.wait(lock, ready);
             } else {
-                mPendingWriteEventsQueue.pop();
+                int64_t timeout = std::max<int64_t>(batchDeadline - getTimeNow(), 0);
+                mEventQueueWriteCV.wait_for(lock, std::chrono::nanoseconds(timeout), ready);
+            }
+        }
+        flushDueBatches();
+        // Drain everything queued so far one quantum at a time, advancing the cursor instead of
+        // shifting the remaining events down after every write. The wake-up lane is checked
+        // again before every streaming quantum.
+        while (mThreadsRun.load() && !pendingWritesEmpty()) {
+            // Sub-HAL callbacks only write the FMQ directly while both lanes are empty, so once
+            // a direct write that started before events were queued is done, the FMQ is ours
+            // until the lanes drain. The blocking writes below run without the lock.
+            { std::lock_guard<std::mutex> lock(mEventQueueWriteMutex); }
+            if (mOptions.overflowPolicy == OverflowPolicy::DROP_OLDEST) {
+                trimPendingWrites();
+            }
+            if (!writePendingEvents(&mPendingWakeEventsQueue) &&
+                !writePendingEvents(&mPendingWriteEventsQueue)) {
+                // A producer reserved the head slots but has not published them yet, it wakes
+                // this thread once it has.
+                break;
+            }
+        }
+    }
+}
+
+void HalProxy::flushDueBatches() {
+    int64_t now = getTimeNow();
+    if (mEventBatcher.nextDeadline() > now) {
+        return;
+    }
+    mEventBatcher.takeDue(now, mBatchedEventsSink);
+}
+
+void HalProxy::queueBatchedEvents(const std::vector<Event>& events) {
+    if (events.empty()) {
+        return;
+    }
+    int64_t now = getTimeNow();
+    if (mPendingWriteEventsQueue.push(events.data(), events.size(), now)) {
+        mEventTrace.record(EventTrace::Stage::PENDING_ENQUEUE, events.data(), events.size(), now);
+        notifyPendingWritesThread();
+    } else {
+        countDroppedEvents(events.data(), events.size());
+    }
+}
+
+bool HalProxy::writePendingEvents(PendingWriteQueue* lane) {
+    PendingWriteQueue::Span pending = lane->peek(mEventQueue->getQuantumCount());
+    if (pending.size == 0) {
+        return false;
+    }
+    writeToEventQueue(pending);
+    lane->pop(pending.size);
+    return true;
+}
+
+void HalProxy::writeToEventQueue(const PendingWriteQueue::Span& pending) {
+    if (mEventQueue->writeBlocking(pending.events, pending.size,
+                                   static_cast<uint32_t>(EventQueueFlagBits::EVENTS_READ),
+                                   static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS),
+                                   kPendingWriteTimeoutNs, mEventQueueFlag)) {
+        int64_t now = getTimeNow();
+        mEventTrace.record(EventTrace::Stage::FMQ_WRITE, pending.events, pending.size, now);
+        recordPendingWriteLatency(pending, now);
+    } else {
+        ALOGE("Dropping %zu events after blockingWrite failed.", pending.size);
+        countDroppedEvents(pending.events, pending.size);
+    }
+}
+
+void HalProxy::trimPendingWrites() {
+    size_t capacity = mPendingWriteEventsQueue.capacity();
+    size_t size = mPendingWriteEventsQueue.size();
+    if (size <= capacity / 4 * 3) {
+        return;
+    }
+
+    // Meta data events, flush completions in particular, stay queued at the head and are
+    // written next.
+    size_t numToDrop = mPendingWriteEventsQueue.partitionHead(
+            size - capacity / 2,
+            [](const Event& event) { return event.sensorType == SensorType::META_DATA; });
+    if (numToDrop > 0) {
+        ALOGW("Pending write queue backed up, dropping %zu oldest events", numToDrop);
+    }
+    while (numToDrop > 0) {
+        PendingWriteQueue::Span dropped = mPendingWriteEventsQueue.peek(numToDrop);
+        countDroppedEvents(dropped.events, dropped.size);
+        mPendingWriteEventsQueue.pop(dropped.size);
+        numToDrop -= dropped.size;
+    }
+}
+
+void HalProxy::countDroppedEvents(const Event* events, size_t n) {
+    if (n == 0) return;
+    {
+        SensorTable::ReadGuard guard;
+        const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+        for (size_t i = 0; i < n; i++) {
+            SensorTable::RateLimit* rateLimit = table->findRateLimit(events[i].sensorHandle);
+            if (rateLimit != nullptr) {
+                rateLimit->eventsDropped.fetch_add(1, std::memory_order_relaxed);
+            }
+            SubHalStats* stats = getSubHalStats(events[i].sensorHandle);
+            if (stats != nullptr) {
+                stats->eventsDropped.fetch_add(1, std::memory_order_relaxed);
             }
         }
     }
+    size_t numWakeupEvents = countNumWakeupEvents(events, n);
+    if (numWakeupEvents > 0) {
+        decrementRefCountAndMaybeReleaseWakelock(numWakeupEvents);
+    }
+}
+
+void HalProxy::recordPendingWriteLatency(const PendingWriteQueue::Span& pending, int64_t now) {
+    // Record once per run of events that came from the same sub-HAL callback.
+    size_t runStart = 0;
+    for (size_t i = 1; i <= pending.size; i++) {
+        if (i < pending.size &&
+            extractSubHalIndex(pending.events[i].sensorHandle) ==
+                    extractSubHalIndex(pending.events[runStart].sensorHandle) &&
+            pending.enqueueTimesNs[i] == pending.enqueueTimesNs[runStart]) {
+            continue;
+        }
+        SubHalStats* stats = getSubHalStats(pending.events[runStart].sensorHandle);
+        if (stats != nullptr) {
+            stats->recordLatency(now - pending.enqueueTimesNs[runStart], i - runStart);
+        }
+        runStart = i;
+    }
+}
+
+void HalProxy::notifyPendingWritesThread() {
+    // Taking the mutex orders the push before the writer re-checks its wait predicate, it is only
+    // ever held for that check.
+    { std::lock_guard<std::mutex> lock(mPendingWritesMutex); }
+    mEventQueueWriteCV.notify_one();
 }
 
 void HalProxy::startWakelockThread(HalProxy* halProxy) {
@@ -643,12 +1098,29 @@ void HalProxy::startWakelockThread(HalProxy* halProxy) {
 void HalProxy::handleWakelocks() {
     std::unique_lock<std::recursive_mutex> lock(mWakelockMutex);
     while (mThreadsRun.load()) {
-        mWakelockCV.wait(lock, [&] { return mWakelockRefCount > 0 || !mThreadsRun.load(); });
+        mWakelockCV.wait(lock, [&] {
+            return mWakelockRefCount > 0 || mWakelockPendingReleaseTime != -1 ||
+                   !mThreadsRun.load();
+        });
         if (mThreadsRun.load()) {
             int64_t timeLeft;
-            if (sharedWakelockDidTimeout(&timeLeft)) {
+            if (mWakelockRefCount == 0) {
+                // Only a coalesced release is pending, wait for it unless the refcount goes up.
+                int64_t now = getTimeNow();
+                if (now >= mWakelockPendingReleaseTime) {
+                    releaseWakelock();
+                } else {
+                    mWakelockCV.wait_for(
+                            lock, std::chrono::nanoseconds(mWakelockPendingReleaseTime - now));
+                }
+            } else if (sharedWakelockDidTimeout(&timeLeft)) {
                 resetSharedWakelock();
             } else {
+                if (mOptions.wakelockHysteresisNs > 0) {
+                    // Refcount drops from other threads only schedule a release, come back
+                    // often enough to honour it.
+                    timeLeft = std::min(timeLeft, mOptions.wakelockHysteresisNs);
+                }
                 uint32_t numWakeLocksProcessed;
                 lock.unlock();
                 bool success = mWakeLockQueue->readBlocking(
@@ -656,6 +1128,7 @@ void HalProxy::handleWakelocks() {
                         static_cast<uint32_t>(WakeLockQueueFlagBits::DATA_WRITTEN), timeLeft);
                 lock.lock();
                 if (success) {
+                    mEventTrace.recordWakelockAck(numWakeLocksProcessed, getTimeNow());
                     decrementRefCountAndMaybeReleaseWakelock(
                             static_cast<size_t>(numWakeLocksProcessed));
                 }
@@ -680,48 +1153,287 @@ bool HalProxy::sharedWakelockDidTimeout(int64_t* timeLeft) {
 void HalProxy::resetSharedWakelock() {
     std::lock_guard<std::recursive_mutex> lockGuard(mWakelockMutex);
     decrementRefCountAndMaybeReleaseWakelock(mWakelockRefCount);
+    if (mWakelockRefCount == 0 && mWakelockHeld) {
+        // Do not let a coalesced release outlive a reset.
+        releaseWakelock();
+    }
     mWakelockTimeoutResetTime = getTimeNow();
 }
 
-void HalProxy::postEventsToMessageQueue(const std::vector<Event>& events, size_t numWakeupEvents,
+void HalProxy::releaseWakelock() {
+    release_wake_lock(kWakelockName);
+    mWakelockHeld = false;
+    mWakelockPendingReleaseTime = -1;
+    mNumWakelockReleases.fetch_add(1, std::memory_order_relaxed);
+    if (mWakelockOwnerSubHalIndex < mSubHalList.size()) {
+        mSubHalStats[mWakelockOwnerSubHalIndex].wakelockHoldNs.fetch_add(
+                getTimeNow() - mWakelockAcquireTime, std::memory_order_relaxed);
+    }
+    mWakelockOwnerSubHalIndex = SIZE_MAX;
+}
+
+void HalProxy::postEventsToMessageQueue(const std::vector<Event>& subHalEvents,
+                                        size_t numWakeupEvents,
                                         V2_0::implementation::ScopedWakelock wakelock) {
-    size_t numToWrite = 0;
-    std::lock_guard<std::mutex> lock(mEventQueueWriteMutex);
+    if (subHalEvents.empty()) return;
+    std::optional<SensorTable::ReadGuard> guard;
+    guard.emplace();
+    int64_t postTime = getTimeNow();
+    mEventTrace.record(EventTrace::Stage::CALLBACK, subHalEvents.data(), subHalEvents.size(),
+                       postTime);
+    size_t subHalIndex = extractSubHalIndex(subHalEvents.front().sensorHandle);
+    SubHalStats* stats = getSubHalStats(subHalEvents.front().sensorHandle);
+    if (stats != nullptr) {
+        stats->eventsPosted.fetch_add(subHalEvents.size(), std::memory_order_relaxed);
+        stats->wakeupEvents.fetch_add(numWakeupEvents, std::memory_order_relaxed);
+    }
+
+    // Only non-wake-up events are decimated or batched, so numWakeupEvents stays valid.
+    thread_local std::vector<Event> filteredEvents;
+    bool filtered = decimateToRequestedRate(subHalEvents, &filteredEvents);
+    if (filtered && stats != nullptr) {
+        stats->eventsDecimated.fetch_add(subHalEvents.size() - filteredEvents.size(),
+                                         std::memory_order_relaxed);
+    }
+    if (mEventBatcher.active()) {
+        if (!filtered) {
+            filteredEvents.assign(subHalEvents.begin(), subHalEvents.end());
+            filtered = true;
+        }
+        if (mEventBatcher.process(&filteredEvents, postTime)) {
+            notifyPendingWritesThread();
+        }
+    }
+    const std::vector<Event>& events = filtered ? filteredEvents : subHalEvents;
+    if (events.empty()) return;
+    // Writing needs no sensor info, and under OverflowPolicy::BLOCK this thread may sleep
+    // waiting for room. Do not hold off sensor table replacements meanwhile.
+    guard.reset();
+
     if (wakelock.isLocked()) {
-        incrementRefCountAndMaybeAcquireWakelock(numWakeupEvents);
-    }
-    if (mPendingWriteEventsQueue.empty()) {
-        numToWrite = std::min(events.size(), mEventQueue->availableToWrite());
-        if (numToWrite > 0) {
-            if (mEventQueue->write(events.data(), numToWrite)) {
-                // TODO(b/143302327): While loop if mEventQueue->avaiableToWrite > 0 to possibly fit
-                // in more writes immediately
-                mEventQueueFlag->wake(static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS));
-            } else {
-                numToWrite = 0;
+        incrementRefCountAndMaybeAcquireWakelock(numWakeupEvents, nullptr, subHalIndex);
+    }
+    // Never wait for the FMQ writer: if another thread is writing, queue behind it instead.
+    size_t numWritten = 0;
+    int64_t retryDeadline = 0;
+    std::unique_lock<std::mutex> lock(mEventQueueWriteMutex, std::try_to_lock);
+    while (lock.owns_lock() && pendingWritesEmpty()) {
+        size_t numToWrite = std::min(events.size() - numWritten, mEventQueue->availableToWrite());
+        if (numToWrite > 0 && mEventQueue->write(events.data() + numWritten, numToWrite)) {
+            mEventQueueFlag->wake(static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS));
+            int64_t now = getTimeNow();
+            mEventTrace.record(EventTrace::Stage::FMQ_WRITE, events.data() + numWritten,
+                               numToWrite, now);
+            if (stats != nullptr) {
+                stats->recordLatency(now - postTime, numToWrite);
             }
+            numWritten += numToWrite;
+        }
+        if (numWritten == events.size()) {
+            break;
         }
+
+        // The framework is behind. Give it a short while to make room, without the lock so the
+        // pending writes thread and other sub-HALs are not held off meanwhile.
+        lock.unlock();
+        int64_t now = getTimeNow();
+        if (retryDeadline == 0) {
+            retryDeadline = now + kDirectWriteRetryNs;
+        } else if (now >= retryDeadline) {
+            break;
+        }
+        uint32_t eventFlagState = 0;
+        if (mEventQueueFlag->wait(static_cast<uint32_t>(EventQueueFlagBits::EVENTS_READ),
+                                  &eventFlagState, retryDeadline - now) == OK &&
+            !pendingWritesEmpty()) {
+            // The pending writes thread may be blocked on the notification this wait consumed.
+            mEventQueueFlag->wake(static_cast<uint32_t>(EventQueueFlagBits::EVENTS_READ));
+        }
+        // Events queued meanwhile go first, the loop condition then queues these behind them.
+        lock.try_lock();
     }
-    size_t numLeft = events.size() - numToWrite;
-    if (numToWrite < events.size() &&
-        mSizePendingWriteEventsQueue + numLeft <= kMaxSizePendingWriteEventsQueue) {
-        std::vector<Event> eventsLeft(events.begin() + numToWrite, events.end());
-        mPendingWriteEventsQueue.push({eventsLeft, numWakeupEvents});
-        mSizePendingWriteEventsQueue += numLeft;
-        mMostEventsObservedPendingWriteEventsQueue =
-                std::max(mMostEventsObservedPendingWriteEventsQueue, mSizePendingWriteEventsQueue);
-        mEventQueueWriteCV.notify_one();
+    size_t numLeft = events.size() - numWritten;
+    if (numLeft == 0) {
+        mNumFastPathWrites.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        mNumSlowPathWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (numLeft > 0) {
+        if (lock.owns_lock() && mOptions.overflowPolicy == OverflowPolicy::BLOCK) {
+            // The pending writes thread needs the lock to make room while this thread waits.
+            lock.unlock();
+        }
+        queuePendingWrites(events.data() + numWritten, numLeft, postTime);
     }
 }
 
+void HalProxy::queuePendingWrites(const Event* events, size_t n, int64_t postTime) {
+    // Split the events into the two lanes, keeping their order within each lane.
+    thread_local std::vector<Event> wakeEvents;
+    thread_local std::vector<Event> streamEvents;
+    wakeEvents.clear();
+    streamEvents.clear();
+    {
+        // Only splitting and decimating read sensor info, pushPendingEvents may sleep.
+        SensorTable::ReadGuard guard;
+        for (size_t i = 0; i < n; i++) {
+            (isPriorityEvent(events[i]) ? wakeEvents : streamEvents).push_back(events[i]);
+        }
+
+        if (mOptions.overflowPolicy == OverflowPolicy::DECIMATE && !streamEvents.empty() &&
+            mPendingWriteEventsQueue.size() + streamEvents.size() >
+                    mPendingWriteEventsQueue.capacity() / 2) {
+            decimateEvents(&streamEvents);
+        }
+    }
+
+    bool queued = false;
+    for (auto [lane, laneEvents] : {std::make_pair(&mPendingWakeEventsQueue, &wakeEvents),
+                                    std::make_pair(&mPendingWriteEventsQueue, &streamEvents)}) {
+        if (laneEvents->empty()) continue;
+        if (pushPendingEvents(lane, *laneEvents, postTime)) {
+            mEventTrace.record(EventTrace::Stage::PENDING_ENQUEUE, laneEvents->data(),
+                               laneEvents->size(), getTimeNow());
+            queued = true;
+        } else {
+            countDroppedEvents(laneEvents->data(), laneEvents->size());
+        }
+    }
+
+    if (queued) {
+        size_t size = mPendingWakeEventsQueue.size() + mPendingWriteEventsQueue.size();
+        size_t most = mMostEventsObservedPendingWriteEventsQueue.load(std::memory_order_relaxed);
+        while (size > most && !mMostEventsObservedPendingWriteEventsQueue.compare_exchange_weak(
+                                      most, size, std::memory_order_relaxed)) {
+        }
+        notifyPendingWritesThread();
+    }
+}
+
+bool HalProxy::pushPendingEvents(PendingWriteQueue* lane, const std::vector<Event>& events,
+                                 int64_t postTime) {
+    if (lane->push(events.data(), events.size(), postTime)) {
+        return true;
+    }
+    if (mOptions.overflowPolicy != OverflowPolicy::BLOCK) {
+        return false;
+    }
+    int64_t deadline = getTimeNow() + mOptions.overflowBlockTimeoutNs;
+    while (mThreadsRun.load() && getTimeNow() < deadline) {
+        notifyPendingWritesThread();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        if (lane->push(events.data(), events.size(), postTime)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void HalProxy::decimateEvents(std::vector<Event>* events) {
+    const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+    thread_local std::vector<Event> droppedEvents;
+    droppedEvents.clear();
+    size_t numKept = 0;
+    for (const Event& event : *events) {
+        bool keep = true;
+        if (event.sensorType != SensorType::META_DATA &&
+            event.sensorType != SensorType::ADDITIONAL_INFO) {
+            SensorTable::RateLimit* rateLimit = table->findRateLimit(event.sensorHandle);
+            keep = rateLimit == nullptr ||
+                   rateLimit->decimationDropNext.fetch_xor(1, std::memory_order_relaxed) == 0;
+        }
+        if (keep) {
+            (*events)[numKept++] = event;
+        } else {
+            droppedEvents.push_back(event);
+        }
+    }
+    events->resize(numKept);
+    countDroppedEvents(droppedEvents.data(), droppedEvents.size());
+}
+
+bool HalProxy::decimateToRequestedRate(const std::vector<Event>& events,
+                                       std::vector<Event>* keptEvents) {
+    const SensorTable* table = mSensorTable.load(std::memory_order_acquire);
+    size_t i = 0;
+    while (i < events.size() && keepEventAtRequestedRate(table, events[i])) {
+        i++;
+    }
+    if (i == events.size()) {
+        return false;
+    }
+    // events[i] is dropped, copy what comes before it and filter the rest.
+    keptEvents->assign(events.begin(), events.begin() + i);
+    for (i++; i < events.size(); i++) {
+        if (keepEventAtRequestedRate(table, events[i])) {
+            keptEvents->push_back(events[i]);
+        }
+    }
+    return true;
+}
+
+bool HalProxy::keepEventAtRequestedRate(const SensorTable* table, const Event& event) {
+    if (event.sensorType == SensorType::META_DATA ||
+        event.sensorType == SensorType::ADDITIONAL_INFO) {
+        return true;
+    }
+    const SensorInfo* sensor = table->find(event.sensorHandle);
+    if (sensor == nullptr ||
+        (sensor->flags & (V1_0::SensorFlagBits::WAKE_UP |
+                          V1_0::SensorFlagBits::MASK_REPORTING_MODE)) != 0) {
+        // Unknown, wake-up or not continuous.
+        return true;
+    }
+    SensorTable::RateLimit* rateLimit = table->findRateLimit(event.sensorHandle);
+    int64_t samplingPeriodNs = rateLimit->samplingPeriodNs.load(std::memory_order_relaxed);
+    if (samplingPeriodNs <= 0) {
+        return true;
+    }
+    // Leave room for timestamp jitter so a sensor running at the requested rate is not halved.
+    int64_t lastTimestampNs = rateLimit->lastTimestampNs.load(std::memory_order_relaxed);
+    if (lastTimestampNs != INT64_MIN &&
+        event.timestamp - lastTimestampNs < samplingPeriodNs - samplingPeriodNs / 8) {
+        return false;
+    }
+    rateLimit->lastTimestampNs.store(event.timestamp, std::memory_order_relaxed);
+    return true;
+}
+
+bool HalProxy::isPriorityEvent(const Event& event) {
+    uint32_t flags = getSensorInfo(event.sensorHandle).flags;
+    uint32_t reportingMode =
+            flags & static_cast<uint32_t>(V1_0::SensorFlagBits::MASK_REPORTING_MODE);
+    return (flags & static_cast<uint32_t>(V1_0::SensorFlagBits::WAKE_UP)) != 0 ||
+           reportingMode == static_cast<uint32_t>(V1_0::SensorFlagBits::ONE_SHOT_MODE) ||
+           reportingMode == static_cast<uint32_t>(V1_0::SensorFlagBits::SPECIAL_REPORTING_MODE);
+}
+
 bool HalProxy::incrementRefCountAndMaybeAcquireWakelock(size_t delta,
                                                         int64_t* timeoutStart /* = nullptr */) {
+    return incrementRefCountAndMaybeAcquireWakelock(delta, timeoutStart, SIZE_MAX);
+}
+
+bool HalProxy::incrementRefCountAndMaybeAcquireWakelock(size_t delta, int64_t* timeoutStart,
+                                                        size_t subHalIndex) {
     if (!mThreadsRun.load()) return false;
     std::lock_guard<std::recursive_mutex> lockGuard(mWakelockMutex);
     if (mWakelockRefCount == 0) {
-        acquire_wake_lock(PARTIAL_WAKE_LOCK, kWakelockName);
+        if (mWakelockHeld) {
+            // Still held by a coalesced release, keep it instead of toggling the kernel lock.
+            mWakelockPendingReleaseTime = -1;
+            mNumWakelockCoalesced.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            acquire_wake_lock(PARTIAL_WAKE_LOCK, kWakelockName);
+            mWakelockHeld = true;
+            mWakelockAcquireTime = getTimeNow();
+            mWakelockOwnerSubHalIndex = subHalIndex;
+            mNumWakelockAcquires.fetch_add(1, std::memory_order_relaxed);
+        }
         mWakelockCV.notify_one();
     }
+    if (mWakelockOwnerSubHalIndex == SIZE_MAX) {
+        mWakelockOwnerSubHalIndex = subHalIndex;
+    }
     mWakelockTimeoutStartTime = getTimeNow();
     mWakelockRefCount += delta;
     if (timeoutStart != nullptr) {
@@ -742,7 +1454,15 @@ void HalProxy::decrementRefCountAndMaybeReleaseWakelock(size_t delta,
     if (mWakelockRefCount == 0 || timeoutStart < mWakelockTimeoutResetTime) return;
     mWakelockRefCount -= std::min(mWakelockRefCount, delta);
     if (mWakelockRefCount == 0) {
-        release_wake_lock(kWakelockName);
+        int64_t now = getTimeNow();
+        int64_t releaseTime = std::min(now + mOptions.wakelockHysteresisNs,
+                                       mWakelockAcquireTime + mOptions.wakelockMaxHoldNs);
+        if (mOptions.wakelockHysteresisNs > 0 && releaseTime > now) {
+            mWakelockPendingReleaseTime = releaseTime;
+            mWakelockCV.notify_one();
+        } else {
+            releaseWakelock();
+        }
     }
 }
 
@@ -765,15 +1485,21 @@ std::shared_ptr<ISubHalWrapperBase> HalProxy::getSubHalForSensorHandle(int32_t s
     return mSubHalList[extractSubHalIndex(sensorHandle)];
 }
 
+SubHalStats* HalProxy::getSubHalStats(int32_t sensorHandle) {
+    return isSubHalIndexValid(sensorHandle) ? &mSubHalStats[extractSubHalIndex(sensorHandle)]
+                                            : nullptr;
+}
+
 bool HalProxy::isSubHalIndexValid(int32_t sensorHandle) {
     return extractSubHalIndex(sensorHandle) < mSubHalList.size();
 }
 
-size_t HalProxy::countNumWakeupEvents(const std::vector<Event>& events, size_t n) {
+size_t HalProxy::countNumWakeupEvents(const Event* events, size_t n) {
+    SensorTable::ReadGuard guard;
     size_t numWakeupEvents = 0;
     for (size_t i = 0; i < n; i++) {
-        int32_t sensorHandle = events[i].sensorHandle;
-        if (mSensors[sensorHandle].flags & static_cast<uint32_t>(V1_0::SensorFlagBits::WAKE_UP)) {
+        if (getSensorInfo(events[i].sensorHandle).flags &
+            static_cast<uint32_t>(V1_0::SensorFlagBits::WAKE_UP)) {
             numWakeupEvents++;
         }
     }
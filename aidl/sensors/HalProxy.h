@@ -0,0 +1,771 @@
+/*
+ * Copyright (C) 2019 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "EventBatcher.h"
+#include "EventMessageQueueWrapper.h"
+#include "EventTrace.h"
+#include "HalProxyCallback.h"
+#include "ISensorsCallbackWrapper.h"
+#include "PendingWriteQueue.h"
+#include "SensorListCache.h"
+#include "SensorTable.h"
+#include "SubHalIndex.h"
+#include "SubHalStats.h"
+#include "SubHalWrapper.h"
+#include "V2_0/ScopedWakelock.h"
+#include "V2_0/SubHal.h"
+#include "V2_1/SubHal.h"
+#include "WakeLockMessageQueueWrapper.h"
+#include "convertV2_1.h"
+
+#include <android/hardware/sensors/2.1/ISensors.h>
+#include <android/hardware/sensors/2.1/types.h>
+#include <fmq/MessageQueue.h>
+#include <hardware_legacy/power.h>
+#include <hidl/MQDescriptor.h>
+#include <hidl/Status.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::sp;
+using ::android::hardware::EventFlag;
+using ::android::hardware::hidl_handle;
+using ::android::hardware::hidl_string;
+using ::android::hardware::hidl_vec;
+using ::android::hardware::MessageQueue;
+using ::android::hardware::MQDescriptor;
+using ::android::hardware::Return;
+using ::android::hardware::Void;
+
+/**
+ * Local copy of the multihal HalProxy declaration, kept in sync with HalProxy.cpp so the proxy
+ * can carry state the upstream header does not have.
+ *
+ * Everything that depends on the layout of this class, HalProxyAidl included, must be built
+ * from this tree. Linking a prebuilt multihal library compiled against the upstream header
+ * would give the class two different layouts in one binary.
+ */
+class HalProxy : public V2_0::implementation::IScopedWakelockRefCounter,
+                 public V2_0::implementation::ISubHalCallback {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+    using OperationMode = ::android::hardware::sensors::V1_0::OperationMode;
+    using RateLevel = ::android::hardware::sensors::V1_0::RateLevel;
+    using Result = ::android::hardware::sensors::V1_0::Result;
+    using SensorInfo = ::android::hardware::sensors::V2_1::SensorInfo;
+    using SharedMemInfo = ::android::hardware::sensors::V1_0::SharedMemInfo;
+    using IHalProxyCallbackV2_0 = V2_0::implementation::IHalProxyCallback;
+    using IHalProxyCallbackV2_1 = V2_1::implementation::IHalProxyCallback;
+    using ISensorsSubHalV2_0 = V2_0::implementation::ISensorsSubHal;
+    using ISensorsSubHalV2_1 = V2_1::implementation::ISensorsSubHal;
+    using ISensorsV2_0 = V2_0::ISensors;
+    using ISensorsV2_1 = V2_1::ISensors;
+    using HalProxyCallbackBase = V2_0::implementation::HalProxyCallbackBase;
+
+    //! What to do with events that do not fit in a pending write lane.
+    enum class OverflowPolicy {
+        //! Drop the events that did not fit.
+        DROP_NEWEST,
+        //! Discard the oldest streaming events once the streaming lane is three quarters full.
+        DROP_OLDEST,
+        //! Halve the rate of every streaming sensor while the streaming lane is half full.
+        DECIMATE,
+        //! Keep retrying for up to overflowBlockTimeoutNs before dropping.
+        BLOCK,
+    };
+
+    /**
+     * Tunables the service reads from system properties, see readOptions(). Tests pass their
+     * own instead.
+     */
+    struct Options {
+        //! How long to keep the wakelock after the refcount drops to zero, 0 disables coalescing
+        int64_t wakelockHysteresisNs = 0;
+
+        //! A wakelock held longer than this is released as soon as the refcount drops to zero
+        int64_t wakelockMaxHoldNs = 1000 * INT64_C(1000000);
+
+        OverflowPolicy overflowPolicy = OverflowPolicy::DROP_NEWEST;
+
+        //! How long a sub-HAL callback may wait for space under OverflowPolicy::BLOCK.
+        int64_t overflowBlockTimeoutNs = 20 * INT64_C(1000000);
+
+        /**
+         * Whether the proxy batches non-wake-up sensors that have no FIFO of their own. They are
+         * advertised with an EventBatcher::kMaxBatchSize FIFO, so the framework can ask for a
+         * report latency instead of reading every sample.
+         */
+        bool emulateBatching = true;
+
+        /**
+         * Whether sub-HAL libraries are loaded and their sensor lists queried on up to
+         * kMaxSubHalInitThreads threads. The dynamic linker serializes dlopen, so library
+         * constructors never overlap; only getSubHal and getSensorsList of different sub-HALs
+         * do. Turn this off for sub-HALs that share global state without locking it.
+         */
+        bool parallelSubHalInit = true;
+    };
+
+    //! @return The options set through ro.vendor.sensors.xiaomi.* properties.
+    static Options readOptions();
+
+    explicit HalProxy();
+    // Test only constructor.
+    explicit HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList);
+    explicit HalProxy(std::vector<ISensorsSubHalV2_0*>& subHalList,
+                      std::vector<ISensorsSubHalV2_1*>& subHalListV2_1,
+                      const Options& options = readOptions());
+    /**
+     * Test only constructor, loads the given sub-HAL libraries like the config files' ones. A
+     * non-empty cachedSensorList is served while they load in the background, as if read from
+     * the sensor list cache.
+     */
+    explicit HalProxy(const std::vector<std::string>& libraries, const Options& options,
+                      std::vector<SensorInfo> cachedSensorList = {});
+    ~HalProxy();
+
+    // Methods from ::android::hardware::sensors::V2_1::ISensors follow.
+    Return<void> getSensorsList_2_1(ISensorsV2_1::getSensorsList_2_1_cb _hidl_cb);
+
+    Return<Result> initialize_2_1(
+            const ::android::hardware::MQDescriptorSync<V2_1::Event>& eventQueueDescriptor,
+            const ::android::hardware::MQDescriptorSync<uint32_t>& wakeLockDescriptor,
+            const sp<V2_1::ISensorsCallback>& sensorsCallback);
+
+    Return<Result> injectSensorData_2_1(const Event& event);
+
+    // Methods from ::android::hardware::sensors::V2_0::ISensors follow.
+    Return<void> getSensorsList(ISensorsV2_0::getSensorsList_cb _hidl_cb);
+
+    Return<Result> setOperationMode(OperationMode mode);
+
+    Return<Result> activate(int32_t sensorHandle, bool enabled);
+
+    Return<Result> initialize(
+            const ::android::hardware::MQDescriptorSync<V1_0::Event>& eventQueueDescriptor,
+            const ::android::hardware::MQDescriptorSync<uint32_t>& wakeLockDescriptor,
+            const sp<V2_0::ISensorsCallback>& sensorsCallback);
+
+    Return<Result> initializeCommon(std::unique_ptr<EventMessageQueueWrapperBase>& eventQueue,
+                                    std::unique_ptr<WakeLockMessageQueueWrapperBase>& wakeLockQueue,
+                                    const sp<ISensorsCallbackWrapperBase>& sensorsCallback);
+
+    Return<Result> batch(int32_t sensorHandle, int64_t samplingPeriodNs,
+                         int64_t maxReportLatencyNs);
+
+    Return<Result> flush(int32_t sensorHandle);
+
+    Return<Result> injectSensorData(const V1_0::Event& event);
+
+    Return<void> registerDirectChannel(const SharedMemInfo& mem,
+                                       ISensorsV2_0::registerDirectChannel_cb _hidl_cb);
+
+    Return<Result> unregisterDirectChannel(int32_t channelHandle);
+
+    Return<void> configDirectReport(int32_t sensorHandle, int32_t channelHandle, RateLevel rate,
+                                    ISensorsV2_0::configDirectReport_cb _hidl_cb);
+
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& args);
+
+    Return<void> onDynamicSensorsConnected(const hidl_vec<SensorInfo>& dynamicSensorsAdded,
+                                           int32_t subHalIndex) override;
+
+    Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>& dynamicSensorHandlesRemoved,
+                                              int32_t subHalIndex) override;
+
+    void postEventsToMessageQueue(const std::vector<Event>& events, size_t numWakeupEvents,
+                                  V2_0::implementation::ScopedWakelock wakelock) override;
+
+    //! The returned reference is only valid while the caller holds a SensorTable::ReadGuard.
+    const SensorInfo& getSensorInfo(int32_t sensorHandle) override;
+
+    bool areThreadsRunning() override { return mThreadsRun.load(); }
+
+    // Below methods are from IScopedWakelockRefCounter interface
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t delta,
+                                                  int64_t* timeoutStart = nullptr) override;
+
+    void decrementRefCountAndMaybeReleaseWakelock(size_t delta, int64_t timeoutStart = -1) override;
+
+    const std::map<int32_t, SensorInfo>& getSensors() { return mSensors; }
+
+  private:
+    /**
+     * The wakelock refcounter handed to one sub-HAL. It tags every reference it takes with the
+     * sub-HAL index, so the time the shared wakelock is held is charged to whoever acquired it.
+     */
+    class SubHalWakelockRefCounter : public V2_0::implementation::IScopedWakelockRefCounter {
+      public:
+        SubHalWakelockRefCounter(HalProxy* halProxy, size_t subHalIndex)
+            : mHalProxy(halProxy), mSubHalIndex(subHalIndex) {}
+
+        bool incrementRefCountAndMaybeAcquireWakelock(size_t delta,
+                                                      int64_t* timeoutStart = nullptr) override {
+            return mHalProxy->incrementRefCountAndMaybeAcquireWakelock(delta, timeoutStart,
+                                                                       mSubHalIndex);
+        }
+
+        void decrementRefCountAndMaybeReleaseWakelock(size_t delta,
+                                                      int64_t timeoutStart = -1) override {
+            mHalProxy->decrementRefCountAndMaybeReleaseWakelock(delta, timeoutStart);
+        }
+
+      private:
+        HalProxy* const mHalProxy;
+        const size_t mSubHalIndex;
+    };
+
+    using EventMessageQueueV2_1 = MessageQueue<V2_1::Event, kSynchronizedReadWrite>;
+    using EventMessageQueueV2_0 = MessageQueue<V1_0::Event, kSynchronizedReadWrite>;
+    using WakeLockMessageQueue = MessageQueue<uint32_t, kSynchronizedReadWrite>;
+
+    /**
+     * The Event FMQ where sensor events are written
+     */
+    std::unique_ptr<EventMessageQueueWrapperBase> mEventQueue;
+
+    /**
+     * The Wake Lock FMQ that is read to determine when the framework has handled WAKE_UP events
+     */
+    std::unique_ptr<WakeLockMessageQueueWrapperBase> mWakeLockQueue;
+
+    /**
+     * Event Flag to signal to the framework when sensor events are available to be read and to
+     * interrupt event queue blocking write.
+     */
+    EventFlag* mEventQueueFlag = nullptr;
+
+    //! Event Flag to signal internally that the wakelock queue should stop its blocking read.
+    EventFlag* mWakelockQueueFlag = nullptr;
+
+    /**
+     * Callback to the sensors framework to inform it that new sensors have been added or removed.
+     */
+    sp<ISensorsCallbackWrapperBase> mDynamicSensorsCallback;
+
+    /**
+     * SubHal objects that have been saved from vendor dynamic libraries.
+     */
+    std::vector<std::shared_ptr<ISubHalWrapperBase>> mSubHalList;
+
+    struct SubHalLibrary {
+        std::string name;
+        int64_t loadTimeNs;
+        bool loaded;
+    };
+
+    //! Every library listed in the config files, in order, with how long loading it took.
+    std::vector<SubHalLibrary> mSubHalLibraries;
+
+    //! Sensor list read from the cache, served by getSensorsList until mSubHalsReady is set.
+    std::vector<SensorInfo> mCachedSensorList;
+
+    //! Whether a client has seen mCachedSensorList, guarded by mSubHalsReadyMutex.
+    bool mCachedSensorListServed = false;
+
+    //! Handles from a served mCachedSensorList the sub-HALs no longer report, or report changed.
+    std::vector<int32_t> mSensorsRemovedFromCachedList;
+
+    //! Sensors the sub-HALs report that a served mCachedSensorList lacked or described otherwise.
+    std::vector<SensorInfo> mSensorsAddedToCachedList;
+
+    //! Whether mSubHalList and mSensors have been initialized.
+    std::atomic_bool mSubHalsReady = true;
+
+    std::mutex mSubHalsReadyMutex;
+    std::condition_variable mSubHalsReadyCV;
+
+    //! Loads the sub-HALs when the sensor list came from the cache.
+    std::thread mSubHalInitThread;
+
+    /**
+     * Map of sensor handles to SensorInfo objects that contains the sensor info from subhals as
+     * well as the modified sensor handle for the framework.
+     *
+     * The subhal index is encoded in the first byte of the sensor handle and the remaining
+     * bytes are generated by the subhal to identify its sensors.
+     */
+    std::map<int32_t, SensorInfo> mSensors;
+
+    //! Map of the dynamic sensors that have been added to halproxy.
+    std::map<int32_t, SensorInfo> mDynamicSensors;
+
+    /**
+     * The latest snapshot of mSensors and mDynamicSensors used by the event path. Snapshots are
+     * replaced with a single atomic store, readers never lock but must hold a
+     * SensorTable::ReadGuard.
+     */
+    std::atomic<const SensorTable*> mSensorTable = nullptr;
+
+    //! Owns the snapshot mSensorTable points to. Guarded by mDynamicSensorsMutex.
+    std::unique_ptr<const SensorTable> mCurrentSensorTable;
+
+    const Options mOptions;
+
+    //! The current operation mode for all subhals.
+    OperationMode mCurrentOperationMode = OperationMode::NORMAL;
+
+    //! The single subHal that supports directChannel reporting.
+    std::shared_ptr<ISubHalWrapperBase> mDirectChannelSubHal;
+
+    //! The timeout for each pending write on background thread for events.
+    static const int64_t kPendingWriteTimeoutNs = 5 * INT64_C(1000000000) /* 5 seconds */;
+
+    //! How long a sub-HAL callback waits for the framework to make room before queueing.
+    static constexpr int64_t kDirectWriteRetryNs = 100 * INT64_C(1000) /* 100 us */;
+
+    //! Threads sub-HALs are loaded and queried on when Options::parallelSubHalInit is set.
+    static constexpr size_t kMaxSubHalInitThreads = 4;
+
+    //! The bit mask used to get the subhal index from a sensor handle.
+    static constexpr int32_t kSensorHandleSubHalIndexMask = ~kLocalHandleMask;
+
+    //! The max number of events allowed in the pending write events queue, a power of two.
+    static constexpr size_t kMaxSizePendingWriteEventsQueue = 1 << 14;
+
+    //! The max number of events allowed in the pending wake-up events queue, a power of two.
+    static constexpr size_t kMaxSizePendingWakeEventsQueue = 1 << 10;
+
+    /**
+     * The streaming events waiting to be written to the event FMQ by the background thread.
+     * Sub-HAL callback threads push into it without taking any lock.
+     */
+    PendingWriteQueue mPendingWriteEventsQueue{kMaxSizePendingWriteEventsQueue};
+
+    /**
+     * The pending wake-up and one-shot events. The background thread always drains this lane
+     * before mPendingWriteEventsQueue, so a backlog of streaming data cannot delay them. Every
+     * sensor maps to exactly one lane, so events of one sensor stay in order.
+     */
+    PendingWriteQueue mPendingWakeEventsQueue{kMaxSizePendingWakeEventsQueue};
+
+    //! The most events observed on the pending write events queue for debug purposes.
+    std::atomic<size_t> mMostEventsObservedPendingWriteEventsQueue = 0;
+
+    //! The number of event batches fully written from the sub-HAL callback thread.
+    std::atomic<uint64_t> mNumFastPathWrites = 0;
+
+    //! The number of event batches that needed the pending writes thread.
+    std::atomic<uint64_t> mNumSlowPathWrites = 0;
+
+    /**
+     * Held by sub-HAL callbacks while they write the event FMQ directly. The pending writes
+     * thread takes it before writing queued events, never across the write itself.
+     */
+    std::mutex mEventQueueWriteMutex;
+
+    //! The mutex the pending writes thread sleeps on, never held across an FMQ write.
+    std::mutex mPendingWritesMutex;
+
+    //! The condition variable waiting on pending write events to stack up
+    std::condition_variable mEventQueueWriteCV;
+
+    //! The thread object ptr that handles pending writes
+    std::thread mPendingWritesThread;
+
+    //! The thread object that handles wakelocks
+    std::thread mWakelockThread;
+
+    //! The bool indicating whether to end the threads started in initialize
+    std::atomic_bool mThreadsRun = true;
+
+    //! Per sub-HAL counters, indexed like mSubHalList.
+    std::unique_ptr<SubHalStats[]> mSubHalStats;
+
+    //! Recent event flow through the proxy, dumped by debug with --trace.
+    EventTrace mEventTrace;
+
+    //! Holds back events of sensors the proxy batches on behalf of their sub-HAL.
+    EventBatcher mEventBatcher;
+
+    //! Queues the batches mEventBatcher releases outside of postEventsToMessageQueue.
+    const EventBatcher::Sink mBatchedEventsSink = [this](const std::vector<Event>& events) {
+        queueBatchedEvents(events);
+    };
+
+    //! Sensors advertised with an emulated FIFO. Only written while the sensor list is built.
+    std::set<int32_t> mBatchingEmulatedSensors;
+
+    //! The mutex protecting access to the dynamic sensors added and removed methods.
+    std::mutex mDynamicSensorsMutex;
+
+    // WakelockRefCount membar vars below
+
+    //! The mutex protecting the wakelock refcount and subsequent wakelock releases and
+    //! acquisitions
+    std::recursive_mutex mWakelockMutex;
+
+    std::condition_variable_any mWakelockCV;
+
+    //! The refcount of how many events have been posted and not consumed by the framework
+    size_t mWakelockRefCount = 0;
+
+    //! The time in nanoseconds from the boot clock which the last wakelock acquisition timer
+    //! was started
+    int64_t mWakelockTimeoutStartTime = V2_0::implementation::getTimeNow();
+
+    //! The time in nanoseconds that wakelock timeout was reset
+    int64_t mWakelockTimeoutResetTime = V2_0::implementation::getTimeNow();
+
+    //! The time in nanoseconds the shared wakelock was last acquired
+    int64_t mWakelockAcquireTime = 0;
+
+    //! The index of the sub-HAL that acquired the held wakelock, SIZE_MAX if unknown or released
+    size_t mWakelockOwnerSubHalIndex = SIZE_MAX;
+
+    //! One per entry of mSubHalList, sub-HALs keep pointers to them.
+    std::vector<std::unique_ptr<SubHalWakelockRefCounter>> mSubHalWakelockRefCounters;
+
+    //! Whether the kernel wakelock is held. It can outlive a zero refcount while a coalesced
+    //! release is pending.
+    bool mWakelockHeld = false;
+
+    //! When a coalesced release of the shared wakelock is due, or -1 if none is pending
+    int64_t mWakelockPendingReleaseTime = -1;
+
+    //! The time in nanoseconds the wakelock statistics below started counting
+    int64_t mWakelockStatsStartTime = V2_0::implementation::getTimeNow();
+
+    std::atomic<uint64_t> mNumWakelockAcquires = 0;
+    std::atomic<uint64_t> mNumWakelockReleases = 0;
+
+    //! Refcount increments that reused a wakelock waiting for a coalesced release
+    std::atomic<uint64_t> mNumWakelockCoalesced = 0;
+
+    //! The name of the wakelock to acquire
+    const char* kWakelockName = "SensorsHAL_WAKEUP";
+
+    /**
+     * Append the sub-HAL libraries listed in a config file to libraries, in file order.
+     */
+    void readSubHalLibrariesFromConfigFile(const char* configFileName,
+                                           std::vector<std::string>* libraries);
+
+    /**
+     * Initialize the list of SubHal objects in mSubHalList by loading the given dynamic
+     * libraries concurrently. Sub-HAL indexes follow the order of libraries.
+     */
+    void initializeSubHalList(const std::vector<std::string>& libraries);
+
+    /**
+     * Load a sub-HAL library and get its SubHal object.
+     *
+     * @return The wrapped SubHal or nullptr if the library could not be used.
+     */
+    std::shared_ptr<ISubHalWrapperBase> loadSubHal(const std::string& subHalLibraryFile);
+
+    /**
+     * Initialize the list of SensorInfo objects in mSensorList by getting sensors from the
+     * subhals.
+     */
+    void initializeSensorList();
+
+    /**
+     * Publish a new sensor table snapshot built from mSensors and mDynamicSensors. The caller
+     * must hold mDynamicSensorsMutex.
+     */
+    void publishSensorTable();
+
+    /**
+     * Drop samples of non-wake-up continuous sensors that arrive faster than the sampling period
+     * last requested through batch. Sub-HALs that stream at their hardware rate would otherwise
+     * spend FMQ bandwidth on samples nobody asked for.
+     *
+     * @param events The events posted by a sub-HAL.
+     * @param keptEvents Filled with the events to forward if any event was dropped.
+     *
+     * @return true if any event was dropped.
+     */
+    bool decimateToRequestedRate(const std::vector<Event>& events, std::vector<Event>* keptEvents);
+
+    //! Whether an event fits the requested rate of its sensor, updating the rate limit state.
+    bool keepEventAtRequestedRate(const SensorTable* table, const Event& event);
+
+    /**
+     * Try using the default include directories as well as the directories defined in
+     * kSubHalShareObjectLocations to get a handle for dlsym for a subhal.
+     *
+     * @param filename The file name to search for.
+     *
+     * @return The handle or nullptr if search failed.
+     */
+    void* getHandleForSubHalSharedObject(const std::string& filename);
+
+    /**
+     * Load the given sub-HAL libraries, initialize the sensor list from them and mark the
+     * sub-HALs ready. If cacheKey is set, the sensor list cache is rewritten when it does not
+     * match the list the sub-HALs reported.
+     */
+    void initializeSubHals(const std::vector<std::string>& libraries,
+                           std::optional<uint64_t> cacheKey);
+
+    //! Serve mCachedSensorList while initializeSubHals runs on mSubHalInitThread.
+    void startSubHalInitThread(const std::vector<std::string>& libraries,
+                               std::optional<uint64_t> cacheKey);
+
+    //! Fill the lists announceSensorListChanges reports from mCachedSensorList and mSensors.
+    void diffCachedSensorList();
+
+    /**
+     * Report how the live sensor list differs from a stale cached one a client was served, as
+     * dynamic sensor changes through mDynamicSensorsCallback. Only the first client to
+     * initialize needs them; later ones get the live list from getSensorsList.
+     */
+    void announceSensorListChanges();
+
+    //! @return How many threads initializeSubHalList and initializeSensorList may use.
+    size_t getNumSubHalInitThreads() const;
+
+    /**
+     * Block until the sub-HALs have been loaded. Every entry point that talks to a sub-HAL or
+     * reads mSensors must call this first.
+     */
+    void waitForSubHals();
+
+    /**
+     * Copy the cached sensor list into sensors if the sub-HALs are still loading.
+     *
+     * @return False if the sub-HALs are ready, in which case mSensors must be served instead.
+     */
+    bool getCachedSensorListWhileLoading(std::vector<SensorInfo>* sensors);
+
+    /**
+     * Calls the helper methods that all ctors use.
+     */
+    void init();
+
+    /**
+     * Stops all threads by setting the threads running flag to false and joining to them.
+     */
+    void stopThreads();
+
+    /**
+     * Disable all the sensors observed by the HalProxy.
+     */
+    void disableAllSensors();
+
+    /**
+     * Starts the thread that handles pending writes to event fmq.
+     *
+     * @param halProxy The HalProxy object pointer.
+     */
+    static void startPendingWritesThread(HalProxy* halProxy);
+
+    //! Handles the pending writes on events to eventqueue.
+    void handlePendingWrites();
+
+    /**
+     * Record the callback to FMQ write latency of pending events that were just written.
+     *
+     * @param pending The events that were written.
+     * @param now The time the write completed.
+     */
+    void recordPendingWriteLatency(const PendingWriteQueue::Span& pending, int64_t now);
+
+    /**
+     * Write events from one of the pending lanes to the event FMQ and pop them. Only called by
+     * the pending writes thread, the events stay queued until written so sub-HAL callbacks do
+     * not write the FMQ meanwhile.
+     *
+     * @return false if the lane had no published events yet.
+     */
+    bool writePendingEvents(PendingWriteQueue* lane);
+
+    /**
+     * Queue events the sub-HAL callback could not write directly, splitting them across the
+     * pending lanes.
+     */
+    void queuePendingWrites(const Event* events, size_t n, int64_t postTime);
+
+    /**
+     * Push events to a pending lane, waiting for space if the overflow policy says so.
+     *
+     * @return false if the events were not queued.
+     */
+    bool pushPendingEvents(PendingWriteQueue* lane, const std::vector<Event>& events,
+                           int64_t postTime);
+
+    /**
+     * Drop every other sample of each sensor in events, keeping meta data and additional info
+     * events. Must be called under a SensorTable::ReadGuard.
+     */
+    void decimateEvents(std::vector<Event>* events);
+
+    /**
+     * Discard the oldest streaming events once the streaming lane runs above its high watermark.
+     * Meta data events among them stay queued. Only called by the pending writes thread.
+     */
+    void trimPendingWrites();
+
+    /**
+     * Write events to the event FMQ, blocking for up to kPendingWriteTimeoutNs, and account
+     * them as dropped if that fails. Only called by the pending writes thread.
+     */
+    void writeToEventQueue(const PendingWriteQueue::Span& pending);
+
+    /**
+     * Account events that will never reach the framework, per sub-HAL and per sensor, and give
+     * back the wakelock references of the wake-up ones.
+     */
+    void countDroppedEvents(const Event* events, size_t n);
+
+    /**
+     * Queue events released by mEventBatcher on the streaming lane. Called with the sensor's
+     * batch locked, so they are queued ahead of any later event of the sensor.
+     */
+    void queueBatchedEvents(const std::vector<Event>& events);
+
+    /**
+     * Queue the batches whose report latency has passed. Called by the pending writes thread.
+     */
+    void flushDueBatches();
+
+    //! Whether events of this sensor go to the priority lane.
+    bool isPriorityEvent(const Event& event);
+
+    //! Whether both pending lanes are empty.
+    bool pendingWritesEmpty() const {
+        return mPendingWakeEventsQueue.empty() && mPendingWriteEventsQueue.empty();
+    }
+
+    //! Whether either pending lane has an event the pending writes thread can write now.
+    bool hasPublishedPendingWrites() const {
+        return mPendingWakeEventsQueue.readable() || mPendingWriteEventsQueue.readable();
+    }
+
+    //! Wake up the pending writes thread after events were pushed to the pending queue.
+    void notifyPendingWritesThread();
+
+    /**
+     * Starts the thread that handles decrementing the ref count on wakeup events processed by the
+     * framework and timing out wakelocks.
+     *
+     * @param halProxy The HalProxy object pointer.
+     */
+    static void startWakelockThread(HalProxy* halProxy);
+
+    //! Handles the wakelocks.
+    void handleWakelocks();
+
+    /**
+     * @param timeLeft The variable that should be set to the timeleft before timeout will occur or
+     * unmodified if timeout occurred.
+     *
+     * @return true if the shared wakelock has been held passed the timeout and should be released
+     */
+    bool sharedWakelockDidTimeout(int64_t* timeLeft);
+
+    /**
+     * Reset all the member variables associated with the wakelock ref count and maybe release
+     * the shared wakelock.
+     */
+    void resetSharedWakelock();
+
+    /**
+     * Release the kernel wakelock and account its hold time. mWakelockMutex must be held.
+     */
+    void releaseWakelock();
+
+    /**
+     * Take wakelock references on behalf of a sub-HAL.
+     *
+     * @param subHalIndex The sub-HAL the wakelock hold time is charged to if this acquires it,
+     *     SIZE_MAX if unknown.
+     */
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t delta, int64_t* timeoutStart,
+                                                  size_t subHalIndex);
+
+    /**
+     * Clear direct channel flags if the HalProxy has already chosen a subhal as its direct channel
+     * subhal. Set the directChannelSubHal pointer to the subHal passed in if this is the first
+     * direct channel enabled sensor seen.
+     *
+     * @param sensorInfo The SensorInfo object that may be altered to have direct channel support
+     *    disabled.
+     * @param subHal The subhal pointer that the current sensorInfo object came from.
+     */
+    void setDirectChannelFlags(SensorInfo* sensorInfo, std::shared_ptr<ISubHalWrapperBase> subHal);
+
+    /*
+     * Get the subhal pointer which can be found by indexing into the mSubHalList vector
+     * using the index from the first byte of sensorHandle.
+     *
+     * @param sensorHandle The handle used to identify a sensor in one of the subhals.
+     */
+    std::shared_ptr<ISubHalWrapperBase> getSubHalForSensorHandle(int32_t sensorHandle);
+
+    /**
+     * @param sensorHandle A sensor handle with the subhal index set.
+     *
+     * @return The counters of the sensor's subhal or nullptr if the index is invalid.
+     */
+    SubHalStats* getSubHalStats(int32_t sensorHandle);
+
+    /**
+     * Checks that sensorHandle's subhal index byte is within bounds of mSubHalList.
+     *
+     * @param sensorHandle The sensor handle to check.
+     *
+     * @return true if sensorHandles's subhal index byte is valid.
+     */
+    bool isSubHalIndexValid(int32_t sensorHandle);
+
+    /**
+     * Count the number of wakeup events in the first n events of an array.
+     *
+     * @param events The array of Event objects.
+     * @param n The end index not inclusive of events to consider.
+     *
+     * @return The number of wakeup events of the considered events.
+     */
+    size_t countNumWakeupEvents(const Event* events, size_t n);
+
+    /*
+     * Clear out the subhal index bytes from a sensorHandle.
+     *
+     * @param sensorHandle The sensor handle to modify.
+     *
+     * @return The modified version of the sensor handle.
+     */
+    static int32_t clearSubHalIndex(int32_t sensorHandle);
+
+    /**
+     * @param sensorHandle The sensor handle to modify.
+     *
+     * @return true if subHalIndex byte of sensorHandle is zeroed.
+     */
+    static bool subHalIndexIsClear(int32_t sensorHandle);
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -15,6 +15,8 @@
  */
 
 #include "HalProxyCallback.h"
+#include "SensorTable.h"
+#include "SubHalIndex.h"
 
 #include <cinttypes>
 
@@ -24,25 +26,44 @@ namespace sensors {
 namespace V2_0 {
 namespace implementation {
 
-static constexpr int32_t kBitsAfterSubHalIndex = 24;
-
-/**
- * Set the subhal index as first byte of sensor handle and return this modified version.
- *
- * @param sensorHandle The sensor handle to modify.
- * @param subHalIndex The index in the hal proxy of the sub hal this sensor belongs to.
- *
- * @return The modified sensor handle.
- */
-int32_t setSubHalIndex(int32_t sensorHandle, size_t subHalIndex) {
-    return sensorHandle | (static_cast<int32_t>(subHalIndex) << kBitsAfterSubHalIndex);
-}
+using V2_1::implementation::setSubHalIndex;
 
 void HalProxyCallbackBase::postEvents(const std::vector<V2_1::Event>& events,
                                       ScopedWakelock wakelock) {
     if (events.empty() || !mCallback->areThreadsRunning()) return;
-    size_t numWakeupEvents;
-    std::vector<V2_1::Event> processedEvents = processEvents(events, &numWakeupEvents);
+
+    // Each sub-HAL posts from its own threads, so a per-thread buffer can be rewritten in place
+    // and handed to the proxy as is. It keeps its capacity, steady posting doesn't allocate.
+    thread_local std::vector<V2_1::Event> processedEvents;
+    size_t numWakeupEvents = 0;
+    processedEvents.resize(events.size());
+    size_t numProcessed = 0;
+    {
+        // The sensor info references below point into the proxy's current sensor table. The
+        // guard ends before posting, which may wait for the framework.
+        V2_1::implementation::SensorTable::ReadGuard guard;
+        for (const V2_1::Event& event : events) {
+            V2_1::Event& out = processedEvents[numProcessed];
+            out = event;
+            out.sensorHandle = setSubHalIndex(event.sensorHandle, mSubHalIndex);
+            if (out.sensorType == V2_1::SensorType::DYNAMIC_SENSOR_META) {
+                out.u.dynamic.sensorHandle =
+                        setSubHalIndex(out.u.dynamic.sensorHandle, mSubHalIndex);
+            }
+            const V2_1::SensorInfo& sensor = mCallback->getSensorInfo(out.sensorHandle);
+
+            if (sensor.type == V2_1::SensorType::PICK_UP_GESTURE && out.u.scalar != 1) {
+                continue;
+            }
+
+            if ((sensor.flags & V1_0::SensorFlagBits::WAKE_UP) != 0) {
+                numWakeupEvents++;
+            }
+            numProcessed++;
+        }
+    }
+    processedEvents.resize(numProcessed);
+
     if (numWakeupEvents > 0) {
         ALOG_ASSERT(wakelock.isLocked(),
                     "Wakeup events posted while wakelock unlocked for subhal"
@@ -62,31 +83,6 @@ ScopedWakelock HalProxyCallbackBase::createScopedWakelock(bool lock) {
     return wakelock;
 }
 
-std::vector<V2_1::Event> HalProxyCallbackBase::processEvents(const std::vector<V2_1::Event>& events,
-                                                             size_t* numWakeupEvents) const {
-    *numWakeupEvents = 0;
-    std::vector<V2_1::Event> eventsOut;
-    for (V2_1::Event event : events) {
-        event.sensorHandle = setSubHalIndex(event.sensorHandle, mSubHalIndex);
-        if (event.sensorType == V2_1::SensorType::DYNAMIC_SENSOR_META) {
-            event.u.dynamic.sensorHandle =
-                    setSubHalIndex(event.u.dynamic.sensorHandle, mSubHalIndex);
-        }
-        const V2_1::SensorInfo& sensor = mCallback->getSensorInfo(event.sensorHandle);
-
-        if (sensor.type == V2_1::SensorType::PICK_UP_GESTURE
-            && event.u.scalar != 1) {
-            continue;
-        }
-
-        if ((sensor.flags & V1_0::SensorFlagBits::WAKE_UP) != 0) {
-            (*numWakeupEvents)++;
-        }
-        eventsOut.push_back(event);
-    }
-    return eventsOut;
-}
-
 }  // namespace implementation
 }  // namespace V2_0
 }  // namespace sensors
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PendingWriteQueue.h"
+
+#include <log/log.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+PendingWriteQueue::PendingWriteQueue(size_t capacity)
+    : mCapacity(capacity),
+      mMask(capacity - 1),
+      mEvents(new Event[capacity]),
+      mEnqueueTimesNs(new int64_t[capacity]),
+      mSequence(new std::atomic<uint64_t>[capacity]) {
+    LOG_ALWAYS_FATAL_IF((capacity & mMask) != 0, "Capacity %zu is not a power of two", capacity);
+    for (size_t i = 0; i < mCapacity; i++) {
+        mSequence[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool PendingWriteQueue::push(const Event* events, size_t count, int64_t enqueueTimeNs) {
+    if (count == 0) return true;
+    if (count > mCapacity) return false;
+
+    uint64_t tail = mTail.load(std::memory_order_relaxed);
+    do {
+        uint64_t head = mHead.load(std::memory_order_acquire);
+        if (tail + count - head > mCapacity) {
+            return false;
+        }
+    } while (!mTail.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed,
+                                          std::memory_order_relaxed));
+
+    for (size_t i = 0; i < count; i++) {
+        uint64_t pos = tail + i;
+        mEvents[pos & mMask] = events[i];
+        mEnqueueTimesNs[pos & mMask] = enqueueTimeNs;
+        mSequence[pos & mMask].store(pos + 1, std::memory_order_release);
+    }
+    return true;
+}
+
+PendingWriteQueue::Span PendingWriteQueue::peek(size_t max) const {
+    uint64_t head = mHead.load(std::memory_order_relaxed);
+    size_t first = head & mMask;
+    size_t limit = std::min(max, mCapacity - first);
+
+    size_t count = 0;
+    while (count < limit &&
+           mSequence[first + count].load(std::memory_order_acquire) == head + count + 1) {
+        count++;
+    }
+
+    return {&mEvents[first], &mEnqueueTimesNs[first], count};
+}
+
+void PendingWriteQueue::pop(size_t count) {
+    mHead.store(mHead.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+size_t PendingWriteQueue::partitionHead(size_t max, bool (*keep)(const Event&)) {
+    uint64_t head = mHead.load(std::memory_order_relaxed);
+    size_t count = 0;
+    while (count < std::min(max, mCapacity) &&
+           mSequence[(head + count) & mMask].load(std::memory_order_acquire) == head + count + 1) {
+        count++;
+    }
+
+    // Walk backwards keeping [pos, end) as the events not kept followed by the kept ones. A kept
+    // event swaps places with the first event not kept after it, which only reorders those.
+    uint64_t end = head + count;
+    uint64_t firstKept = end;
+    for (uint64_t pos = end; pos-- > head;) {
+        if (keep(mEvents[pos & mMask])) {
+            firstKept--;
+            std::swap(mEvents[pos & mMask], mEvents[firstKept & mMask]);
+            std::swap(mEnqueueTimesNs[pos & mMask], mEnqueueTimesNs[firstKept & mMask]);
+        }
+    }
+    return static_cast<size_t>(firstKept - head);
+}
+
+void PendingWriteQueue::clear() {
+    // Moving the head past a reserved slot would let the next producer reserve it again while
+    // the first one is still copying into it.
+    for (Span pending = peek(mCapacity); pending.size > 0; pending = peek(mCapacity)) {
+        pop(pending.size);
+    }
+}
+
+bool PendingWriteQueue::readable() const {
+    uint64_t head = mHead.load(std::memory_order_relaxed);
+    return mSequence[head & mMask].load(std::memory_order_acquire) == head + 1;
+}
+
+size_t PendingWriteQueue::size() const {
+    uint64_t head = mHead.load(std::memory_order_acquire);
+    return static_cast<size_t>(mTail.load(std::memory_order_acquire) - head);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/2.1/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Bounded multi-producer single-consumer ring of preallocated event slots.
+ *
+ * Producers reserve a contiguous range of positions with a single CAS on the tail and publish
+ * each slot through its sequence number, so posting never allocates and never waits on the
+ * consumer. The consumer reads published slots in order and releases them by advancing the head.
+ */
+class PendingWriteQueue {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+
+    /**
+     * A read-only view of pending events starting at the consumer cursor.
+     */
+    struct Span {
+        const Event* events;
+        //! The time each event was pushed, parallel to events.
+        const int64_t* enqueueTimesNs;
+        size_t size;
+    };
+
+    /**
+     * @param capacity The number of event slots, must be a power of two.
+     */
+    explicit PendingWriteQueue(size_t capacity);
+
+    /**
+     * Copy events into the ring. Safe to call from any number of threads.
+     *
+     * @param enqueueTimeNs The time to report for these events in peek.
+     *
+     * @return false if there was not enough room for all events, nothing is written then.
+     */
+    bool push(const Event* events, size_t count, int64_t enqueueTimeNs);
+
+    /**
+     * Get the longest published run of events at the head of the ring that does not wrap.
+     * Consumer only.
+     *
+     * @param max The maximum number of events to return.
+     *
+     * @return The readable events, may be empty while a producer is publishing.
+     */
+    Span peek(size_t max) const;
+
+    /**
+     * Advance the consumer cursor past count events previously returned by peek. Consumer only.
+     */
+    void pop(size_t count);
+
+    /**
+     * Reorder the first max published events so that those keep accepts come last, in their
+     * original order, and the rest come first. The caller can then pop the rest without losing
+     * the kept ones. Consumer only.
+     *
+     * @return The number of events not kept, now at the head of the ring.
+     */
+    size_t partitionHead(size_t max, bool (*keep)(const Event&));
+
+    /**
+     * Drop every published event. Slots a producer has reserved but not yet published stay
+     * queued, the producer still owns them. Consumer only.
+     */
+    void clear();
+
+    //! Whether the event at the head of the ring has been published. Consumer only.
+    bool readable() const;
+
+    //! The number of reserved slots, including those still being published.
+    size_t size() const;
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return mCapacity; }
+
+  private:
+    const size_t mCapacity;
+    const size_t mMask;
+
+    std::unique_ptr<Event[]> mEvents;
+    std::unique_ptr<int64_t[]> mEnqueueTimesNs;
+
+    //! Holds position + 1 once the slot at position has been published.
+    std::unique_ptr<std::atomic<uint64_t>[]> mSequence;
+
+    alignas(64) std::atomic<uint64_t> mTail = 0;
+    alignas(64) std::atomic<uint64_t> mHead = 0;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SensorListCache.h"
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <android-base/unique_fd.h>
+#include <log/log.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+constexpr uint32_t kMagic = 0x43534e53;  // "SNSC"
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t numSensors;
+    uint32_t stringsSize;
+};
+
+//! String fields are offsets into the string blob that follows the records.
+struct Record {
+    int32_t sensorHandle;
+    int32_t type;
+    uint32_t name;
+    uint32_t vendor;
+    uint32_t typeAsString;
+    uint32_t requiredPermission;
+    int32_t version;
+    float maxRange;
+    float resolution;
+    float power;
+    int32_t minDelay;
+    uint32_t fifoReservedEventCount;
+    uint32_t fifoMaxEventCount;
+    int32_t maxDelay;
+    uint32_t flags;
+};
+
+static_assert(sizeof(Header) == 24 && sizeof(Record) == 60, "cache layout changed, bump kVersion");
+
+//! Everywhere the loader may find a sub-HAL library, mirroring HalProxy's search order.
+const char* const kLibraryDirs[] = {
+        "",
+#ifdef __LP64__
+        "/vendor/lib64/", "/vendor/lib64/hw/", "/odm/lib64/", "/odm/lib64/hw/",
+#else
+        "/vendor/lib/", "/vendor/lib/hw/", "/odm/lib/", "/odm/lib/hw/",
+#endif
+};
+
+//! Inputs other than the sub-HAL libraries that change the final sensor list.
+const char* const kKeyProperties[] = {
+        "ro.vendor.build.fingerprint",
+        "ro.vendor.sensors.xiaomi.batching_emulation",
+};
+const char* const kKeyFiles[] = {
+        "/vendor/etc/sensors/xiaomi_sysfs_sensors.conf",
+};
+
+class Fnv1a {
+  public:
+    void add(const void* data, size_t size) {
+        const uint8_t* bytes = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < size; i++) {
+            mHash = (mHash ^ bytes[i]) * 0x100000001b3;
+        }
+    }
+
+    template <typename T>
+    void add(const T& value) {
+        add(&value, sizeof(value));
+    }
+
+    void add(const std::string& value) { add(value.c_str(), value.size() + 1); }
+
+    uint64_t get() const { return mHash; }
+
+  private:
+    uint64_t mHash = 0xcbf29ce484222325;
+};
+
+void addFileStat(Fnv1a* hash, const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        hash->add(false);
+        return;
+    }
+    hash->add(true);
+    hash->add(static_cast<uint64_t>(st.st_ino));
+    hash->add(static_cast<int64_t>(st.st_size));
+    hash->add(static_cast<int64_t>(st.st_mtim.tv_sec));
+    hash->add(static_cast<int64_t>(st.st_mtim.tv_nsec));
+}
+
+uint32_t appendString(std::string* strings, const std::string& value) {
+    uint32_t offset = static_cast<uint32_t>(strings->size());
+    strings->append(value.c_str(), value.size() + 1);
+    return offset;
+}
+
+}  // namespace
+
+uint64_t computeSensorListCacheKey(const std::vector<std::string>& libraries) {
+    Fnv1a hash;
+    hash.add(kVersion);
+    for (const char* property : kKeyProperties) {
+        hash.add(android::base::GetProperty(property, ""));
+    }
+    for (const char* file : kKeyFiles) {
+        addFileStat(&hash, file);
+    }
+    for (const std::string& library : libraries) {
+        hash.add(library);
+        for (const char* dir : kLibraryDirs) {
+            addFileStat(&hash, dir + library);
+        }
+    }
+    return hash.get();
+}
+
+bool readSensorListCache(const char* path, uint64_t key, std::vector<SensorInfo>* sensors) {
+    android::base::unique_fd fd(open(path, O_RDONLY | O_CLOEXEC));
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header))) {
+        return false;
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(map);
+    const Header* header = reinterpret_cast<const Header*>(data);
+    const Record* records = reinterpret_cast<const Record*>(data + sizeof(Header));
+    size_t recordsSize = sizeof(Record) * static_cast<size_t>(header->numSensors);
+    const char* strings = reinterpret_cast<const char*>(data + sizeof(Header));
+
+    bool valid = header->magic == kMagic && header->version == kVersion && header->key == key &&
+                 header->stringsSize > 0 &&
+                 size == sizeof(Header) + recordsSize + header->stringsSize;
+    if (valid) {
+        strings += recordsSize;
+        valid = strings[header->stringsSize - 1] == '\0';
+    }
+
+    // Every offset is below stringsSize and the blob ends in a NUL, so each string terminates.
+    auto string = [&](uint32_t offset) -> const char* {
+        if (offset >= header->stringsSize) {
+            valid = false;
+            return "";
+        }
+        return strings + offset;
+    };
+
+    if (valid) {
+        sensors->resize(header->numSensors);
+        for (uint32_t i = 0; i < header->numSensors && valid; i++) {
+            const Record& record = records[i];
+            SensorInfo& sensor = (*sensors)[i];
+            sensor.sensorHandle = record.sensorHandle;
+            sensor.type = static_cast<SensorType>(record.type);
+            sensor.name = string(record.name);
+            sensor.vendor = string(record.vendor);
+            sensor.typeAsString = string(record.typeAsString);
+            sensor.requiredPermission = string(record.requiredPermission);
+            sensor.version = record.version;
+            sensor.maxRange = record.maxRange;
+            sensor.resolution = record.resolution;
+            sensor.power = record.power;
+            sensor.minDelay = record.minDelay;
+            sensor.fifoReservedEventCount = record.fifoReservedEventCount;
+            sensor.fifoMaxEventCount = record.fifoMaxEventCount;
+            sensor.maxDelay = record.maxDelay;
+            sensor.flags = record.flags;
+        }
+        if (!valid) {
+            sensors->clear();
+        }
+    }
+
+    munmap(map, size);
+    if (!valid) {
+        ALOGW("Ignoring sensor list cache %s: stale or corrupt", path);
+    }
+    return valid;
+}
+
+bool writeSensorListCache(const char* path, uint64_t key,
+                          const std::map<int32_t, SensorInfo>& sensors) {
+    std::vector<Record> records;
+    records.reserve(sensors.size());
+    std::string strings;
+    for (const auto& [handle, sensor] : sensors) {
+        Record record = {};
+        record.sensorHandle = sensor.sensorHandle;
+        record.type = static_cast<int32_t>(sensor.type);
+        record.name = appendString(&strings, sensor.name);
+        record.vendor = appendString(&strings, sensor.vendor);
+        record.typeAsString = appendString(&strings, sensor.typeAsString);
+        record.requiredPermission = appendString(&strings, sensor.requiredPermission);
+        record.version = sensor.version;
+        record.maxRange = sensor.maxRange;
+        record.resolution = sensor.resolution;
+        record.power = sensor.power;
+        record.minDelay = sensor.minDelay;
+        record.fifoReservedEventCount = sensor.fifoReservedEventCount;
+        record.fifoMaxEventCount = sensor.fifoMaxEventCount;
+        record.maxDelay = sensor.maxDelay;
+        record.flags = sensor.flags;
+        records.push_back(record);
+    }
+    if (strings.empty()) {
+        strings.push_back('\0');
+    }
+
+    Header header = {kMagic, kVersion, key, static_cast<uint32_t>(records.size()),
+                     static_cast<uint32_t>(strings.size())};
+    std::string contents(reinterpret_cast<const char*>(&header), sizeof(header));
+    contents.append(reinterpret_cast<const char*>(records.data()), sizeof(Record) * records.size());
+    contents.append(strings);
+
+    std::string tmpPath = std::string(path) + ".tmp";
+    if (!android::base::WriteStringToFile(contents, tmpPath) ||
+        rename(tmpPath.c_str(), path) != 0) {
+        ALOGE("Failed to write sensor list cache %s: %s", path, strerror(errno));
+        unlink(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
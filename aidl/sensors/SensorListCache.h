@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/2.1/types.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * On-disk copy of the final, patched multihal sensor list. It lets the proxy answer
+ * getSensorsList before the sub-HAL libraries have finished loading.
+ *
+ * The file is a header, a fixed size record per sensor and a blob of NUL terminated strings the
+ * records point into. Everything is native endian and read straight out of an mmap.
+ */
+
+/**
+ * Compute the key a cache must carry to be used with the given sub-HAL libraries. It covers the
+ * library names, the size, mtime and inode of every file they could be loaded from, the sysfs
+ * sensor descriptor file, the vendor build fingerprint and the properties that reshape the list,
+ * so replacing any of them invalidates the cache.
+ */
+uint64_t computeSensorListCacheKey(const std::vector<std::string>& libraries);
+
+/**
+ * @return True if path holds a well formed cache of the current version with the given key, in
+ *     which case sensors is filled in handle order.
+ */
+bool readSensorListCache(const char* path, uint64_t key, std::vector<SensorInfo>* sensors);
+
+/**
+ * Atomically replace the cache at path with the given sensors.
+ */
+bool writeSensorListCache(const char* path, uint64_t key,
+                          const std::map<int32_t, SensorInfo>& sensors);
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SensorTable.h"
+#include "SubHalIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+/**
+ * Readers register in the count selected by the low bit of the epoch. synchronize() advances
+ * the epoch, so new readers go to the other count, and waits for the old one to drain.
+ */
+struct Epoch {
+    //! A reader count on a cache line of its own, so guards in the two epochs never share one.
+    struct alignas(64) ReaderCount {
+        std::atomic<uint64_t> count = 0;
+    };
+
+    std::atomic<uint64_t> epoch = 0;
+    ReaderCount numReaders[2];
+    std::mutex synchronizeMutex;
+};
+
+Epoch& getEpoch() {
+    static Epoch epoch;
+    return epoch;
+}
+
+}  // namespace
+
+SensorTable::ReadGuard::ReadGuard() {
+    Epoch& epoch = getEpoch();
+    while (true) {
+        uint64_t current = epoch.epoch.load();
+        mSlot = current & 1;
+        epoch.numReaders[mSlot].count.fetch_add(1);
+        // If the epoch moved before the count went up, synchronize() may already have looked at
+        // this count. Register again in the current one.
+        if (epoch.epoch.load() == current) {
+            return;
+        }
+        epoch.numReaders[mSlot].count.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+SensorTable::ReadGuard::~ReadGuard() {
+    getEpoch().numReaders[mSlot].count.fetch_sub(1, std::memory_order_release);
+}
+
+void SensorTable::synchronize() {
+    Epoch& epoch = getEpoch();
+    std::lock_guard<std::mutex> lock(epoch.synchronizeMutex);
+    // Every reader registered before this call confirmed the current epoch after registering.
+    // A previous call drained the other count, so only this epoch's count can hold them.
+    uint64_t previous = epoch.epoch.fetch_add(1);
+    while (epoch.numReaders[previous & 1].count.load() != 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+SensorTable::SensorTable(const std::map<int32_t, SensorInfo>& sensors,
+                         const std::map<int32_t, SensorInfo>& dynamicSensors) {
+    mSensors.reserve(sensors.size() + dynamicSensors.size());
+    for (const auto& [handle, sensor] : sensors) {
+        mSensors.push_back(sensor);
+    }
+    for (const auto& [handle, sensor] : dynamicSensors) {
+        mSensors.push_back(sensor);
+    }
+
+    // Size each sub-HAL's range by the largest dense local handle it uses.
+    std::vector<size_t> rangeSizes;
+    for (const SensorInfo& sensor : mSensors) {
+        size_t subHalIndex = extractSubHalIndex(sensor.sensorHandle);
+        int32_t localHandle = sensor.sensorHandle & kLocalHandleMask;
+        if (localHandle >= kMaxDenseLocalHandle) continue;
+        if (subHalIndex >= rangeSizes.size()) {
+            rangeSizes.resize(subHalIndex + 1, 0);
+        }
+        rangeSizes[subHalIndex] =
+                std::max(rangeSizes[subHalIndex], static_cast<size_t>(localHandle) + 1);
+    }
+
+    mSubHalOffsets.resize(rangeSizes.size() + 1, 0);
+    for (size_t i = 0; i < rangeSizes.size(); i++) {
+        mSubHalOffsets[i + 1] = mSubHalOffsets[i] + rangeSizes[i];
+    }
+    mDenseSlots.assign(mSubHalOffsets.back(), -1);
+
+    for (size_t i = 0; i < mSensors.size(); i++) {
+        int32_t sensorHandle = mSensors[i].sensorHandle;
+        size_t subHalIndex = extractSubHalIndex(sensorHandle);
+        int32_t localHandle = sensorHandle & kLocalHandleMask;
+        if (localHandle < kMaxDenseLocalHandle) {
+            mDenseSlots[mSubHalOffsets[subHalIndex] + localHandle] = static_cast<int32_t>(i);
+        } else {
+            mSparseSlots[sensorHandle] = i;
+        }
+    }
+    mRateLimits = std::make_unique<RateLimit[]>(mSensors.size());
+}
+
+int32_t SensorTable::findIndex(int32_t sensorHandle) const {
+    size_t subHalIndex = extractSubHalIndex(sensorHandle);
+    size_t localHandle = static_cast<size_t>(sensorHandle & kLocalHandleMask);
+    if (subHalIndex + 1 < mSubHalOffsets.size()) {
+        size_t offset = mSubHalOffsets[subHalIndex];
+        if (localHandle < mSubHalOffsets[subHalIndex + 1] - offset) {
+            return mDenseSlots[offset + localHandle];
+        }
+    }
+    if (mSparseSlots.empty()) return -1;
+    auto sparse = mSparseSlots.find(sensorHandle);
+    return sparse != mSparseSlots.end() ? static_cast<int32_t>(sparse->second) : -1;
+}
+
+const SensorTable::SensorInfo* SensorTable::find(int32_t sensorHandle) const {
+    int32_t index = findIndex(sensorHandle);
+    return index < 0 ? nullptr : &mSensors[index];
+}
+
+SensorTable::RateLimit* SensorTable::findRateLimit(int32_t sensorHandle) const {
+    int32_t index = findIndex(sensorHandle);
+    return index < 0 ? nullptr : &mRateLimits[index];
+}
+
+void SensorTable::copyRateLimits(const SensorTable& other) {
+    for (size_t i = 0; i < mSensors.size(); i++) {
+        const RateLimit* otherRateLimit = other.findRateLimit(mSensors[i].sensorHandle);
+        if (otherRateLimit != nullptr) {
+            mRateLimits[i].samplingPeriodNs.store(
+                    otherRateLimit->samplingPeriodNs.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+            mRateLimits[i].eventsDropped.store(
+                    otherRateLimit->eventsDropped.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
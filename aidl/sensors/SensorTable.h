@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/2.1/types.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Immutable snapshot of every sensor known to the proxy, addressed by (sub-HAL index, local
+ * handle) so a lookup is two array indexes. HalProxy publishes a new snapshot whenever the
+ * sensor set changes and readers never take a lock.
+ *
+ * Readers hold a ReadGuard while they use a snapshot or anything they found in it. A replaced
+ * snapshot is freed after synchronize() has waited out the guards that could still see it.
+ *
+ * The sensor info never changes once built. Each sensor also has rate limiting state, which
+ * HalProxy updates with atomics.
+ */
+class SensorTable {
+  public:
+    using SensorInfo = ::android::hardware::sensors::V2_1::SensorInfo;
+
+    SensorTable(const std::map<int32_t, SensorInfo>& sensors,
+                const std::map<int32_t, SensorInfo>& dynamicSensors);
+
+    /**
+     * Marks the calling thread as reading snapshots for the guard's lifetime. Entering and
+     * leaving are a few atomic operations and guards nest.
+     */
+    class ReadGuard {
+      public:
+        ReadGuard();
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+      private:
+        //! The reader count this guard registered in.
+        size_t mSlot;
+    };
+
+    /**
+     * Wait until every ReadGuard that existed when this was called is gone. A snapshot that was
+     * unpublished before the call can be freed afterwards. Must not be called while the calling
+     * thread holds a ReadGuard.
+     */
+    static void synchronize();
+
+    /**
+     * @param sensorHandle A sensor handle with the subhal index set.
+     *
+     * @return The sensor info or nullptr if the handle is unknown.
+     */
+    const SensorInfo* find(int32_t sensorHandle) const;
+
+    /**
+     * The sampling period last requested for a sensor, the timestamp of its last event, whether
+     * HalProxy drops its next event while decimating and how many of its events were dropped.
+     */
+    struct RateLimit {
+        std::atomic<int64_t> samplingPeriodNs = 0;
+        std::atomic<int64_t> lastTimestampNs = INT64_MIN;
+        std::atomic<uint8_t> decimationDropNext = 0;
+        std::atomic<uint64_t> eventsDropped = 0;
+    };
+
+    /**
+     * @return The rate limiting state of the sensor or nullptr if the handle is unknown.
+     */
+    RateLimit* findRateLimit(int32_t sensorHandle) const;
+
+    /**
+     * Carry the requested sampling periods and drop counts of the sensors both tables know over
+     * from other. Drops counted in other after this returns are lost.
+     */
+    void copyRateLimits(const SensorTable& other);
+
+    size_t size() const { return mSensors.size(); }
+
+    //! @return The i-th sensor of the table, for i < size().
+    const SensorInfo& sensorAt(size_t i) const { return mSensors[i]; }
+
+    //! @return The rate limiting state of sensorAt(i).
+    RateLimit& rateLimitAt(size_t i) const { return mRateLimits[i]; }
+
+  private:
+    //! @return The index of the sensor in mSensors or -1 if the handle is unknown.
+    int32_t findIndex(int32_t sensorHandle) const;
+
+    //! Local handles at or above this are looked up in mSparseSlots instead.
+    static constexpr int32_t kMaxDenseLocalHandle = 4096;
+
+    std::vector<SensorInfo> mSensors;
+
+    //! Start of each sub-HAL's range in mDenseSlots, with one extra entry for the end.
+    std::vector<size_t> mSubHalOffsets;
+
+    //! Index into mSensors or -1 for every (sub-HAL, local handle) pair.
+    std::vector<int32_t> mDenseSlots;
+
+    //! Sensors with a local handle too large for the dense table.
+    std::map<int32_t, size_t> mSparseSlots;
+
+    //! One entry per sensor in mSensors.
+    std::unique_ptr<RateLimit[]> mRateLimits;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+//! The proxy stores the index of a sensor's sub-HAL in the bits of its handle above this.
+constexpr int32_t kBitsAfterSubHalIndex = 24;
+
+//! The bits of a sensor handle that were chosen by the sub-HAL.
+constexpr int32_t kLocalHandleMask = (1 << kBitsAfterSubHalIndex) - 1;
+
+/**
+ * Set the subhal index as first byte of sensor handle and return this modified version.
+ *
+ * @param sensorHandle The sensor handle to modify.
+ * @param subHalIndex The index in the hal proxy of the sub hal this sensor belongs to.
+ *
+ * @return The modified sensor handle.
+ */
+inline int32_t setSubHalIndex(int32_t sensorHandle, size_t subHalIndex) {
+    return sensorHandle | (static_cast<int32_t>(subHalIndex) << kBitsAfterSubHalIndex);
+}
+
+/**
+ * Extract the subHalIndex from sensorHandle.
+ *
+ * @param sensorHandle The sensorHandle to extract from.
+ *
+ * @return The subhal index.
+ */
+inline size_t extractSubHalIndex(int32_t sensorHandle) {
+    return static_cast<uint32_t>(sensorHandle) >> kBitsAfterSubHalIndex;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
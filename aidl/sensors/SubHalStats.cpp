@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SubHalStats.h"
+
+#include <algorithm>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+void SubHalStats::recordLatency(int64_t latencyNs, uint64_t count) {
+    uint64_t latencyUs = static_cast<uint64_t>(std::max<int64_t>(latencyNs, 0)) / 1000;
+    size_t bucket = latencyUs == 0 ? 0 : 64 - __builtin_clzll(latencyUs);
+    bucket = std::min(bucket, kNumLatencyBuckets - 1);
+    latencyHistogram[bucket].fetch_add(count, std::memory_order_relaxed);
+}
+
+void SubHalStats::dump(std::ostream& stream) const {
+    stream << "  Events posted: " << eventsPosted.load(std::memory_order_relaxed) << std::endl;
+    stream << "  Events dropped: " << eventsDropped.load(std::memory_order_relaxed) << std::endl;
+    stream << "  Events above the requested rate: "
+           << eventsDecimated.load(std::memory_order_relaxed) << std::endl;
+    stream << "  Wake-up events: " << wakeupEvents.load(std::memory_order_relaxed) << std::endl;
+    stream << "  Wakelock held: " << wakelockHoldNs.load(std::memory_order_relaxed) / 1000000
+           << " ms" << std::endl;
+    stream << "  Callback to FMQ write latency:" << std::endl;
+    for (size_t i = 0; i < kNumLatencyBuckets; i++) {
+        uint64_t count = latencyHistogram[i].load(std::memory_order_relaxed);
+        if (count == 0) continue;
+        if (i == 0) {
+            stream << "    < 1 us: ";
+        } else if (i == kNumLatencyBuckets - 1) {
+            stream << "    >= " << (UINT64_C(1) << (i - 1)) << " us: ";
+        } else {
+            stream << "    " << (UINT64_C(1) << (i - 1)) << " - " << (UINT64_C(1) << i)
+                   << " us: ";
+        }
+        stream << count << std::endl;
+    }
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Event and wakelock counters for one sub-HAL. Everything is a relaxed atomic so recording can
+ * stay enabled on production builds.
+ */
+struct SubHalStats {
+    //! Latency buckets are powers of two in microseconds, the last one is open ended.
+    static constexpr size_t kNumLatencyBuckets = 20;
+
+    std::atomic<uint64_t> eventsPosted = 0;
+    std::atomic<uint64_t> eventsDropped = 0;
+    std::atomic<uint64_t> eventsDecimated = 0;
+    std::atomic<uint64_t> wakeupEvents = 0;
+    std::atomic<uint64_t> wakelockHoldNs = 0;
+
+    //! Time from the sub-HAL callback to the event FMQ write.
+    std::atomic<uint64_t> latencyHistogram[kNumLatencyBuckets] = {};
+
+    void recordLatency(int64_t latencyNs, uint64_t count);
+
+    void dump(std::ostream& stream) const;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "HalProxy.h"
+#include "tests/FakeFramework.h"
+#include "tests/FakeSubHal.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+constexpr int32_t kAccelHandle = 1;
+constexpr int32_t kGestureHandle = 2;
+constexpr size_t kEventsPerBatch = 16;
+constexpr size_t kBatchesPerIteration = 256;
+
+/**
+ * A proxy over numSubHals fake sub-HALs, each with an IMU sensor and a wake-up gesture, with a
+ * framework thread draining the event FMQ.
+ */
+struct ProxyUnderLoad {
+    explicit ProxyUnderLoad(size_t numSubHals) {
+        for (size_t i = 0; i < numSubHals; i++) {
+            subHals.push_back(std::make_unique<FakeSubHal>(std::vector<SensorInfo>{
+                    makeSensorInfo(kAccelHandle, SensorType::ACCELEROMETER,
+                                   static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE)),
+                    makeSensorInfo(kGestureHandle, SensorType::PICK_UP_GESTURE,
+                                   static_cast<uint32_t>(SensorFlagBits::WAKE_UP) |
+                                           static_cast<uint32_t>(
+                                                   SensorFlagBits::ONE_SHOT_MODE))}));
+            subHalPointers.push_back(subHals.back().get());
+        }
+        halProxy = std::make_unique<HalProxy>(subHalsV2_0, subHalPointers);
+        framework.initialize(halProxy.get());
+        framework.startReading(0 /* readDelayNs */, false /* keepEvents */);
+    }
+
+    ~ProxyUnderLoad() {
+        framework.stopReading();
+        halProxy.reset();
+    }
+
+    std::vector<std::unique_ptr<FakeSubHal>> subHals;
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHalPointers;
+    std::unique_ptr<HalProxy> halProxy;
+    FakeFramework framework;
+};
+
+/**
+ * Post kBatchesPerIteration IMU batches from one thread per sub-HAL, every 32nd batch with a
+ * wake-up gesture at its end, and record how long each postEvents call took.
+ */
+void postBatches(ProxyUnderLoad* proxy, int64_t* timestamp,
+                 std::vector<std::vector<int64_t>>* latenciesNs) {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < proxy->subHals.size(); i++) {
+        threads.emplace_back([&, i, firstTimestamp = *timestamp] {
+            FakeSubHal* subHal = proxy->subHals[i].get();
+            std::vector<Event> batch(kEventsPerBatch,
+                                     makeEvent(kAccelHandle, SensorType::ACCELEROMETER, 0));
+            std::vector<Event> wakeBatch = batch;
+            wakeBatch.back() = makeEvent(kGestureHandle, SensorType::PICK_UP_GESTURE, 0);
+            wakeBatch.back().u.scalar = 1;
+            int64_t eventTimestamp = firstTimestamp;
+            for (size_t b = 0; b < kBatchesPerIteration; b++) {
+                std::vector<Event>& events = b % 32 == 31 ? wakeBatch : batch;
+                for (Event& event : events) {
+                    event.timestamp = eventTimestamp++;
+                }
+                int64_t start = getTimeNow();
+                subHal->postEvents(events);
+                (*latenciesNs)[i].push_back(getTimeNow() - start);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    *timestamp += kBatchesPerIteration * kEventsPerBatch;
+}
+
+}  // namespace
+
+// Events per second delivered from N sub-HAL threads into a framework FMQ that is drained as
+// fast as possible, the share dropped on the way and the time a sub-HAL thread spends inside
+// postEvents.
+static void BM_PostEventsFromSubHals(benchmark::State& state) {
+    ProxyUnderLoad proxy(state.range(0));
+    std::vector<std::vector<int64_t>> latenciesNs(proxy.subHals.size());
+    int64_t timestamp = 0;
+    for (auto _ : state) {
+        postBatches(&proxy, &timestamp, &latenciesNs);
+    }
+    // Events the pending write queue had no room for are dropped, wait until the rest is read.
+    size_t numEventsPosted = state.iterations() * proxy.subHals.size() * kBatchesPerIteration *
+                             kEventsPerBatch;
+    size_t numEventsRead = 0;
+    while (!proxy.framework.waitForEvents(numEventsPosted, 100000000 /* 100 ms */) &&
+           proxy.framework.getNumEventsRead() != numEventsRead) {
+        numEventsRead = proxy.framework.getNumEventsRead();
+    }
+    numEventsRead = proxy.framework.getNumEventsRead();
+
+    std::vector<int64_t> allLatenciesNs;
+    for (const std::vector<int64_t>& threadLatenciesNs : latenciesNs) {
+        allLatenciesNs.insert(allLatenciesNs.end(), threadLatenciesNs.begin(),
+                              threadLatenciesNs.end());
+    }
+    std::sort(allLatenciesNs.begin(), allLatenciesNs.end());
+    state.SetItemsProcessed(numEventsRead);
+    state.counters["dropped_pct"] = 100.0 * (numEventsPosted - numEventsRead) / numEventsPosted;
+    state.counters["p50_enqueue_us"] = allLatenciesNs[allLatenciesNs.size() / 2] / 1000.0;
+    state.counters["p99_enqueue_us"] = allLatenciesNs[allLatenciesNs.size() * 99 / 100] / 1000.0;
+}
+BENCHMARK(BM_PostEventsFromSubHals)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
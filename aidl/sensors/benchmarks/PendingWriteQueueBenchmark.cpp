@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PendingWriteQueue.h"
+
+#include <benchmark/benchmark.h>
+#include <fmq/MessageQueue.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using Event = PendingWriteQueue::Event;
+using EventMessageQueue = MessageQueue<Event, kSynchronizedReadWrite>;
+
+//! Small enough that a large flush takes many writes, like a framework FMQ of a few quanta.
+constexpr size_t kLocalQueueSize = 128;
+
+std::vector<Event> makeBatch(size_t size) {
+    std::vector<Event> events(size);
+    for (size_t i = 0; i < size; i++) {
+        events[i].sensorHandle = 1;
+        events[i].sensorType = SensorType::ACCELEROMETER;
+        events[i].timestamp = static_cast<int64_t>(i);
+    }
+    return events;
+}
+
+/**
+ * Write one quantum to the local queue and read it back out, standing in for the framework
+ * reader so the next write finds room.
+ */
+void writeQuantum(EventMessageQueue* queue, const Event* events, size_t count,
+                  std::vector<Event>* readBuffer) {
+    queue->write(events, count);
+    queue->read(readBuffer->data(), count);
+}
+
+}  // namespace
+
+// The drain handlePendingWrites used before the cursor: erase each written quantum from the
+// front of a vector, which moves the whole tail every time.
+static void BM_FlushBatchEraseFront(benchmark::State& state) {
+    const std::vector<Event> batch = makeBatch(state.range(0));
+    EventMessageQueue queue(kLocalQueueSize);
+    std::vector<Event> readBuffer(kLocalQueueSize);
+    for (auto _ : state) {
+        std::vector<Event> pendingWriteEvents(batch);
+        while (!pendingWriteEvents.empty()) {
+            size_t count = std::min(pendingWriteEvents.size(), queue.getQuantumCount());
+            writeQuantum(&queue, pendingWriteEvents.data(), count, &readBuffer);
+            pendingWriteEvents.erase(pendingWriteEvents.begin(),
+                                     pendingWriteEvents.begin() + count);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_FlushBatchEraseFront)->Arg(1000)->Arg(10000);
+
+static void BM_FlushBatchCursor(benchmark::State& state) {
+    const std::vector<Event> batch = makeBatch(state.range(0));
+    EventMessageQueue queue(kLocalQueueSize);
+    std::vector<Event> readBuffer(kLocalQueueSize);
+    PendingWriteQueue pendingWriteEvents(16384);
+    for (auto _ : state) {
+        pendingWriteEvents.push(batch.data(), batch.size(), 0 /* enqueueTimeNs */);
+        for (PendingWriteQueue::Span pending = pendingWriteEvents.peek(queue.getQuantumCount());
+             pending.size > 0; pending = pendingWriteEvents.peek(queue.getQuantumCount())) {
+            writeQuantum(&queue, pending.events, pending.size, &readBuffer);
+            pendingWriteEvents.pop(pending.size);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_FlushBatchCursor)->Arg(1000)->Arg(10000);
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
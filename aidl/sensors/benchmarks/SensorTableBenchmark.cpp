@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SensorTable.h"
+#include "SubHalIndex.h"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <mutex>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+constexpr int32_t kNumSensors = 64;
+constexpr int32_t kNumStaticSensors = 56;
+constexpr uint32_t kWakeUp = static_cast<uint32_t>(V1_0::SensorFlagBits::WAKE_UP);
+
+/**
+ * 64 sensors spread over two sub-HALs, the last few of them dynamic, as the proxy sees them.
+ */
+struct SyntheticSensors {
+    SyntheticSensors() {
+        for (int32_t i = 0; i < kNumSensors; i++) {
+            SensorInfo sensor = {};
+            sensor.sensorHandle = setSubHalIndex(i / 2 + 1, i % 2);
+            sensor.flags = i % 3 == 0 ? kWakeUp : 0;
+            handles.push_back(sensor.sensorHandle);
+            (i < kNumStaticSensors ? sensors : dynamicSensors)[sensor.sensorHandle] = sensor;
+        }
+    }
+
+    std::map<int32_t, SensorInfo> sensors;
+    std::map<int32_t, SensorInfo> dynamicSensors;
+    std::vector<int32_t> handles;
+};
+
+const SyntheticSensors& getSyntheticSensors() {
+    static const SyntheticSensors sensors;
+    return sensors;
+}
+
+/**
+ * The lookup HalProxy did before SensorTable: the static map, then the dynamic map, both under
+ * the mutex that guards dynamic sensor changes.
+ */
+class MapSensorLookup {
+  public:
+    uint32_t getFlags(int32_t sensorHandle) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        const SyntheticSensors& synthetic = getSyntheticSensors();
+        auto sensor = synthetic.sensors.find(sensorHandle);
+        if (sensor != synthetic.sensors.end()) return sensor->second.flags;
+        sensor = synthetic.dynamicSensors.find(sensorHandle);
+        return sensor != synthetic.dynamicSensors.end() ? sensor->second.flags : 0;
+    }
+
+  private:
+    std::mutex mMutex;
+};
+
+}  // namespace
+
+// Each iteration resolves one event per sensor, the way postEvents walks a batch.
+static void BM_MapAndMutexLookup(benchmark::State& state) {
+    static MapSensorLookup lookup;
+    const std::vector<int32_t>& handles = getSyntheticSensors().handles;
+    for (auto _ : state) {
+        uint32_t wakeUpEvents = 0;
+        for (int32_t sensorHandle : handles) {
+            wakeUpEvents += lookup.getFlags(sensorHandle) & kWakeUp;
+        }
+        benchmark::DoNotOptimize(wakeUpEvents);
+    }
+    state.SetItemsProcessed(state.iterations() * handles.size());
+}
+BENCHMARK(BM_MapAndMutexLookup)->ThreadRange(1, 4);
+
+static void BM_SensorTableLookup(benchmark::State& state) {
+    const SyntheticSensors& synthetic = getSyntheticSensors();
+    static const SensorTable table(synthetic.sensors, synthetic.dynamicSensors);
+    for (auto _ : state) {
+        uint32_t wakeUpEvents = 0;
+        SensorTable::ReadGuard guard;
+        for (int32_t sensorHandle : synthetic.handles) {
+            wakeUpEvents += table.find(sensorHandle)->flags & kWakeUp;
+        }
+        benchmark::DoNotOptimize(wakeUpEvents);
+    }
+    state.SetItemsProcessed(state.iterations() * synthetic.handles.size());
+}
+BENCHMARK(BM_SensorTableLookup)->ThreadRange(1, 4);
+
+// A guard per event, as sub-HAL callbacks on different threads take them.
+static void BM_SensorTableGuardPerLookup(benchmark::State& state) {
+    const SyntheticSensors& synthetic = getSyntheticSensors();
+    static const SensorTable table(synthetic.sensors, synthetic.dynamicSensors);
+    for (auto _ : state) {
+        uint32_t wakeUpEvents = 0;
+        for (int32_t sensorHandle : synthetic.handles) {
+            SensorTable::ReadGuard guard;
+            wakeUpEvents += table.find(sensorHandle)->flags & kWakeUp;
+        }
+        benchmark::DoNotOptimize(wakeUpEvents);
+    }
+    state.SetItemsProcessed(state.iterations() * synthetic.handles.size());
+}
+BENCHMARK(BM_SensorTableGuardPerLookup)->ThreadRange(1, 4);
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "EventBatcher.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using Event = EventBatcher::Event;
+
+constexpr int32_t kBatchingSensor = 1;
+constexpr int32_t kOtherSensor = 2;
+
+Event makeEvent(int32_t sensorHandle, int64_t timestamp,
+                SensorType sensorType = SensorType::ACCELEROMETER) {
+    Event event = {};
+    event.sensorHandle = sensorHandle;
+    event.sensorType = sensorType;
+    event.timestamp = timestamp;
+    return event;
+}
+
+std::vector<int64_t> timestamps(const std::vector<Event>& events) {
+    std::vector<int64_t> result;
+    for (const Event& event : events) {
+        result.push_back(event.timestamp);
+    }
+    return result;
+}
+
+class EventBatcherTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mBatcher.setSensors({kBatchingSensor});
+        mBatcher.setReportLatency(kBatchingSensor, 100, mSink);
+    }
+
+    EventBatcher mBatcher;
+    std::vector<Event> mSunk;
+    EventBatcher::Sink mSink = [this](const std::vector<Event>& events) {
+        mSunk.insert(mSunk.end(), events.begin(), events.end());
+    };
+};
+
+}  // namespace
+
+TEST_F(EventBatcherTest, HoldsBackUntilTheReportLatencyPassed) {
+    std::vector<Event> events = {makeEvent(kBatchingSensor, 1), makeEvent(kOtherSensor, 2)};
+    EXPECT_TRUE(mBatcher.process(&events, 1000));
+    EXPECT_EQ(std::vector<int64_t>({2}), timestamps(events));
+    EXPECT_EQ(1100, mBatcher.nextDeadline());
+
+    mBatcher.takeDue(1099, mSink);
+    EXPECT_TRUE(mSunk.empty());
+    mBatcher.takeDue(1100, mSink);
+    EXPECT_EQ(std::vector<int64_t>({1}), timestamps(mSunk));
+    EXPECT_EQ(INT64_MAX, mBatcher.nextDeadline());
+}
+
+TEST_F(EventBatcherTest, MetaDataFollowsTheBatch) {
+    std::vector<Event> events = {makeEvent(kBatchingSensor, 1), makeEvent(kBatchingSensor, 2)};
+    mBatcher.process(&events, 1000);
+    EXPECT_TRUE(events.empty());
+
+    events = {makeEvent(kBatchingSensor, 3, SensorType::META_DATA)};
+    mBatcher.process(&events, 1001);
+    EXPECT_EQ(std::vector<int64_t>({1, 2, 3}), timestamps(events));
+}
+
+TEST_F(EventBatcherTest, EventsAfterAReleaseInTheSameCallAreNotHeldBack) {
+    std::vector<Event> events = {makeEvent(kBatchingSensor, 1),
+                                 makeEvent(kBatchingSensor, 2, SensorType::META_DATA),
+                                 makeEvent(kBatchingSensor, 3)};
+    mBatcher.process(&events, 1000);
+    EXPECT_EQ(std::vector<int64_t>({1, 2, 3}), timestamps(events));
+
+    // Nothing is left for a flush to queue ahead of the events the caller still has to write.
+    mBatcher.flushSensor(kBatchingSensor, mSink);
+    EXPECT_TRUE(mSunk.empty());
+
+    events = {makeEvent(kBatchingSensor, 4)};
+    mBatcher.process(&events, 1001);
+    EXPECT_TRUE(events.empty());
+}
+
+TEST_F(EventBatcherTest, FullBatchGoesOutRightAway) {
+    std::vector<Event> events;
+    for (uint32_t i = 0; i < EventBatcher::kMaxBatchSize; i++) {
+        events.push_back(makeEvent(kBatchingSensor, i));
+    }
+    mBatcher.process(&events, 1000);
+    EXPECT_EQ(EventBatcher::kMaxBatchSize, events.size());
+}
+
+TEST_F(EventBatcherTest, LoweringTheLatencyFlushesToTheSink) {
+    std::vector<Event> events = {makeEvent(kBatchingSensor, 1)};
+    mBatcher.process(&events, 1000);
+    mBatcher.setReportLatency(kBatchingSensor, 0, mSink);
+    EXPECT_EQ(std::vector<int64_t>({1}), timestamps(mSunk));
+    EXPECT_FALSE(mBatcher.active());
+
+    events = {makeEvent(kBatchingSensor, 2)};
+    mBatcher.process(&events, 1001);
+    EXPECT_EQ(std::vector<int64_t>({2}), timestamps(events));
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+
+#include <chrono>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::hardware::sensors::V2_0::EventQueueFlagBits;
+using ::android::hardware::sensors::V2_0::WakeLockQueueFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+class FakeFramework::Callback : public V2_1::ISensorsCallback {
+  public:
+    Return<void> onDynamicSensorsConnected(
+            const hidl_vec<V1_0::SensorInfo>& /* dynamicSensorsAdded */) override {
+        return Void();
+    }
+
+    Return<void> onDynamicSensorsConnected_2_1(
+            const hidl_vec<SensorInfo>& dynamicSensorsAdded) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mConnected.insert(mConnected.end(), dynamicSensorsAdded.begin(),
+                          dynamicSensorsAdded.end());
+        return Void();
+    }
+
+    Return<void> onDynamicSensorsDisconnected(
+            const hidl_vec<int32_t>& dynamicSensorHandlesRemoved) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDisconnected.insert(mDisconnected.end(), dynamicSensorHandlesRemoved.begin(),
+                             dynamicSensorHandlesRemoved.end());
+        return Void();
+    }
+
+    std::mutex mMutex;
+    std::vector<SensorInfo> mConnected;
+    std::vector<int32_t> mDisconnected;
+};
+
+FakeFramework::FakeFramework(size_t eventQueueSize)
+    : mEventQueue(std::make_unique<EventMessageQueue>(eventQueueSize, true)),
+      mWakeLockQueue(std::make_unique<WakeLockMessageQueue>(eventQueueSize, true)),
+      mCallback(new Callback()) {
+    EventFlag::createEventFlag(mEventQueue->getEventFlagWord(), &mEventQueueFlag);
+    EventFlag::createEventFlag(mWakeLockQueue->getEventFlagWord(), &mWakeLockQueueFlag);
+}
+
+FakeFramework::~FakeFramework() {
+    stopReading();
+    EventFlag::deleteEventFlag(&mEventQueueFlag);
+    EventFlag::deleteEventFlag(&mWakeLockQueueFlag);
+}
+
+V1_0::Result FakeFramework::initialize(HalProxy* halProxy) {
+    mHalProxy = halProxy;
+    return halProxy->initialize_2_1(*mEventQueue->getDesc(), *mWakeLockQueue->getDesc(),
+                                    mCallback);
+}
+
+std::vector<FakeFramework::Event> FakeFramework::readEvents(size_t count, int64_t timeoutNs) {
+    std::vector<Event> events;
+    int64_t deadline = getTimeNow() + timeoutNs;
+    while (events.size() < count) {
+        int64_t now = getTimeNow();
+        if (now >= deadline) break;
+        readAvailable(&events, deadline - now);
+    }
+    return events;
+}
+
+void FakeFramework::startReading(int64_t readDelayNs, bool keepEvents) {
+    mReading = true;
+    mReadThread = std::thread([=] { readLoop(readDelayNs, keepEvents); });
+}
+
+void FakeFramework::stopReading() {
+    mReading = false;
+    if (mReadThread.joinable()) {
+        mEventQueueFlag->wake(static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS));
+        mReadThread.join();
+    }
+}
+
+bool FakeFramework::waitForEvents(size_t count, int64_t timeoutNs) {
+    std::unique_lock<std::mutex> lock(mReadEventsMutex);
+    return mReadEventsCV.wait_for(lock, std::chrono::nanoseconds(timeoutNs),
+                                  [&] { return mNumEventsRead >= count; });
+}
+
+size_t FakeFramework::getNumEventsRead() {
+    std::lock_guard<std::mutex> lock(mReadEventsMutex);
+    return mNumEventsRead;
+}
+
+size_t FakeFramework::getNumReads() {
+    std::lock_guard<std::mutex> lock(mReadEventsMutex);
+    return mNumReads;
+}
+
+std::vector<std::pair<FakeFramework::Event, int64_t>> FakeFramework::takeEvents() {
+    std::lock_guard<std::mutex> lock(mReadEventsMutex);
+    return std::move(mReadEvents);
+}
+
+void FakeFramework::ackWakeupEvents(uint32_t count) {
+    mWakeLockQueue->writeBlocking(&count, 1, 0 /* readNotification */,
+                                  static_cast<uint32_t>(WakeLockQueueFlagBits::DATA_WRITTEN),
+                                  0 /* timeOutNanos */, mWakeLockQueueFlag);
+}
+
+std::vector<FakeFramework::SensorInfo> FakeFramework::getConnectedDynamicSensors() {
+    std::lock_guard<std::mutex> lock(mCallback->mMutex);
+    return mCallback->mConnected;
+}
+
+std::vector<int32_t> FakeFramework::getDisconnectedDynamicSensors() {
+    std::lock_guard<std::mutex> lock(mCallback->mMutex);
+    return mCallback->mDisconnected;
+}
+
+size_t FakeFramework::readAvailable(std::vector<Event>* events, int64_t timeoutNs) {
+    if (mEventQueue->availableToRead() == 0) {
+        uint32_t eventFlagState = 0;
+        mEventQueueFlag->wait(static_cast<uint32_t>(EventQueueFlagBits::READ_AND_PROCESS),
+                              &eventFlagState, timeoutNs, true /* retry */);
+    }
+    size_t numToRead = mEventQueue->availableToRead();
+    if (numToRead == 0) {
+        return 0;
+    }
+    size_t start = events->size();
+    events->resize(start + numToRead);
+    if (!mEventQueue->read(events->data() + start, numToRead)) {
+        events->resize(start);
+        return 0;
+    }
+    mEventQueueFlag->wake(static_cast<uint32_t>(EventQueueFlagBits::EVENTS_READ));
+
+    if (mAutoAck) {
+        uint32_t numWakeupEvents = 0;
+        SensorTable::ReadGuard guard;
+        for (size_t i = start; i < events->size(); i++) {
+            if (mHalProxy->getSensorInfo((*events)[i].sensorHandle).flags &
+                V1_0::SensorFlagBits::WAKE_UP) {
+                numWakeupEvents++;
+            }
+        }
+        if (numWakeupEvents > 0) {
+            ackWakeupEvents(numWakeupEvents);
+        }
+    }
+    return numToRead;
+}
+
+void FakeFramework::readLoop(int64_t readDelayNs, bool keepEvents) {
+    std::vector<Event> events;
+    while (mReading) {
+        events.clear();
+        if (readAvailable(&events, 100000000 /* 100 ms */) == 0) {
+            continue;
+        }
+        int64_t now = getTimeNow();
+        {
+            std::lock_guard<std::mutex> lock(mReadEventsMutex);
+            for (size_t i = 0; keepEvents && i < events.size(); i++) {
+                mReadEvents.emplace_back(events[i], now);
+            }
+            mNumEventsRead += events.size();
+            mNumReads++;
+        }
+        mReadEventsCV.notify_all();
+        if (readDelayNs > 0) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(readDelayNs));
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "HalProxy.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * The sensor service end of a HalProxy: owns the event and wake lock FMQs, reads events the way
+ * the framework does and acknowledges wake-up events once read.
+ */
+class FakeFramework {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+    using SensorInfo = ::android::hardware::sensors::V2_1::SensorInfo;
+
+    static constexpr size_t kDefaultEventQueueSize = 256;
+
+    explicit FakeFramework(size_t eventQueueSize = kDefaultEventQueueSize);
+    ~FakeFramework();
+
+    V1_0::Result initialize(HalProxy* halProxy);
+
+    /**
+     * Read until count events arrived or the timeout passed. Only while no reader thread runs.
+     *
+     * @return The events read, in order.
+     */
+    std::vector<Event> readEvents(size_t count, int64_t timeoutNs);
+
+    /**
+     * Keep reading on a thread of its own, delaying every read by readDelayNs to stand in for a
+     * busy framework.
+     *
+     * @param keepEvents Whether to keep the events read for takeEvents or only count them.
+     */
+    void startReading(int64_t readDelayNs = 0, bool keepEvents = true);
+
+    void stopReading();
+
+    /**
+     * Wait until the reader thread has read count events in total or the timeout passed.
+     *
+     * @return Whether count events were read.
+     */
+    bool waitForEvents(size_t count, int64_t timeoutNs);
+
+    size_t getNumEventsRead();
+
+    //! How many times the reader thread woke up to events in the FMQ.
+    size_t getNumReads();
+
+    //! Every event the reader thread has read so far, with the time each read returned.
+    std::vector<std::pair<Event, int64_t>> takeEvents();
+
+    //! Tell the proxy the framework is done with count wake-up events.
+    void ackWakeupEvents(uint32_t count);
+
+    //! Whether acknowledgements are sent for wake-up events as soon as they are read.
+    void setAutoAck(bool autoAck) { mAutoAck = autoAck; }
+
+    std::vector<SensorInfo> getConnectedDynamicSensors();
+
+    std::vector<int32_t> getDisconnectedDynamicSensors();
+
+  private:
+    using EventMessageQueue = MessageQueue<Event, kSynchronizedReadWrite>;
+    using WakeLockMessageQueue = MessageQueue<uint32_t, kSynchronizedReadWrite>;
+
+    class Callback;
+
+    //! Read whatever is available, waiting up to timeoutNs for something to arrive.
+    size_t readAvailable(std::vector<Event>* events, int64_t timeoutNs);
+
+    void readLoop(int64_t readDelayNs, bool keepEvents);
+
+    std::unique_ptr<EventMessageQueue> mEventQueue;
+    std::unique_ptr<WakeLockMessageQueue> mWakeLockQueue;
+    EventFlag* mEventQueueFlag = nullptr;
+    EventFlag* mWakeLockQueueFlag = nullptr;
+    sp<Callback> mCallback;
+
+    HalProxy* mHalProxy = nullptr;
+    bool mAutoAck = true;
+
+    std::thread mReadThread;
+    std::atomic_bool mReading = false;
+    std::mutex mReadEventsMutex;
+    std::condition_variable mReadEventsCV;
+    std::vector<std::pair<Event, int64_t>> mReadEvents;
+    size_t mNumEventsRead = 0;
+    size_t mNumReads = 0;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakePower.h"
+
+#include "hardware_legacy/power.h"
+
+#include <atomic>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+std::atomic<uint64_t> gNumAcquires = 0;
+std::atomic<uint64_t> gNumReleases = 0;
+std::atomic_bool gHeld = false;
+
+}  // namespace
+
+uint64_t FakePower::getNumAcquires() {
+    return gNumAcquires.load();
+}
+
+uint64_t FakePower::getNumReleases() {
+    return gNumReleases.load();
+}
+
+bool FakePower::isHeld() {
+    return gHeld.load();
+}
+
+void FakePower::reset() {
+    gNumAcquires = 0;
+    gNumReleases = 0;
+    gHeld = false;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
+
+using ::android::hardware::sensors::V2_1::implementation::gHeld;
+using ::android::hardware::sensors::V2_1::implementation::gNumAcquires;
+using ::android::hardware::sensors::V2_1::implementation::gNumReleases;
+
+int acquire_wake_lock(int /* lock */, const char* /* id */) {
+    gNumAcquires++;
+    gHeld = true;
+    return 0;
+}
+
+int release_wake_lock(const char* /* id */) {
+    gNumReleases++;
+    gHeld = false;
+    return 0;
+}
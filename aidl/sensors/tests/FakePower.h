@@ -0,0 +1,32 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * Counts the kernel wakelock calls HalProxy makes. Test binaries link FakePower.cpp instead of
+ * libpower, so acquire_wake_lock and release_wake_lock end up here and never reach the kernel.
+ */
+struct FakePower {
+    static uint64_t getNumAcquires();
+    static uint64_t getNumReleases();
+    static bool isHeld();
+    static void reset();
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeSubHal.h"
+
+#include <algorithm>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::hardware::sensors::V1_0::MetaDataEventType;
+using ::android::hardware::sensors::V1_0::OperationMode;
+using ::android::hardware::sensors::V1_0::RateLevel;
+using ::android::hardware::sensors::V1_0::Result;
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V1_0::SharedMemInfo;
+
+FakeSubHal::FakeSubHal(std::vector<SensorInfo> sensors, std::string name)
+    : mSensors(std::move(sensors)), mName(std::move(name)) {}
+
+Return<void> FakeSubHal::getSensorsList_2_1(getSensorsList_2_1_cb _hidl_cb) {
+    _hidl_cb(mSensors);
+    return Void();
+}
+
+Return<Result> FakeSubHal::setOperationMode(OperationMode /* mode */) {
+    return Result::OK;
+}
+
+Return<Result> FakeSubHal::activate(int32_t sensorHandle, bool enabled) {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    mActive[sensorHandle] = enabled;
+    return Result::OK;
+}
+
+Return<Result> FakeSubHal::batch(int32_t sensorHandle, int64_t samplingPeriodNs,
+                                 int64_t /* maxReportLatencyNs */) {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    mSamplingPeriodsNs[sensorHandle] = samplingPeriodNs;
+    return Result::OK;
+}
+
+Return<Result> FakeSubHal::flush(int32_t sensorHandle) {
+    Event event = makeEvent(sensorHandle, SensorType::META_DATA, 0 /* timestamp */);
+    event.u.meta.what = MetaDataEventType::META_DATA_FLUSH_COMPLETE;
+    postEvents({event});
+    return Result::OK;
+}
+
+Return<Result> FakeSubHal::injectSensorData_2_1(const Event& /* event */) {
+    return Result::INVALID_OPERATION;
+}
+
+Return<void> FakeSubHal::registerDirectChannel(const SharedMemInfo& /* mem */,
+                                               registerDirectChannel_cb _hidl_cb) {
+    _hidl_cb(Result::INVALID_OPERATION, -1 /* channelHandle */);
+    return Void();
+}
+
+Return<Result> FakeSubHal::unregisterDirectChannel(int32_t /* channelHandle */) {
+    return Result::INVALID_OPERATION;
+}
+
+Return<void> FakeSubHal::configDirectReport(int32_t /* sensorHandle */,
+                                            int32_t /* channelHandle */, RateLevel /* rate */,
+                                            configDirectReport_cb _hidl_cb) {
+    _hidl_cb(Result::INVALID_OPERATION, -1 /* reportToken */);
+    return Void();
+}
+
+Return<void> FakeSubHal::debug(const hidl_handle& /* fd */,
+                               const hidl_vec<hidl_string>& /* args */) {
+    return Void();
+}
+
+Return<Result> FakeSubHal::initialize(const sp<IHalProxyCallback>& halProxyCallback) {
+    mCallback = halProxyCallback;
+    return Result::OK;
+}
+
+void FakeSubHal::postEvents(const std::vector<Event>& events) {
+    bool wakeUp = std::any_of(events.begin(), events.end(), [this](const Event& event) {
+        return isWakeUpSensor(event.sensorHandle);
+    });
+    mCallback->postEvents(events, mCallback->createScopedWakelock(wakeUp));
+}
+
+bool FakeSubHal::isActive(int32_t sensorHandle) {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    auto active = mActive.find(sensorHandle);
+    return active != mActive.end() && active->second;
+}
+
+int64_t FakeSubHal::getSamplingPeriodNs(int32_t sensorHandle) {
+    std::lock_guard<std::mutex> lock(mStateMutex);
+    auto samplingPeriodNs = mSamplingPeriodsNs.find(sensorHandle);
+    return samplingPeriodNs != mSamplingPeriodsNs.end() ? samplingPeriodNs->second : 0;
+}
+
+bool FakeSubHal::isWakeUpSensor(int32_t sensorHandle) const {
+    for (const SensorInfo& sensor : mSensors) {
+        if (sensor.sensorHandle == sensorHandle) {
+            return (sensor.flags & SensorFlagBits::WAKE_UP) != 0;
+        }
+    }
+    return false;
+}
+
+SensorInfo makeSensorInfo(int32_t sensorHandle, SensorType type, uint32_t flags,
+                          int32_t minDelayUs) {
+    SensorInfo sensor = {};
+    sensor.sensorHandle = sensorHandle;
+    sensor.name = "Fake sensor " + std::to_string(sensorHandle);
+    sensor.vendor = "The LineageOS Project";
+    sensor.version = 1;
+    sensor.type = type;
+    sensor.maxRange = 1;
+    sensor.resolution = 1;
+    sensor.minDelay = minDelayUs;
+    sensor.maxDelay = 1000000;
+    sensor.flags = flags;
+    return sensor;
+}
+
+Event makeEvent(int32_t sensorHandle, SensorType type, int64_t timestamp) {
+    Event event = {};
+    event.sensorHandle = sensorHandle;
+    event.sensorType = type;
+    event.timestamp = timestamp;
+    return event;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
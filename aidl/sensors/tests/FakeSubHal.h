@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "V2_1/SubHal.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+/**
+ * A 2.1 sub-HAL with a fixed sensor list that posts whatever events the test hands it. It
+ * remembers what the proxy asked of each sensor so tests can check it.
+ */
+class FakeSubHal : public ISensorsSubHal {
+  public:
+    using Event = ::android::hardware::sensors::V2_1::Event;
+    using OperationMode = ::android::hardware::sensors::V1_0::OperationMode;
+    using RateLevel = ::android::hardware::sensors::V1_0::RateLevel;
+    using Result = ::android::hardware::sensors::V1_0::Result;
+    using SensorInfo = ::android::hardware::sensors::V2_1::SensorInfo;
+    using SharedMemInfo = ::android::hardware::sensors::V1_0::SharedMemInfo;
+
+    explicit FakeSubHal(std::vector<SensorInfo> sensors, std::string name = "FakeSubHal");
+
+    // Methods from ::android::hardware::sensors::V2_1::ISensors follow.
+    Return<void> getSensorsList_2_1(getSensorsList_2_1_cb _hidl_cb) override;
+
+    Return<Result> setOperationMode(OperationMode mode) override;
+
+    Return<Result> activate(int32_t sensorHandle, bool enabled) override;
+
+    Return<Result> batch(int32_t sensorHandle, int64_t samplingPeriodNs,
+                         int64_t maxReportLatencyNs) override;
+
+    Return<Result> flush(int32_t sensorHandle) override;
+
+    Return<Result> injectSensorData_2_1(const Event& event) override;
+
+    Return<void> registerDirectChannel(const SharedMemInfo& mem,
+                                       registerDirectChannel_cb _hidl_cb) override;
+
+    Return<Result> unregisterDirectChannel(int32_t channelHandle) override;
+
+    Return<void> configDirectReport(int32_t sensorHandle, int32_t channelHandle, RateLevel rate,
+                                    configDirectReport_cb _hidl_cb) override;
+
+    Return<void> debug(const hidl_handle& fd, const hidl_vec<hidl_string>& args) override;
+
+    // Methods from ::android::hardware::sensors::V2_1::implementation::ISensorsSubHal follow.
+    const std::string getName() override { return mName; }
+
+    Return<Result> initialize(const sp<IHalProxyCallback>& halProxyCallback) override;
+
+    /**
+     * Post events from the calling thread the way a sub-HAL thread does, with a wakelock if any
+     * of them comes from a wake-up sensor. Events use the handles from the sub-HAL's own list.
+     */
+    void postEvents(const std::vector<Event>& events);
+
+    bool isActive(int32_t sensorHandle);
+
+    int64_t getSamplingPeriodNs(int32_t sensorHandle);
+
+  private:
+    bool isWakeUpSensor(int32_t sensorHandle) const;
+
+    const std::vector<SensorInfo> mSensors;
+    const std::string mName;
+
+    sp<IHalProxyCallback> mCallback;
+
+    std::mutex mStateMutex;
+    std::map<int32_t, bool> mActive;
+    std::map<int32_t, int64_t> mSamplingPeriodsNs;
+};
+
+/**
+ * A sensor with the fields the proxy looks at filled in, to be listed by a FakeSubHal.
+ *
+ * @param flags SensorFlagBits, the reporting mode included.
+ */
+SensorInfo makeSensorInfo(int32_t sensorHandle, SensorType type, uint32_t flags,
+                          int32_t minDelayUs = 5000);
+
+Event makeEvent(int32_t sensorHandle, SensorType type, int64_t timestamp);
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
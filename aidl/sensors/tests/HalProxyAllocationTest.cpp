@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace {
+
+//! Allocations made by the calling thread while tCountAllocations is set.
+thread_local bool tCountAllocations = false;
+thread_local size_t tNumAllocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+    if (tCountAllocations) {
+        tNumAllocations++;
+    }
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t /* size */) noexcept {
+    free(ptr);
+}
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+
+constexpr int32_t kAccelHandle = 1;
+constexpr int64_t kRequestedPeriodNs = 5000000;  // 200 Hz
+constexpr int64_t kHardwarePeriodNs = 2500000;   // 400 Hz
+constexpr size_t kEventsPerBatch = 25;
+//! After rate filtering, enough to fill the event FMQ and half of the 16k-event streaming lane.
+constexpr size_t kNumWarmUpBatches = 1000;
+
+}  // namespace
+
+// A sub-HAL posts 400 Hz accelerometer batches for a 200 Hz request into a framework that stops
+// reading. The proxy drops every other event to honour the requested rate, then queues the
+// rest, then decimates them under OverflowPolicy::DECIMATE once the streaming lane is half
+// full. Once each path has run, none of them may allocate on the sub-HAL's thread.
+TEST(HalProxyAllocationTest, PostingDoesNotAllocateOnceWarm) {
+    FakeSubHal subHal({makeSensorInfo(kAccelHandle, SensorType::ACCELEROMETER,
+                                      static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE))});
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&subHal};
+    HalProxy::Options options;
+    options.overflowPolicy = HalProxy::OverflowPolicy::DECIMATE;
+    HalProxy halProxy(subHalsV2_0, subHals, options);
+    FakeFramework framework;
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+    ASSERT_EQ(V1_0::Result::OK, halProxy.activate(kAccelHandle, true));
+    ASSERT_EQ(V1_0::Result::OK, halProxy.batch(kAccelHandle, kRequestedPeriodNs, 0));
+
+    size_t numAllocations = SIZE_MAX;
+    std::thread subHalThread([&] {
+        std::vector<Event> batch(kEventsPerBatch,
+                                 makeEvent(kAccelHandle, SensorType::ACCELEROMETER, 0));
+        int64_t timestamp = 0;
+        auto postBatches = [&](size_t numBatches) {
+            for (size_t i = 0; i < numBatches; i++) {
+                for (Event& event : batch) {
+                    event.timestamp = timestamp += kHardwarePeriodNs;
+                }
+                subHal.postEvents(batch);
+            }
+        };
+        postBatches(kNumWarmUpBatches);
+        tCountAllocations = true;
+        postBatches(200);
+        tCountAllocations = false;
+        numAllocations = tNumAllocations;
+    });
+    subHalThread.join();
+    EXPECT_EQ(0u, numAllocations);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "EventBatcher.h"
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+
+constexpr int32_t kLightHandle = 1;
+constexpr int64_t kSamplingPeriodNs = 20000000;     // 50 Hz
+constexpr int64_t kMaxReportLatencyNs = 200000000;  // 200 ms
+constexpr size_t kNumEvents = 50;                   // 1 s
+
+struct BatchingResult {
+    uint32_t fifoMaxEventCount;
+    size_t numEventsRead;
+    size_t numReads;
+};
+
+/**
+ * Post a 50 Hz non-wake-up light sensor without a FIFO of its own one sample at a time, in real
+ * time, with the framework asking for a 200 ms report latency.
+ */
+BatchingResult runLightSensor(bool emulateBatching) {
+    FakeSubHal subHal({makeSensorInfo(kLightHandle, SensorType::LIGHT,
+                                      static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE))});
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&subHal};
+    HalProxy::Options options;
+    options.emulateBatching = emulateBatching;
+    HalProxy halProxy(subHalsV2_0, subHals, options);
+    FakeFramework framework;
+    EXPECT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+
+    BatchingResult result = {};
+    halProxy.getSensorsList_2_1(
+            [&](const auto& list) { result.fifoMaxEventCount = list[0].fifoMaxEventCount; });
+    EXPECT_EQ(V1_0::Result::OK, halProxy.activate(kLightHandle, true));
+    EXPECT_EQ(V1_0::Result::OK,
+              halProxy.batch(kLightHandle, kSamplingPeriodNs, kMaxReportLatencyNs));
+    framework.startReading();
+    for (size_t i = 0; i < kNumEvents; i++) {
+        subHal.postEvents({makeEvent(kLightHandle, SensorType::LIGHT,
+                                     static_cast<int64_t>(i + 1) * kSamplingPeriodNs)});
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kSamplingPeriodNs));
+    }
+    // Deactivating releases whatever is still held back.
+    EXPECT_EQ(V1_0::Result::OK, halProxy.activate(kLightHandle, false));
+    framework.waitForEvents(kNumEvents, 1000000000 /* 1 s */);
+    framework.stopReading();
+
+    result.numEventsRead = framework.getNumEventsRead();
+    result.numReads = framework.getNumReads();
+    ::testing::Test::RecordProperty(emulateBatching ? "reads_batched" : "reads_unbatched",
+                                    result.numReads);
+    return result;
+}
+
+}  // namespace
+
+// The framework wakes up for every sample without emulation, and about once per report
+// latency with it.
+TEST(HalProxyBatchingTest, EmulationCutsFrameworkWakeups) {
+    BatchingResult unbatched = runLightSensor(false /* emulateBatching */);
+    EXPECT_EQ(0u, unbatched.fifoMaxEventCount);
+    EXPECT_EQ(kNumEvents, unbatched.numEventsRead);
+
+    BatchingResult batched = runLightSensor(true /* emulateBatching */);
+    EXPECT_EQ(EventBatcher::kMaxBatchSize, batched.fifoMaxEventCount);
+    EXPECT_EQ(kNumEvents, batched.numEventsRead);
+
+    constexpr size_t kReportLatencyPeriods = kNumEvents * kSamplingPeriodNs / kMaxReportLatencyNs;
+    EXPECT_LE(batched.numReads, kReportLatencyPeriods + 1);
+    EXPECT_LT(batched.numReads * 4, unbatched.numReads);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
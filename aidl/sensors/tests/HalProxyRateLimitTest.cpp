@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+
+constexpr int32_t kAccelHandle = 1;
+constexpr int64_t kRequestedPeriodNs = 20000000;  // 50 Hz
+constexpr int64_t kJitterAllowanceNs = kRequestedPeriodNs / 8;
+constexpr int64_t kReadTimeoutNs = 100000000;  // 100 ms
+
+/**
+ * A proxy over a sub-HAL whose accelerometer ignores the requested rate, with the
+ * accelerometer active at kRequestedPeriodNs.
+ */
+class HalProxyRateLimitTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&mSubHal};
+        mHalProxy = std::make_unique<HalProxy>(mSubHalsV2_0, subHals);
+        ASSERT_EQ(V1_0::Result::OK, mFramework.initialize(mHalProxy.get()));
+        ASSERT_EQ(V1_0::Result::OK, mHalProxy->activate(kAccelHandle, true));
+        ASSERT_EQ(V1_0::Result::OK, mHalProxy->batch(kAccelHandle, kRequestedPeriodNs, 0));
+    }
+
+    void post(const std::vector<int64_t>& timestamps) {
+        std::vector<Event> events;
+        for (int64_t timestamp : timestamps) {
+            events.push_back(makeEvent(kAccelHandle, SensorType::ACCELEROMETER, timestamp));
+        }
+        mSubHal.postEvents(events);
+    }
+
+    //! @return The timestamps of every event the framework can read, in order.
+    std::vector<int64_t> readTimestamps(size_t expected) {
+        std::vector<int64_t> timestamps;
+        // Ask for one more than expected, so extra events show up as a failure.
+        for (const Event& event : mFramework.readEvents(expected + 1, kReadTimeoutNs)) {
+            timestamps.push_back(event.timestamp);
+        }
+        return timestamps;
+    }
+
+    FakeSubHal mSubHal{{makeSensorInfo(kAccelHandle, SensorType::ACCELEROMETER,
+                                       static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE))}};
+    std::vector<HalProxy::ISensorsSubHalV2_0*> mSubHalsV2_0;
+    std::unique_ptr<HalProxy> mHalProxy;
+    FakeFramework mFramework;
+};
+
+}  // namespace
+
+TEST_F(HalProxyRateLimitTest, DecimatesATenTimesFasterSubHalToTheRequestedRate) {
+    constexpr int64_t kHardwarePeriodNs = kRequestedPeriodNs / 10;
+    constexpr size_t kNumBatches = 10;
+    constexpr size_t kEventsPerBatch = 20;
+    int64_t timestamp = 0;
+    for (size_t b = 0; b < kNumBatches; b++) {
+        std::vector<int64_t> timestamps;
+        for (size_t i = 0; i < kEventsPerBatch; i++) {
+            timestamps.push_back(timestamp += kHardwarePeriodNs);
+        }
+        post(timestamps);
+    }
+
+    // The first hardware tick at least 7/8 of a period after the last kept event is kept, so
+    // every 9th one.
+    constexpr int64_t kTicksPerEvent =
+            (kRequestedPeriodNs - kJitterAllowanceNs + kHardwarePeriodNs - 1) / kHardwarePeriodNs;
+    constexpr size_t kNumPosted = kNumBatches * kEventsPerBatch;
+    constexpr size_t kExpected = (kNumPosted - 1) / kTicksPerEvent + 1;
+    std::vector<int64_t> timestamps = readTimestamps(kExpected);
+    ASSERT_EQ(kExpected, timestamps.size());
+    for (size_t i = 1; i < timestamps.size(); i++) {
+        EXPECT_EQ(kTicksPerEvent * kHardwarePeriodNs, timestamps[i] - timestamps[i - 1]);
+        EXPECT_GE(timestamps[i] - timestamps[i - 1], kRequestedPeriodNs - kJitterAllowanceNs);
+    }
+}
+
+TEST_F(HalProxyRateLimitTest, KeepsEventsWithinAnEighthOfThePeriodEarly) {
+    constexpr int64_t kEarlyPeriodNs = kRequestedPeriodNs - kJitterAllowanceNs;
+    // Each event comes exactly as early as allowed after the previous one, then one comes a
+    // nanosecond earlier than that.
+    post({0, kEarlyPeriodNs, 2 * kEarlyPeriodNs, 3 * kEarlyPeriodNs - 1});
+
+    EXPECT_EQ(std::vector<int64_t>({0, kEarlyPeriodNs, 2 * kEarlyPeriodNs}),
+              readTimestamps(3));
+}
+
+TEST_F(HalProxyRateLimitTest, ActivateResetsTheLastTimestamp) {
+    constexpr int64_t kLastTimestampNs = 1000000000;
+    post({kLastTimestampNs});
+    ASSERT_EQ(std::vector<int64_t>({kLastTimestampNs}), readTimestamps(1));
+
+    // Only half a period after the last event of the previous session, yet it is the first
+    // event of a new one.
+    ASSERT_EQ(V1_0::Result::OK, mHalProxy->activate(kAccelHandle, false));
+    ASSERT_EQ(V1_0::Result::OK, mHalProxy->activate(kAccelHandle, true));
+    post({kLastTimestampNs + kRequestedPeriodNs / 2});
+    EXPECT_EQ(std::vector<int64_t>({kLastTimestampNs + kRequestedPeriodNs / 2}),
+              readTimestamps(1));
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
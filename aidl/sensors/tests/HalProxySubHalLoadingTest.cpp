@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+//! Built from tests/SleepingSubHal.cpp, the delays match the cflags in Android.bp.
+constexpr char kSlowSubHalLibrary[] =
+        "android.hardware.sensors-service.xiaomi-multihal_sleeping_subhal_slow.so";
+constexpr char kFastSubHalLibrary[] =
+        "android.hardware.sensors-service.xiaomi-multihal_sleeping_subhal_fast.so";
+constexpr int64_t kSlowInitNs = 200000000;  // 200 ms
+constexpr int64_t kFastInitNs = 50000000;   // 50 ms
+
+std::string getTestLibrary(const char* library) {
+    return android::base::GetExecutableDirectory() + "/" + library;
+}
+
+//! Slow libraries before fast ones, so the order they finish loading in is not config order.
+std::vector<std::string> getSleepingLibraries() {
+    return {getTestLibrary(kSlowSubHalLibrary), getTestLibrary(kFastSubHalLibrary),
+            getTestLibrary(kSlowSubHalLibrary), getTestLibrary(kFastSubHalLibrary)};
+}
+
+std::vector<SensorInfo> getSensorsList(HalProxy* halProxy) {
+    std::vector<SensorInfo> sensors;
+    halProxy->getSensorsList_2_1(
+            [&](const auto& list) { sensors.assign(list.begin(), list.end()); });
+    return sensors;
+}
+
+//! @return How long constructing a proxy over the sleeping libraries took.
+int64_t timeLoading(bool parallel) {
+    HalProxy::Options options;
+    options.parallelSubHalInit = parallel;
+    int64_t start = getTimeNow();
+    HalProxy halProxy(getSleepingLibraries(), options);
+    int64_t duration = getTimeNow() - start;
+    EXPECT_EQ(4u, getSensorsList(&halProxy).size());
+    return duration;
+}
+
+//! A cached list from before the fast library's sensor was renamed and a second one removed.
+std::vector<SensorInfo> makeStaleCachedSensorList() {
+    std::vector<SensorInfo> sensors = {
+            makeSensorInfo(1, SensorType::ACCELEROMETER,
+                           static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE)),
+            makeSensorInfo(2, SensorType::GYROSCOPE,
+                           static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE))};
+    sensors[0].name = "Old name";
+    return sensors;
+}
+
+}  // namespace
+
+TEST(HalProxySubHalLoadingTest, LoadsSubHalsConcurrently) {
+    constexpr int64_t kTotalInitNs = 2 * kSlowInitNs + 2 * kFastInitNs;
+    EXPECT_GE(timeLoading(false /* parallel */), kTotalInitNs);
+    // All four run at once, so loading takes about as long as the slowest library.
+    EXPECT_LT(timeLoading(true /* parallel */), kTotalInitNs * 3 / 4);
+}
+
+TEST(HalProxySubHalLoadingTest, AssignsHandlesInConfigOrder) {
+    std::vector<std::string> libraries = getSleepingLibraries();
+    // A library that fails to load takes no sub-HAL index.
+    libraries.insert(libraries.begin() + 1, getTestLibrary("missing_subhal.so"));
+    HalProxy halProxy(libraries, HalProxy::Options());
+
+    std::vector<SensorInfo> sensors = getSensorsList(&halProxy);
+    ASSERT_EQ(4u, sensors.size());
+    const std::string kExpectedNames[] = {"SleepingSubHal200", "SleepingSubHal50",
+                                          "SleepingSubHal200", "SleepingSubHal50"};
+    for (size_t i = 0; i < sensors.size(); i++) {
+        EXPECT_EQ(static_cast<int32_t>(i << 24) | 1, sensors[i].sensorHandle);
+        EXPECT_EQ(kExpectedNames[i], std::string(sensors[i].name));
+    }
+}
+
+TEST(HalProxySubHalLoadingTest, AnnouncesDifferencesFromAServedStaleCache) {
+    HalProxy halProxy({getTestLibrary(kFastSubHalLibrary)}, HalProxy::Options(),
+                      makeStaleCachedSensorList());
+    // Served before the sub-HAL finished loading.
+    ASSERT_EQ(2u, getSensorsList(&halProxy).size());
+
+    FakeFramework framework;
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+    EXPECT_EQ(std::vector<int32_t>({1, 2}), framework.getDisconnectedDynamicSensors());
+    std::vector<SensorInfo> connected = framework.getConnectedDynamicSensors();
+    ASSERT_EQ(1u, connected.size());
+    EXPECT_EQ(1, connected[0].sensorHandle);
+    EXPECT_EQ("SleepingSubHal50", std::string(connected[0].name));
+
+    std::vector<SensorInfo> sensors = getSensorsList(&halProxy);
+    ASSERT_EQ(1u, sensors.size());
+    EXPECT_EQ("SleepingSubHal50", std::string(sensors[0].name));
+
+    // A framework that reconnects reads the live list, it has nothing to be told.
+    FakeFramework secondFramework;
+    ASSERT_EQ(V1_0::Result::OK, secondFramework.initialize(&halProxy));
+    EXPECT_TRUE(secondFramework.getDisconnectedDynamicSensors().empty());
+    EXPECT_TRUE(secondFramework.getConnectedDynamicSensors().empty());
+}
+
+TEST(HalProxySubHalLoadingTest, AnnouncesNothingForAStaleCacheNobodySaw) {
+    HalProxy halProxy({getTestLibrary(kFastSubHalLibrary)}, HalProxy::Options(),
+                      makeStaleCachedSensorList());
+    FakeFramework framework;
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+    EXPECT_TRUE(framework.getDisconnectedDynamicSensors().empty());
+    EXPECT_TRUE(framework.getConnectedDynamicSensors().empty());
+    EXPECT_EQ(1u, getSensorsList(&halProxy).size());
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
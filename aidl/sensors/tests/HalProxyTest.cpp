@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+constexpr int32_t kAccelHandle = 1;
+constexpr int64_t kReadTimeoutNs = 1000000000;  // 1 s
+
+SensorInfo makeAccelerometer() {
+    return makeSensorInfo(kAccelHandle, SensorType::ACCELEROMETER,
+                          static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE));
+}
+
+std::vector<Event> makeAccelerometerEvents(size_t count, int64_t firstTimestamp) {
+    std::vector<Event> events;
+    for (size_t i = 0; i < count; i++) {
+        events.push_back(makeEvent(kAccelHandle, SensorType::ACCELEROMETER,
+                                   firstTimestamp + static_cast<int64_t>(i)));
+    }
+    return events;
+}
+
+std::string dumpDebug(HalProxy* halProxy) {
+    FILE* file = tmpfile();
+    native_handle_t* handle = native_handle_create(1 /* numFds */, 0 /* numInts */);
+    handle->data[0] = fileno(file);
+    halProxy->debug(hidl_handle(handle), {});
+    native_handle_delete(handle);
+    std::string output;
+    android::base::ReadFdToString(fileno(file), &output);
+    fclose(file);
+    return output;
+}
+
+}  // namespace
+
+TEST(HalProxyTest, PostsBatchesLargerThanTheEventQueueInOrder) {
+    FakeSubHal subHal({makeAccelerometer()});
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&subHal};
+    HalProxy halProxy(subHalsV2_0, subHals);
+    FakeFramework framework(16 /* eventQueueSize */);
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+    framework.startReading();
+
+    // Each batch takes several rounds of the reader making room, whether the callback thread
+    // writes them itself or leaves them to the pending writes thread.
+    constexpr size_t kNumBatches = 8;
+    constexpr size_t kBatchSize = 40;
+    for (size_t i = 0; i < kNumBatches; i++) {
+        subHal.postEvents(makeAccelerometerEvents(kBatchSize, i * kBatchSize));
+    }
+    ASSERT_TRUE(framework.waitForEvents(kNumBatches * kBatchSize, kReadTimeoutNs));
+    framework.stopReading();
+
+    std::vector<std::pair<Event, int64_t>> events = framework.takeEvents();
+    ASSERT_EQ(kNumBatches * kBatchSize, events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        EXPECT_EQ(static_cast<int64_t>(i), events[i].first.timestamp);
+    }
+}
+
+// A batch larger than the streaming lane never fits, so under OverflowPolicy::BLOCK the
+// posting thread waits out the whole block timeout before dropping it. It must not hold a
+// SensorTable::ReadGuard while it waits, or replacing the sensor table would stall with it.
+TEST(HalProxyTest, BlockingPostDoesNotHoldOffSensorTableUpdates) {
+    FakeSubHal subHal({makeAccelerometer()});
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&subHal};
+    HalProxy::Options options;
+    options.overflowPolicy = HalProxy::OverflowPolicy::BLOCK;
+    options.overflowBlockTimeoutNs = 1000000000;  // 1 s
+    HalProxy halProxy(subHalsV2_0, subHals, options);
+    FakeFramework framework(16 /* eventQueueSize */);
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+
+    constexpr size_t kOversizedBatch = 20000;
+    std::thread subHalThread([&] {
+        subHal.postEvents(makeAccelerometerEvents(16, 0));
+        subHal.postEvents(makeAccelerometerEvents(kOversizedBatch, 16));
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    int64_t start = getTimeNow();
+    SensorTable::synchronize();
+    EXPECT_LT(getTimeNow() - start, 100000000 /* 100 ms */);
+    subHalThread.join();
+
+    std::string debug = dumpDebug(&halProxy);
+    EXPECT_NE(std::string::npos, debug.find("Dropped events per sensor (1):")) << debug;
+    EXPECT_NE(std::string::npos, debug.find("(handle 0x1): " + std::to_string(kOversizedBatch)))
+            << debug;
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
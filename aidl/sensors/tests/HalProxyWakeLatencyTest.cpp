@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+constexpr int32_t kAccelHandle = 1;
+constexpr int32_t kGestureHandle = 2;
+constexpr size_t kStreamBatchSize = 64;
+constexpr size_t kNumGestures = 20;
+constexpr int64_t kGestureIntervalNs = 10000000;  // 10 ms
+//! How long the framework takes to get back to the FMQ after each read.
+constexpr int64_t kReadDelayNs = 2000000;  // 2 ms
+
+int64_t median(std::vector<int64_t> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+}  // namespace
+
+// A sub-HAL streams accelerometer batches faster than a slow framework reads them, so the
+// pending write queue stays backed up, while a second thread posts a wake-up gesture every
+// 10 ms. Each event carries the time it was posted as its timestamp, the framework records when
+// it read it. Gestures must skip the streaming backlog.
+TEST(HalProxyWakeLatencyTest, WakeupEventsSkipTheStreamingBacklog) {
+    FakeSubHal subHal({makeSensorInfo(kAccelHandle, SensorType::ACCELEROMETER,
+                                      static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE)),
+                       makeSensorInfo(kGestureHandle, SensorType::PICK_UP_GESTURE,
+                                      static_cast<uint32_t>(SensorFlagBits::WAKE_UP) |
+                                              static_cast<uint32_t>(
+                                                      SensorFlagBits::ONE_SHOT_MODE))});
+    std::vector<HalProxy::ISensorsSubHalV2_0*> subHalsV2_0;
+    std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {&subHal};
+    HalProxy halProxy(subHalsV2_0, subHals);
+    FakeFramework framework;
+    ASSERT_EQ(V1_0::Result::OK, framework.initialize(&halProxy));
+    framework.startReading(kReadDelayNs);
+
+    std::atomic_bool streaming = true;
+    std::thread streamThread([&] {
+        std::vector<Event> batch(kStreamBatchSize,
+                                 makeEvent(kAccelHandle, SensorType::ACCELEROMETER, 0));
+        while (streaming) {
+            for (Event& event : batch) {
+                event.timestamp = getTimeNow();
+            }
+            subHal.postEvents(batch);
+            std::this_thread::yield();
+        }
+    });
+
+    // Let the backlog build up before the first gesture.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    for (size_t i = 0; i < kNumGestures; i++) {
+        Event gesture = makeEvent(kGestureHandle, SensorType::PICK_UP_GESTURE, getTimeNow());
+        gesture.u.scalar = 1;
+        subHal.postEvents({gesture});
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kGestureIntervalNs));
+    }
+    streaming = false;
+    streamThread.join();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    framework.stopReading();
+
+    std::vector<int64_t> gestureLatenciesNs;
+    std::vector<int64_t> streamLatenciesNs;
+    for (const auto& [event, readTime] : framework.takeEvents()) {
+        int64_t latencyNs = readTime - event.timestamp;
+        if (event.sensorHandle == kGestureHandle) {
+            gestureLatenciesNs.push_back(latencyNs);
+        } else {
+            streamLatenciesNs.push_back(latencyNs);
+        }
+    }
+    ASSERT_EQ(kNumGestures, gestureLatenciesNs.size());
+    ASSERT_FALSE(streamLatenciesNs.empty());
+
+    int64_t gestureMedianNs = median(gestureLatenciesNs);
+    int64_t gestureMaxNs = *std::max_element(gestureLatenciesNs.begin(), gestureLatenciesNs.end());
+    int64_t streamMedianNs = median(streamLatenciesNs);
+    RecordProperty("gesture_median_us", gestureMedianNs / 1000);
+    RecordProperty("gesture_max_us", gestureMaxNs / 1000);
+    RecordProperty("stream_median_us", streamMedianNs / 1000);
+    // A gesture waits for at most the read in progress and the one that picks it up, queued
+    // behind the streaming backlog it would wait for every read that backlog takes.
+    EXPECT_LT(gestureMedianNs * 4, streamMedianNs);
+    EXPECT_LT(gestureMaxNs, 10 * kReadDelayNs + 20000000 /* scheduling slack, 20 ms */);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeFramework.h"
+#include "FakePower.h"
+#include "FakeSubHal.h"
+#include "HalProxy.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_0::implementation::getTimeNow;
+
+constexpr int32_t kGestureHandle = 1;
+constexpr size_t kNumGestures = 10;
+constexpr int64_t kTimeoutNs = 1000000000;  // 1 s
+
+//! Poll until condition holds or timeoutNs passed, @return whether it held.
+bool waitFor(const std::function<bool()>& condition, int64_t timeoutNs = kTimeoutNs) {
+    int64_t deadline = getTimeNow() + timeoutNs;
+    while (!condition()) {
+        if (getTimeNow() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+/**
+ * A proxy over a sub-HAL with a wake-up gesture sensor, feeding a framework that acknowledges
+ * every wake-up event as soon as it reads it.
+ */
+class HalProxyWakelockTest : public ::testing::Test {
+  protected:
+    void start(const HalProxy::Options& options) {
+        FakePower::reset();
+        mSubHal = std::make_unique<FakeSubHal>(std::vector<SensorInfo>{makeSensorInfo(
+                kGestureHandle, SensorType::PICK_UP_GESTURE,
+                static_cast<uint32_t>(SensorFlagBits::WAKE_UP) |
+                        static_cast<uint32_t>(SensorFlagBits::ONE_SHOT_MODE))});
+        std::vector<HalProxy::ISensorsSubHalV2_1*> subHals = {mSubHal.get()};
+        mHalProxy = std::make_unique<HalProxy>(mSubHalsV2_0, subHals, options);
+        ASSERT_EQ(V1_0::Result::OK, mFramework.initialize(mHalProxy.get()));
+        mFramework.startReading();
+    }
+
+    void TearDown() override {
+        mFramework.stopReading();
+        mHalProxy.reset();
+    }
+
+    //! Post one gesture and wait until the framework has read it and acknowledged it.
+    void postGesture() {
+        size_t numEventsRead = mFramework.getNumEventsRead();
+        Event event = makeEvent(kGestureHandle, SensorType::PICK_UP_GESTURE, mTimestamp++);
+        event.u.scalar = 1;
+        mSubHal->postEvents({event});
+        ASSERT_TRUE(mFramework.waitForEvents(numEventsRead + 1, kTimeoutNs));
+    }
+
+    std::unique_ptr<FakeSubHal> mSubHal;
+    std::vector<HalProxy::ISensorsSubHalV2_0*> mSubHalsV2_0;
+    std::unique_ptr<HalProxy> mHalProxy;
+    FakeFramework mFramework;
+    int64_t mTimestamp = 1;
+};
+
+}  // namespace
+
+TEST_F(HalProxyWakelockTest, TogglesWakelockPerGestureWithoutHysteresis) {
+    start(HalProxy::Options());
+    for (size_t i = 0; i < kNumGestures; i++) {
+        postGesture();
+        ASSERT_TRUE(waitFor([] { return !FakePower::isHeld(); }));
+    }
+    EXPECT_EQ(kNumGestures, FakePower::getNumAcquires());
+    EXPECT_EQ(kNumGestures, FakePower::getNumReleases());
+}
+
+TEST_F(HalProxyWakelockTest, CoalescesAGestureBurstWithinHysteresis) {
+    HalProxy::Options options;
+    options.wakelockHysteresisNs = 200000000;  // 200 ms
+    start(options);
+    for (size_t i = 0; i < kNumGestures; i++) {
+        postGesture();
+    }
+    EXPECT_TRUE(FakePower::isHeld());
+    ASSERT_TRUE(waitFor([] { return !FakePower::isHeld(); }));
+    EXPECT_EQ(1u, FakePower::getNumAcquires());
+    EXPECT_EQ(1u, FakePower::getNumReleases());
+}
+
+TEST_F(HalProxyWakelockTest, ReleasesOnceMaxHoldPassed) {
+    HalProxy::Options options;
+    options.wakelockHysteresisNs = 1000000000;  // 1 s
+    options.wakelockMaxHoldNs = 20000000;       // 20 ms
+    start(options);
+    int64_t startTime = getTimeNow();
+    postGesture();
+    // The hysteresis alone would keep the wakelock for another second.
+    ASSERT_TRUE(waitFor([] { return !FakePower::isHeld(); }, 500000000 /* 500 ms */));
+    EXPECT_LT(getTimeNow() - startTime, 500000000);
+    EXPECT_EQ(1u, FakePower::getNumAcquires());
+    EXPECT_EQ(1u, FakePower::getNumReleases());
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
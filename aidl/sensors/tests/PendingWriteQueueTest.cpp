@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PendingWriteQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+using Event = PendingWriteQueue::Event;
+
+Event makeEvent(int32_t producer, int64_t sequence) {
+    Event event = {};
+    event.sensorHandle = producer;
+    event.sensorType = SensorType::ACCELEROMETER;
+    event.timestamp = sequence;
+    return event;
+}
+
+std::vector<Event> drain(PendingWriteQueue* queue) {
+    std::vector<Event> events;
+    for (auto pending = queue->peek(SIZE_MAX); pending.size > 0; pending = queue->peek(SIZE_MAX)) {
+        events.insert(events.end(), pending.events, pending.events + pending.size);
+        queue->pop(pending.size);
+    }
+    return events;
+}
+
+}  // namespace
+
+TEST(PendingWriteQueueTest, PushAndPeekInOrder) {
+    PendingWriteQueue queue(8);
+    std::vector<Event> events = {makeEvent(1, 0), makeEvent(1, 1), makeEvent(1, 2)};
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 42));
+    EXPECT_EQ(3u, queue.size());
+    EXPECT_TRUE(queue.readable());
+
+    auto pending = queue.peek(2);
+    ASSERT_EQ(2u, pending.size);
+    EXPECT_EQ(0, pending.events[0].timestamp);
+    EXPECT_EQ(1, pending.events[1].timestamp);
+    EXPECT_EQ(42, pending.enqueueTimesNs[1]);
+    queue.pop(pending.size);
+
+    pending = queue.peek(SIZE_MAX);
+    ASSERT_EQ(1u, pending.size);
+    EXPECT_EQ(2, pending.events[0].timestamp);
+    queue.pop(pending.size);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.readable());
+}
+
+TEST(PendingWriteQueueTest, PushFailsWithoutRoomAndWritesNothing) {
+    PendingWriteQueue queue(4);
+    std::vector<Event> events = {makeEvent(1, 0), makeEvent(1, 1), makeEvent(1, 2)};
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    EXPECT_FALSE(queue.push(events.data(), 2, 0));
+    EXPECT_EQ(3u, queue.size());
+    EXPECT_TRUE(queue.push(events.data(), 1, 0));
+    EXPECT_FALSE(queue.push(events.data(), 1, 0));
+    EXPECT_EQ(4u, drain(&queue).size());
+}
+
+TEST(PendingWriteQueueTest, PeekStopsAtTheEndOfTheRing) {
+    PendingWriteQueue queue(4);
+    std::vector<Event> events = {makeEvent(1, 0), makeEvent(1, 1), makeEvent(1, 2)};
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    queue.pop(queue.peek(SIZE_MAX).size);
+
+    // Positions 3, 4 and 5 wrap around to slots 3, 0 and 1.
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    auto pending = queue.peek(SIZE_MAX);
+    ASSERT_EQ(1u, pending.size);
+    EXPECT_EQ(0, pending.events[0].timestamp);
+    queue.pop(pending.size);
+    pending = queue.peek(SIZE_MAX);
+    ASSERT_EQ(2u, pending.size);
+    EXPECT_EQ(1, pending.events[0].timestamp);
+    EXPECT_EQ(2, pending.events[1].timestamp);
+}
+
+TEST(PendingWriteQueueTest, ClearDropsPublishedEvents) {
+    PendingWriteQueue queue(8);
+    std::vector<Event> events = {makeEvent(1, 0), makeEvent(1, 1)};
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    EXPECT_EQ(2u, drain(&queue).size());
+}
+
+TEST(PendingWriteQueueTest, PartitionHeadKeepsTheKeptEventsInOrder) {
+    PendingWriteQueue queue(8);
+    std::vector<Event> events = {makeEvent(1, 0), makeEvent(1, 1), makeEvent(1, 2)};
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    queue.pop(queue.peek(SIZE_MAX).size);
+
+    // Positions 3 to 9 wrap around the end of the ring, the odd timestamps are kept.
+    events.clear();
+    for (int64_t i = 0; i < 7; i++) {
+        events.push_back(makeEvent(1, i));
+    }
+    ASSERT_TRUE(queue.push(events.data(), events.size(), 0));
+    auto keepOdd = [](const Event& event) { return event.timestamp % 2 == 1; };
+    size_t numDropped = queue.partitionHead(6, keepOdd);
+    ASSERT_EQ(3u, numDropped);
+
+    std::vector<Event> remaining = drain(&queue);
+    ASSERT_EQ(7u, remaining.size());
+    for (size_t i = 0; i < numDropped; i++) {
+        EXPECT_EQ(0, remaining[i].timestamp % 2);
+    }
+    EXPECT_EQ(1, remaining[3].timestamp);
+    EXPECT_EQ(3, remaining[4].timestamp);
+    EXPECT_EQ(5, remaining[5].timestamp);
+    EXPECT_EQ(6, remaining[6].timestamp);
+}
+
+TEST(PendingWriteQueueTest, ConcurrentProducersKeepTheirOrder) {
+    constexpr int kNumProducers = 4;
+    constexpr int kEventsPerProducer = 20000;
+    PendingWriteQueue queue(256);
+
+    std::atomic<int> numRunning = kNumProducers;
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < kNumProducers; producer++) {
+        producers.emplace_back([&, producer] {
+            int64_t sequence = 0;
+            while (sequence < kEventsPerProducer) {
+                // Vary the batch size so reservations straddle the end of the ring.
+                size_t count = 1 + (sequence + producer) % 7;
+                std::vector<Event> batch;
+                for (size_t i = 0; i < count && sequence + i < kEventsPerProducer; i++) {
+                    batch.push_back(makeEvent(producer, sequence + i));
+                }
+                if (queue.push(batch.data(), batch.size(), sequence)) {
+                    sequence += batch.size();
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            numRunning--;
+        });
+    }
+
+    std::vector<int64_t> nextSequence(kNumProducers, 0);
+    size_t numReceived = 0;
+    while (numRunning > 0 || !queue.empty()) {
+        auto pending = queue.peek(64);
+        if (pending.size == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t i = 0; i < pending.size; i++) {
+            const Event& event = pending.events[i];
+            ASSERT_GE(event.sensorHandle, 0);
+            ASSERT_LT(event.sensorHandle, kNumProducers);
+            ASSERT_EQ(nextSequence[event.sensorHandle], event.timestamp);
+            nextSequence[event.sensorHandle]++;
+        }
+        numReceived += pending.size;
+        queue.pop(pending.size);
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    EXPECT_EQ(static_cast<size_t>(kNumProducers * kEventsPerProducer), numReceived);
+    for (int64_t sequence : nextSequence) {
+        EXPECT_EQ(kEventsPerProducer, sequence);
+    }
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SensorTable.h"
+#include "SubHalIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace implementation {
+
+namespace {
+
+SensorInfo makeSensor(int32_t sensorHandle) {
+    SensorInfo sensor = {};
+    sensor.sensorHandle = sensorHandle;
+    sensor.name = std::to_string(sensorHandle);
+    return sensor;
+}
+
+}  // namespace
+
+TEST(SensorTableTest, FindsDenseAndSparseHandles) {
+    std::map<int32_t, SensorInfo> sensors;
+    for (int32_t sensorHandle : {setSubHalIndex(1, 0), setSubHalIndex(7, 2),
+                                 setSubHalIndex(0x100000, 2)}) {
+        sensors[sensorHandle] = makeSensor(sensorHandle);
+    }
+    std::map<int32_t, SensorInfo> dynamicSensors = {
+            {setSubHalIndex(3, 1), makeSensor(setSubHalIndex(3, 1))}};
+    SensorTable table(sensors, dynamicSensors);
+
+    EXPECT_EQ(4u, table.size());
+    for (const auto& [sensorHandle, sensor] : sensors) {
+        ASSERT_NE(nullptr, table.find(sensorHandle));
+        EXPECT_EQ(sensor.name, table.find(sensorHandle)->name);
+    }
+    ASSERT_NE(nullptr, table.find(setSubHalIndex(3, 1)));
+    EXPECT_EQ(nullptr, table.find(setSubHalIndex(2, 0)));
+    EXPECT_EQ(nullptr, table.find(setSubHalIndex(1, 3)));
+    EXPECT_EQ(nullptr, table.find(setSubHalIndex(0x100001, 2)));
+}
+
+TEST(SensorTableTest, CopiesRequestedSamplingPeriodsAndDropCounts) {
+    std::map<int32_t, SensorInfo> sensors = {{1, makeSensor(1)}, {2, makeSensor(2)}};
+    SensorTable oldTable(sensors, {});
+    oldTable.findRateLimit(1)->samplingPeriodNs.store(5000000);
+    oldTable.findRateLimit(1)->eventsDropped.store(7);
+
+    sensors.erase(2);
+    sensors[3] = makeSensor(3);
+    SensorTable newTable(sensors, {});
+    newTable.copyRateLimits(oldTable);
+    EXPECT_EQ(5000000, newTable.findRateLimit(1)->samplingPeriodNs.load());
+    EXPECT_EQ(0, newTable.findRateLimit(3)->samplingPeriodNs.load());
+    EXPECT_EQ(7u, newTable.findRateLimit(1)->eventsDropped.load());
+    EXPECT_EQ(0u, newTable.findRateLimit(3)->eventsDropped.load());
+}
+
+TEST(SensorTableTest, SynchronizeWaitsForReaders) {
+    std::atomic<bool> guardTaken = false;
+    std::atomic<bool> guardReleased = false;
+    std::thread reader([&] {
+        SensorTable::ReadGuard guard;
+        guardTaken = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        guardReleased = true;
+    });
+    while (!guardTaken) {
+        std::this_thread::yield();
+    }
+    SensorTable::synchronize();
+    EXPECT_TRUE(guardReleased);
+    reader.join();
+
+    // Nothing is left to wait for.
+    SensorTable::synchronize();
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "FakeSubHal.h"
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifndef SLEEPING_SUB_HAL_INIT_MS
+#error "SLEEPING_SUB_HAL_INIT_MS must be set to how long getting the sub-HAL takes"
+#endif
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+using ::android::hardware::sensors::V2_1::SensorType;
+using ::android::hardware::sensors::V2_1::implementation::FakeSubHal;
+using ::android::hardware::sensors::V2_1::implementation::ISensorsSubHal;
+using ::android::hardware::sensors::V2_1::implementation::makeSensorInfo;
+
+/**
+ * A sub-HAL library that takes SLEEPING_SUB_HAL_INIT_MS to hand out its sub-HAL, standing in for
+ * one that talks to slow hardware while it initializes. Every call returns a new sub-HAL, so one
+ * library can be listed several times, each named after the delay.
+ */
+ISensorsSubHal* sensorsHalGetSubHal_2_1(uint32_t* version) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(SLEEPING_SUB_HAL_INIT_MS));
+    std::string name = "SleepingSubHal" + std::to_string(SLEEPING_SUB_HAL_INIT_MS);
+    auto sensor = makeSensorInfo(1, SensorType::ACCELEROMETER,
+                                 static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE));
+    sensor.name = name;
+    *version = SUB_HAL_2_1_VERSION;
+    return new FakeSubHal({sensor}, name);
+}
@@ -22,6 +22,8 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
+
 namespace android {
 namespace hardware {
 namespace sensors {
@@ -53,26 +55,55 @@ static Result ResultFromStatus(status_t err) {
     }
 }
 
-Sensors::Sensors() : mInitCheck(NO_INIT), mSensorModule(nullptr), mSensorDevice(nullptr) {
-    status_t err = OK;
-    if (UseMultiHal()) {
-        mSensorModule = ::get_multi_hal_module_info();
-    } else {
-        err = hw_get_module(SENSORS_HARDWARE_MODULE_ID, (hw_module_t const**)&mSensorModule);
+/*
+ * The sampling period an emulated direct channel runs its sensor at, taken from the nominal
+ * rate of each level.
+ */
+static int64_t SamplingPeriodFromRateLevel(RateLevel rate) {
+    switch (rate) {
+        case RateLevel::NORMAL:
+            return 20000000;
+        case RateLevel::FAST:
+            return 5000000;
+        case RateLevel::VERY_FAST:
+            return 1250000;
+        default:
+            return 0;
     }
-    if (mSensorModule == NULL) {
-        err = UNKNOWN_ERROR;
+}
+
+static sensors_module_t* LoadSensorModule() {
+    sensors_module_t* module = nullptr;
+    if (UseMultiHal()) {
+        module = ::get_multi_hal_module_info();
+        if (module == nullptr) {
+            LOG(ERROR) << "Couldn't load the multi-HAL module";
+        }
+        return module;
     }
 
+    status_t err = hw_get_module(SENSORS_HARDWARE_MODULE_ID, (hw_module_t const**)&module);
     if (err != OK) {
         LOG(ERROR) << "Couldn't load " << SENSORS_HARDWARE_MODULE_ID << " module ("
                    << strerror(-err) << ")";
+        return nullptr;
+    }
+    return module;
+}
 
-        mInitCheck = err;
+Sensors::Sensors() : Sensors(LoadSensorModule()) {}
+
+Sensors::Sensors(sensors_module_t* module)
+    : mInitCheck(NO_INIT),
+      mSensorModule(module),
+      mSensorDevice(nullptr),
+      mEmulateDirectChannels(false) {
+    if (mSensorModule == NULL) {
+        mInitCheck = UNKNOWN_ERROR;
         return;
     }
 
-    err = sensors_open_1(&mSensorModule->common, &mSensorDevice);
+    status_t err = sensors_open_1(&mSensorModule->common, &mSensorDevice);
 
     if (err != OK) {
         LOG(ERROR) << "Couldn't open device for module " << SENSORS_HARDWARE_MODULE_ID << " ("
@@ -95,6 +126,17 @@ Sensors::Sensors() : mInitCheck(NO_INIT), mSensorModule(nullptr), mSensorDevice(
         }
     }
 
+    mEmulateDirectChannels = mSensorDevice->register_direct_channel == nullptr ||
+                             mSensorDevice->config_direct_report == nullptr;
+
+    mSensorList = getFixedUpSensorList();
+    for (size_t i = 0; i < mSensorList.size(); ++i) {
+        mSensorIndex[mSensorList[i].sensorHandle] = i;
+    }
+
+    mPollBuffer.reset(new sensors_event_t[kPollMaxBufferSize]);
+    mPollEvents.reserve(kPollMaxBufferSize);
+
     mInitCheck = OK;
 }
 
@@ -103,7 +145,7 @@ status_t Sensors::initCheck() const {
 }
 
 Return<void> Sensors::getSensorsList(getSensorsList_cb _hidl_cb) {
-    hidl_vec<SensorInfo> out = getFixedUpSensorList();
+    hidl_vec<SensorInfo> out = mSensorList;
 
     _hidl_cb(out);
 
@@ -127,6 +169,13 @@ Return<Result> Sensors::setOperationMode(OperationMode mode) {
 }
 
 Return<Result> Sensors::activate(int32_t sensor_handle, bool enabled) {
+    if (mEmulateDirectChannels) {
+        std::lock_guard<std::mutex> lock(mDirectChannelLock);
+        mFrameworkRequests[sensor_handle].enabled = enabled;
+        if (getDirectSamplingPeriodLocked(sensor_handle) != 0) {
+            return updateEmulatedSensorLocked(sensor_handle);
+        }
+    }
     return ResultFromStatus(mSensorDevice->activate(
             reinterpret_cast<sensors_poll_device_t*>(mSensorDevice), sensor_handle, enabled));
 }
@@ -134,8 +183,8 @@ Return<Result> Sensors::activate(int32_t sensor_handle, bool enabled) {
 Return<void> Sensors::poll(int32_t maxCount, poll_cb _hidl_cb) {
     hidl_vec<Event> out;
     hidl_vec<SensorInfo> dynamicSensorsAdded;
+    std::vector<Event> events;
 
-    std::unique_ptr<sensors_event_t[]> data;
     int err = android::NO_ERROR;
 
     {  // scope of reentry lock
@@ -160,52 +209,80 @@ Return<void> Sensors::poll(int32_t maxCount, poll_cb _hidl_cb) {
             err = android::BAD_VALUE;
         } else {
             int bufferSize = maxCount <= kPollMaxBufferSize ? maxCount : kPollMaxBufferSize;
-            data.reset(new sensors_event_t[bufferSize]);
             err = mSensorDevice->poll(reinterpret_cast<sensors_poll_device_t*>(mSensorDevice),
-                                      data.get(), bufferSize);
+                                      mPollBuffer.get(), bufferSize);
         }
-    }
 
-    if (err < 0) {
-        _hidl_cb(ResultFromStatus(err), out, dynamicSensorsAdded);
-        return Void();
-    }
+        if (err < 0) {
+            lock.unlock();
+            _hidl_cb(ResultFromStatus(err), out, dynamicSensorsAdded);
+            return Void();
+        }
 
-    const size_t count = (size_t)err;
+        const sensors_event_t* data = mPollBuffer.get();
+        const size_t count = (size_t)err;
 
-    for (size_t i = 0; i < count; ++i) {
-        if (data[i].type != SENSOR_TYPE_DYNAMIC_SENSOR_META) {
-            continue;
-        }
+        for (size_t i = 0; i < count; ++i) {
+            if (data[i].type != SENSOR_TYPE_DYNAMIC_SENSOR_META) {
+                continue;
+            }
 
-        const dynamic_sensor_meta_event_t* dyn = &data[i].dynamic_sensor_meta;
+            const dynamic_sensor_meta_event_t* dyn = &data[i].dynamic_sensor_meta;
 
-        if (!dyn->connected) {
-            continue;
-        }
+            if (!dyn->connected) {
+                continue;
+            }
 
-        CHECK(dyn->sensor != nullptr);
-        CHECK_EQ(dyn->sensor->handle, dyn->handle);
+            CHECK(dyn->sensor != nullptr);
+            CHECK_EQ(dyn->sensor->handle, dyn->handle);
 
-        SensorInfo info;
-        convertFromSensor(*dyn->sensor, &info);
+            SensorInfo info;
+            convertFromSensor(*dyn->sensor, &info);
 
-        size_t numDynamicSensors = dynamicSensorsAdded.size();
-        dynamicSensorsAdded.resize(numDynamicSensors + 1);
-        dynamicSensorsAdded[numDynamicSensors] = info;
+            size_t numDynamicSensors = dynamicSensorsAdded.size();
+            dynamicSensorsAdded.resize(numDynamicSensors + 1);
+            dynamicSensorsAdded[numDynamicSensors] = info;
+        }
+
+        mPollEvents.clear();
+        if (mEmulateDirectChannels) {
+            std::lock_guard<std::mutex> directLock(mDirectChannelLock);
+            writeDirectChannelsLocked(count, data);
+            convertFromSensorEvents(count, data, mPollEvents);
+            dropDirectOnlyEventsLocked(mPollEvents);
+        } else {
+            convertFromSensorEvents(count, data, mPollEvents);
+        }
+
+        // The callback runs without the lock, so it gets the buffer to itself. A poll() that
+        // starts meanwhile converts into a fresh one instead of overwriting these events.
+        events.swap(mPollEvents);
     }
 
-    std::vector<Event> events;
-    convertFromSensorEvents(err, data.get(), events, getFixedUpSensorList());
-    out = events;
+    out.setToExternal(events.data(), events.size());
 
     _hidl_cb(Result::OK, out, dynamicSensorsAdded);
 
+    // Hand the buffer back for the next call, unless another poll() is running by now.
+    std::unique_lock<std::mutex> lock(mPollLock, std::try_to_lock);
+    if (lock.owns_lock()) {
+        mPollEvents.swap(events);
+    }
+
     return Void();
 }
 
 Return<Result> Sensors::batch(int32_t sensor_handle, int64_t sampling_period_ns,
                               int64_t max_report_latency_ns) {
+    if (mEmulateDirectChannels) {
+        std::lock_guard<std::mutex> lock(mDirectChannelLock);
+        FrameworkRequest& request = mFrameworkRequests[sensor_handle];
+        request.samplingPeriodNs = sampling_period_ns;
+        request.maxReportLatencyNs = max_report_latency_ns;
+        if (getDirectSamplingPeriodLocked(sensor_handle) != 0) {
+            return updateEmulatedSensorLocked(sensor_handle);
+        }
+    }
     return ResultFromStatus(mSensorDevice->batch(mSensorDevice, sensor_handle, 0, /*flags*/
                                                  sampling_period_ns, max_report_latency_ns));
 }
@@ -228,10 +305,18 @@ Return<Result> Sensors::injectSensorData(const Event& event) {
 
 Return<void> Sensors::registerDirectChannel(const SharedMemInfo& mem,
                                             registerDirectChannel_cb _hidl_cb) {
-    if (mSensorDevice->register_direct_channel == nullptr ||
-        mSensorDevice->config_direct_report == nullptr) {
-        // HAL does not support
-        _hidl_cb(Result::INVALID_OPERATION, -1);
+    if (mEmulateDirectChannels) {
+        // Only ashmem can be emulated, gralloc buffers would need a mapper to write into.
+        std::unique_ptr<DirectChannel> channel = DirectChannel::create(mem);
+        if (channel == nullptr) {
+            _hidl_cb(Result::BAD_VALUE, -1);
+            return Void();
+        }
+
+        std::lock_guard<std::mutex> lock(mDirectChannelLock);
+        int32_t channelHandle = mNextDirectChannelHandle++;
+        mDirectChannels[channelHandle].channel = std::move(channel);
+        _hidl_cb(Result::OK, channelHandle);
         return Void();
     }
 
@@ -253,10 +338,18 @@ Return<void> Sensors::registerDirectChannel(const SharedMemInfo& mem,
 }
 
 Return<Result> Sensors::unregisterDirectChannel(int32_t channelHandle) {
-    if (mSensorDevice->register_direct_channel == nullptr ||
-        mSensorDevice->config_direct_report == nullptr) {
-        // HAL does not support
-        return Result::INVALID_OPERATION;
+    if (mEmulateDirectChannels) {
+        std::lock_guard<std::mutex> lock(mDirectChannelLock);
+        auto channel = mDirectChannels.find(channelHandle);
+        if (channel == mDirectChannels.end()) {
+            return Result::BAD_VALUE;
+        }
+        std::set<int32_t> reportedSensors = channel->second.channel->clearReported();
+        mDirectChannels.erase(channel);
+        for (int32_t sensorHandle : reportedSensors) {
+            updateEmulatedSensorLocked(sensorHandle);
+        }
+        return Result::OK;
     }
 
     mSensorDevice->register_direct_channel(mSensorDevice, nullptr, channelHandle);
@@ -266,10 +359,63 @@ Return<Result> Sensors::unregisterDirectChannel(int32_t channelHandle) {
 
 Return<void> Sensors::configDirectReport(int32_t sensorHandle, int32_t channelHandle,
                                          RateLevel rate, configDirectReport_cb _hidl_cb) {
-    if (mSensorDevice->register_direct_channel == nullptr ||
-        mSensorDevice->config_direct_report == nullptr) {
-        // HAL does not support
-        _hidl_cb(Result::INVALID_OPERATION, -1);
+    if (mEmulateDirectChannels) {
+        // A handle of -1 stops every sensor on the channel and is only valid with STOP.
+        if (sensorHandle == -1 && rate != RateLevel::STOP) {
+            _hidl_cb(Result::BAD_VALUE, -1);
+            return Void();
+        }
+        if (sensorHandle != -1) {
+            auto index = mSensorIndex.find(sensorHandle);
+            if (index == mSensorIndex.end()) {
+                _hidl_cb(Result::BAD_VALUE, -1);
+                return Void();
+            }
+            uint32_t maxRate = (mSensorList[index->second].flags &
+                                static_cast<uint32_t>(SensorFlagBits::MASK_DIRECT_REPORT)) >>
+                               static_cast<uint32_t>(SensorFlagShift::DIRECT_REPORT);
+            if (static_cast<uint32_t>(rate) > maxRate) {
+                _hidl_cb(Result::BAD_VALUE, -1);
+                return Void();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mDirectChannelLock);
+        auto channel = mDirectChannels.find(channelHandle);
+        if (channel == mDirectChannels.end()) {
+            _hidl_cb(Result::BAD_VALUE, -1);
+            return Void();
+        }
+        EmulatedDirectChannel& emulated = channel->second;
+
+        if (rate == RateLevel::STOP) {
+            std::set<int32_t> stoppedSensors;
+            if (sensorHandle == -1) {
+                stoppedSensors = emulated.channel->clearReported();
+                emulated.samplingPeriodsNs.clear();
+            } else {
+                emulated.channel->setReported(sensorHandle, false);
+                emulated.samplingPeriodsNs.erase(sensorHandle);
+                stoppedSensors.insert(sensorHandle);
+            }
+            for (int32_t stoppedSensor : stoppedSensors) {
+                updateEmulatedSensorLocked(stoppedSensor);
+            }
+            _hidl_cb(Result::OK, -1);
+            return Void();
+        }
+
+        emulated.samplingPeriodsNs[sensorHandle] = SamplingPeriodFromRateLevel(rate);
+        Result result = updateEmulatedSensorLocked(sensorHandle);
+        if (result != Result::OK) {
+            emulated.samplingPeriodsNs.erase(sensorHandle);
+            updateEmulatedSensorLocked(sensorHandle);
+            _hidl_cb(result, -1);
+            return Void();
+        }
+        // Legacy sensor handles are always positive, so the handle doubles as the report token.
+        emulated.channel->setReported(sensorHandle, true);
+        _hidl_cb(Result::OK, sensorHandle);
         return Void();
     }
 
@@ -303,6 +449,9 @@ std::vector<SensorInfo> Sensors::getFixedUpSensorList() {
 
         bool keep = patchXiaomiPickupSensor(sensor);
         if (keep) {
+            if (mEmulateDirectChannels) {
+                addEmulatedDirectReportFlags(sensor);
+            }
             sensors.push_back(sensor);
         }
     }
@@ -310,22 +459,118 @@ std::vector<SensorInfo> Sensors::getFixedUpSensorList() {
     return sensors;
 };
 
-// static
-void Sensors::convertFromSensorEvents(size_t count, const sensors_event_t* srcArray,
-                                      std::vector<Event>& dstVec,
-                                      std::vector<SensorInfo> sensorsList) {
+void Sensors::addEmulatedDirectReportFlags(SensorInfo& sensor) const {
+    // Only continuous sensors report at the fixed rate a direct channel client expects.
+    if ((sensor.flags & SensorFlagBits::MASK_REPORTING_MODE) !=
+        static_cast<uint32_t>(SensorFlagBits::CONTINUOUS_MODE)) {
+        return;
+    }
+
+    RateLevel rate;
+    if (sensor.minDelay > 0 && sensor.minDelay <= 5000) {
+        rate = RateLevel::FAST;
+    } else if (sensor.minDelay > 0 && sensor.minDelay <= 20000) {
+        rate = RateLevel::NORMAL;
+    } else {
+        return;
+    }
+
+    sensor.flags &= ~static_cast<uint32_t>(SensorFlagBits::MASK_DIRECT_REPORT |
+                                           SensorFlagBits::MASK_DIRECT_CHANNEL);
+    sensor.flags |= SensorFlagBits::DIRECT_CHANNEL_ASHMEM;
+    sensor.flags |= static_cast<uint32_t>(rate)
+                    << static_cast<uint32_t>(SensorFlagShift::DIRECT_REPORT);
+}
+
+int64_t Sensors::getDirectSamplingPeriodLocked(int32_t sensorHandle) const {
+    int64_t samplingPeriodNs = 0;
+    for (const auto& [channelHandle, emulated] : mDirectChannels) {
+        auto period = emulated.samplingPeriodsNs.find(sensorHandle);
+        if (period != emulated.samplingPeriodsNs.end() &&
+            (samplingPeriodNs == 0 || period->second < samplingPeriodNs)) {
+            samplingPeriodNs = period->second;
+        }
+    }
+    return samplingPeriodNs;
+}
+
+Result Sensors::updateEmulatedSensorLocked(int32_t sensorHandle) {
+    sensors_poll_device_t* device = reinterpret_cast<sensors_poll_device_t*>(mSensorDevice);
+    int64_t directPeriodNs = getDirectSamplingPeriodLocked(sensorHandle);
+    const FrameworkRequest& request = mFrameworkRequests[sensorHandle];
+
+    if (directPeriodNs == 0 && !request.enabled) {
+        return ResultFromStatus(mSensorDevice->activate(device, sensorHandle, false));
+    }
+
+    // The module runs one rate per sensor, so run it at the faster of the two requests. A
+    // direct channel is read as it fills, batching would only delay it.
+    int64_t samplingPeriodNs = request.samplingPeriodNs;
+    int64_t maxReportLatencyNs = request.maxReportLatencyNs;
+    if (directPeriodNs != 0) {
+        if (!request.enabled || samplingPeriodNs <= 0 || directPeriodNs < samplingPeriodNs) {
+            samplingPeriodNs = directPeriodNs;
+        }
+        maxReportLatencyNs = 0;
+    }
+
+    if (samplingPeriodNs > 0) {
+        int err = mSensorDevice->batch(mSensorDevice, sensorHandle, 0, /*flags*/
+                                       samplingPeriodNs, maxReportLatencyNs);
+        if (err != OK) {
+            return ResultFromStatus(err);
+        }
+    }
+    return ResultFromStatus(mSensorDevice->activate(device, sensorHandle, true));
+}
+
+void Sensors::writeDirectChannelsLocked(size_t count, const sensors_event_t* src) {
+    if (mDirectChannels.empty()) {
+        return;
+    }
+
+    // Records are written straight from the poll buffer, skipping the HIDL conversion.
     for (size_t i = 0; i < count; ++i) {
-        const sensors_event_t& src = srcArray[i];
-        Event event;
+        for (const auto& [channelHandle, emulated] : mDirectChannels) {
+            emulated.channel->write(src[i].sensor, src[i].type, src[i].timestamp, src[i].data);
+        }
+    }
+}
+
+void Sensors::dropDirectOnlyEventsLocked(std::vector<Event>& events) const {
+    if (mDirectChannels.empty()) {
+        return;
+    }
 
-        convertFromSensorEvent(src, &event);
+    // Sensors only a direct channel enabled must not leak into the framework's event stream.
+    events.erase(std::remove_if(events.begin(), events.end(),
+                                [this](const Event& event) {
+                                    if (event.sensorType == SensorType::META_DATA ||
+                                        getDirectSamplingPeriodLocked(event.sensorHandle) == 0) {
+                                        return false;
+                                    }
+                                    auto request = mFrameworkRequests.find(event.sensorHandle);
+                                    return request == mFrameworkRequests.end() ||
+                                           !request->second.enabled;
+                                }),
+                 events.end());
+}
 
-        SensorInfo* sensor = nullptr;
-        for (auto& s : sensorsList) {
-            if (s.sensorHandle == event.sensorHandle) {
-                sensor = &s;
-                break;
-            }
+void Sensors::convertFromSensorEvents(size_t count, const sensors_event_t* srcArray,
+                                      std::vector<Event>& dstVec) const {
+    size_t first = dstVec.size();
+    dstVec.resize(first + count);
+    convertFromSensorEventBatch(srcArray, count, &dstVec[first]);
+
+    // Drop the pickup events that are not a pickup, compacting in place.
+    size_t kept = first;
+    for (size_t i = first; i < dstVec.size(); ++i) {
+        Event& event = dstVec[i];
+
+        const SensorInfo* sensor = nullptr;
+        auto index = mSensorIndex.find(event.sensorHandle);
+        if (index != mSensorIndex.end()) {
+            sensor = &mSensorList[index->second];
         }
 
         if (sensor && sensor->type == SensorType::PICK_UP_GESTURE) {
@@ -335,8 +580,12 @@ void Sensors::convertFromSensorEvents(size_t count, const sensors_event_t* srcAr
             event.sensorType = SensorType::PICK_UP_GESTURE;
         }
 
-        dstVec.push_back(event);
+        if (kept != i) {
+            dstVec[kept] = event;
+        }
+        ++kept;
     }
+    dstVec.resize(kept);
 }
 
 ISensors* HIDL_FETCH_ISensors(const char* /* hal */) {
@@ -16,10 +16,14 @@
 
 #pragma once
 
+#include <DirectChannel.h>
 #include <android-base/macros.h>
 #include <android/hardware/sensors/1.0/ISensors.h>
 #include <hardware/sensors.h>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace android {
@@ -28,9 +32,14 @@ namespace sensors {
 namespace V1_0 {
 namespace implementation {
 
+using ::android::sensors::xiaomi::DirectChannel;
+
 struct Sensors : public ::android::hardware::sensors::V1_0::ISensors {
     Sensors();
 
+    //! Serve an already loaded module, such as a fake one in benchmarks.
+    explicit Sensors(sensors_module_t* module);
+
     status_t initCheck() const;
 
     Return<void> getSensorsList(getSensorsList_cb _hidl_cb) override;
@@ -63,12 +72,43 @@ struct Sensors : public ::android::hardware::sensors::V1_0::ISensors {
     sensors_poll_device_1_t* mSensorDevice;
     std::mutex mPollLock;
 
+    // The patched sensor list is built once, the module's list never changes.
+    std::vector<SensorInfo> mSensorList;
+    std::unordered_map<int32_t, size_t> mSensorIndex;
+
+    // Reused by every poll() call, guarded by mPollLock. poll() takes mPollEvents out of the
+    // member while its callback runs.
+    std::unique_ptr<sensors_event_t[]> mPollBuffer;
+    std::vector<Event> mPollEvents;
+
+    // Modules without the direct report entry points get direct channels emulated on top of
+    // poll(): polled events are written into the client's ring before conversion.
+    struct EmulatedDirectChannel {
+        std::unique_ptr<DirectChannel> channel;
+        std::unordered_map<int32_t, int64_t> samplingPeriodsNs;
+    };
+    struct FrameworkRequest {
+        bool enabled = false;
+        int64_t samplingPeriodNs = 0;
+        int64_t maxReportLatencyNs = 0;
+    };
+    bool mEmulateDirectChannels;
+    std::mutex mDirectChannelLock;
+    std::map<int32_t, EmulatedDirectChannel> mDirectChannels;
+    std::unordered_map<int32_t, FrameworkRequest> mFrameworkRequests;
+    int32_t mNextDirectChannelHandle = 1;
+
     int getHalDeviceVersion() const;
     std::vector<SensorInfo> getFixedUpSensorList();
 
-    static void convertFromSensorEvents(size_t count, const sensors_event_t* src,
-                                        std::vector<Event>& dst,
-                                        std::vector<SensorInfo> sensorsList);
+    void addEmulatedDirectReportFlags(SensorInfo& sensor) const;
+    int64_t getDirectSamplingPeriodLocked(int32_t sensorHandle) const;
+    Result updateEmulatedSensorLocked(int32_t sensorHandle);
+    void writeDirectChannelsLocked(size_t count, const sensors_event_t* src);
+    void dropDirectOnlyEventsLocked(std::vector<Event>& events) const;
+
+    void convertFromSensorEvents(size_t count, const sensors_event_t* src,
+                                 std::vector<Event>& dst) const;
 
     DISALLOW_COPY_AND_ASSIGN(Sensors);
 };
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "convert.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V1_0 {
+namespace implementation {
+
+namespace {
+
+//! As many events as Sensors::poll() converts at most per call.
+constexpr size_t kBatchSize = 128;
+
+//! Mostly IMU samples, with the odd environment, counter and fusion event in between.
+constexpr int32_t kBatchTypes[] = {
+        SENSOR_TYPE_ACCELEROMETER,         SENSOR_TYPE_GYROSCOPE,
+        SENSOR_TYPE_ACCELEROMETER,         SENSOR_TYPE_GYROSCOPE,
+        SENSOR_TYPE_MAGNETIC_FIELD,        SENSOR_TYPE_GAME_ROTATION_VECTOR,
+        SENSOR_TYPE_ACCELEROMETER,         SENSOR_TYPE_GYROSCOPE,
+        SENSOR_TYPE_GYROSCOPE_UNCALIBRATED, SENSOR_TYPE_ROTATION_VECTOR,
+        SENSOR_TYPE_ACCELEROMETER,         SENSOR_TYPE_GYROSCOPE,
+        SENSOR_TYPE_LIGHT,                 SENSOR_TYPE_STEP_COUNTER,
+        SENSOR_TYPE_PROXIMITY,             SENSOR_TYPE_META_DATA,
+};
+
+std::vector<sensors_event_t> makeBatch() {
+    std::vector<sensors_event_t> batch(kBatchSize);
+    for (size_t i = 0; i < kBatchSize; i++) {
+        sensors_event_t& event = batch[i];
+        memset(&event, 0, sizeof(event));
+        event.version = sizeof(event);
+        event.sensor = static_cast<int32_t>(i % 8 + 1);
+        event.type = kBatchTypes[i % (sizeof(kBatchTypes) / sizeof(kBatchTypes[0]))];
+        event.timestamp = static_cast<int64_t>(i) * 1000000;
+        for (size_t j = 0; j < 16; j++) {
+            event.data[j] = static_cast<float>(i + j);
+        }
+    }
+    return batch;
+}
+
+/**
+ * How convert.cpp turned an event over before the payload table, trimmed to the types in
+ * kBatchTypes and the fallback.
+ */
+void convertFromSensorEventWithSwitch(const sensors_event_t& src, Event* dst) {
+    *dst = {
+            .timestamp = src.timestamp,
+            .sensorHandle = src.sensor,
+            .sensorType = (SensorType)src.type,
+    };
+
+    switch (dst->sensorType) {
+        case SensorType::META_DATA: {
+            dst->u.meta.what = (MetaDataEventType)src.meta_data.what;
+            dst->sensorHandle = src.meta_data.sensor;
+            break;
+        }
+
+        case SensorType::ACCELEROMETER:
+        case SensorType::MAGNETIC_FIELD:
+        case SensorType::GYROSCOPE: {
+            dst->u.vec3.x = src.acceleration.x;
+            dst->u.vec3.y = src.acceleration.y;
+            dst->u.vec3.z = src.acceleration.z;
+            dst->u.vec3.status = (SensorStatus)src.acceleration.status;
+            break;
+        }
+
+        case SensorType::GAME_ROTATION_VECTOR: {
+            dst->u.vec4.x = src.data[0];
+            dst->u.vec4.y = src.data[1];
+            dst->u.vec4.z = src.data[2];
+            dst->u.vec4.w = src.data[3];
+            break;
+        }
+
+        case SensorType::ROTATION_VECTOR: {
+            dst->u.data[0] = src.data[0];
+            dst->u.data[1] = src.data[1];
+            dst->u.data[2] = src.data[2];
+            dst->u.data[3] = src.data[3];
+            dst->u.data[4] = src.data[4];
+            break;
+        }
+
+        case SensorType::GYROSCOPE_UNCALIBRATED: {
+            dst->u.uncal.x = src.uncalibrated_gyro.x_uncalib;
+            dst->u.uncal.y = src.uncalibrated_gyro.y_uncalib;
+            dst->u.uncal.z = src.uncalibrated_gyro.z_uncalib;
+            dst->u.uncal.x_bias = src.uncalibrated_gyro.x_bias;
+            dst->u.uncal.y_bias = src.uncalibrated_gyro.y_bias;
+            dst->u.uncal.z_bias = src.uncalibrated_gyro.z_bias;
+            break;
+        }
+
+        case SensorType::LIGHT:
+        case SensorType::PROXIMITY: {
+            dst->u.scalar = src.data[0];
+            break;
+        }
+
+        case SensorType::STEP_COUNTER: {
+            dst->u.stepCount = src.u64.step_counter;
+            break;
+        }
+
+        default: {
+            memcpy(dst->u.data.data(), src.data, 16 * sizeof(float));
+            break;
+        }
+    }
+}
+
+}  // namespace
+
+static void BM_ConvertBatchWithSwitch(benchmark::State& state) {
+    std::vector<sensors_event_t> src = makeBatch();
+    std::vector<Event> dst(kBatchSize);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBatchSize; i++) {
+            convertFromSensorEventWithSwitch(src[i], &dst[i]);
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConvertBatchWithSwitch);
+
+static void BM_ConvertBatchPerEvent(benchmark::State& state) {
+    std::vector<sensors_event_t> src = makeBatch();
+    std::vector<Event> dst(kBatchSize);
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBatchSize; i++) {
+            convertFromSensorEvent(src[i], &dst[i]);
+        }
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConvertBatchPerEvent);
+
+static void BM_ConvertBatch(benchmark::State& state) {
+    std::vector<sensors_event_t> src = makeBatch();
+    std::vector<Event> dst(kBatchSize);
+    for (auto _ : state) {
+        convertFromSensorEventBatch(src.data(), kBatchSize, dst.data());
+        benchmark::DoNotOptimize(dst.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConvertBatch);
+
+// The way back, which emulated direct channels and injection take.
+static void BM_ConvertBatchToSensorEvents(benchmark::State& state) {
+    std::vector<sensors_event_t> batch = makeBatch();
+    std::vector<Event> src(kBatchSize);
+    convertFromSensorEventBatch(batch.data(), kBatchSize, src.data());
+    for (auto _ : state) {
+        for (size_t i = 0; i < kBatchSize; i++) {
+            convertToSensorEvent(src[i], &batch[i]);
+        }
+        benchmark::DoNotOptimize(batch.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * kBatchSize);
+}
+BENCHMARK(BM_ConvertBatchToSensorEvents);
+
+}  // namespace implementation
+}  // namespace V1_0
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,165 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "Sensors.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V1_0 {
+namespace implementation {
+
+namespace {
+
+//! About what a phone module lists once the physical, virtual and gesture sensors add up.
+constexpr size_t kNumSensors = 50;
+constexpr int32_t kSensorTypes[] = {
+        SENSOR_TYPE_ACCELEROMETER, SENSOR_TYPE_GYROSCOPE, SENSOR_TYPE_MAGNETIC_FIELD,
+        SENSOR_TYPE_LIGHT,         SENSOR_TYPE_PROXIMITY, SENSOR_TYPE_GAME_ROTATION_VECTOR,
+};
+
+/**
+ * A legacy module listing kNumSensors continuous sensors. Its device returns as many events as
+ * poll() asks for at once, one per sensor in turn, so only the wrapper's own cost is measured.
+ */
+struct FakeModule {
+    FakeModule() {
+        for (size_t i = 0; i < kNumSensors; i++) {
+            sensor_t& sensor = sensors[i];
+            sensor.name = "Fake sensor";
+            sensor.vendor = "LineageOS";
+            sensor.version = 1;
+            sensor.handle = static_cast<int>(i + 1);
+            sensor.type = kSensorTypes[i % (sizeof(kSensorTypes) / sizeof(kSensorTypes[0]))];
+            sensor.stringType = "org.lineageos.sensor.fake";
+            sensor.requiredPermission = "";
+            sensor.maxRange = 100.0f;
+            sensor.resolution = 0.01f;
+            sensor.power = 0.1f;
+            sensor.minDelay = 5000;
+            sensor.maxDelay = 200000;
+            sensor.flags = SENSOR_FLAG_CONTINUOUS_MODE;
+        }
+
+        methods.open = open;
+        module.common.tag = HARDWARE_MODULE_TAG;
+        module.common.id = SENSORS_HARDWARE_MODULE_ID;
+        module.common.name = "Fake sensors module";
+        module.common.methods = &methods;
+        module.get_sensors_list = getSensorsList;
+        module.set_operation_mode = setOperationMode;
+
+        device.common.tag = HARDWARE_DEVICE_TAG;
+        device.common.version = SENSORS_DEVICE_API_VERSION_1_4;
+        device.common.module = &module.common;
+        device.common.close = closeDevice;
+        device.activate = activate;
+        device.setDelay = setDelay;
+        device.poll = poll;
+        device.batch = batch;
+        device.flush = flush;
+        device.inject_sensor_data = injectSensorData;
+    }
+
+    static FakeModule& get() {
+        static FakeModule sModule;
+        return sModule;
+    }
+
+    static int open(const hw_module_t* /* module */, const char* /* id */, hw_device_t** device) {
+        *device = &get().device.common;
+        return 0;
+    }
+
+    static int closeDevice(hw_device_t* /* device */) { return 0; }
+
+    static int getSensorsList(sensors_module_t* /* module */, const sensor_t** list) {
+        *list = get().sensors;
+        return kNumSensors;
+    }
+
+    static int setOperationMode(unsigned int /* mode */) { return 0; }
+
+    static int activate(sensors_poll_device_t* /* device */, int /* handle */, int /* enabled */) {
+        return 0;
+    }
+
+    static int setDelay(sensors_poll_device_t* /* device */, int /* handle */, int64_t /* ns */) {
+        return 0;
+    }
+
+    static int poll(sensors_poll_device_t* /* device */, sensors_event_t* data, int count) {
+        FakeModule& fake = get();
+        for (int i = 0; i < count; i++) {
+            const sensor_t& sensor = fake.sensors[fake.nextSensor];
+            fake.nextSensor = (fake.nextSensor + 1) % kNumSensors;
+
+            sensors_event_t& event = data[i];
+            memset(&event, 0, sizeof(event));
+            event.version = sizeof(event);
+            event.sensor = sensor.handle;
+            event.type = sensor.type;
+            event.timestamp = ++fake.timestamp;
+            event.data[0] = 1.0f;
+            event.data[1] = 2.0f;
+            event.data[2] = 3.0f;
+        }
+        return count;
+    }
+
+    static int batch(sensors_poll_device_1_t* /* device */, int /* handle */, int /* flags */,
+                     int64_t /* samplingPeriodNs */, int64_t /* maxReportLatencyNs */) {
+        return 0;
+    }
+
+    static int flush(sensors_poll_device_1_t* /* device */, int /* handle */) { return 0; }
+
+    static int injectSensorData(sensors_poll_device_1_t* /* device */,
+                                const sensors_event_t* /* data */) {
+        return 0;
+    }
+
+    sensor_t sensors[kNumSensors] = {};
+    hw_module_methods_t methods = {};
+    sensors_module_t module = {};
+    sensors_poll_device_1_t device = {};
+    size_t nextSensor = 0;
+    int64_t timestamp = 0;
+};
+
+}  // namespace
+
+// One poll() round trip for a batch of state.range(0) events: the device read, the direct
+// channel emulation the fake module needs, the conversion and the callback.
+static void BM_Poll(benchmark::State& state) {
+    Sensors sensors(&FakeModule::get().module);
+    if (sensors.initCheck() != OK) {
+        state.SkipWithError("the fake module did not open");
+        return;
+    }
+
+    int32_t maxCount = static_cast<int32_t>(state.range(0));
+    size_t received = 0;
+    for (auto _ : state) {
+        sensors.poll(maxCount, [&](Result /* result */, const hidl_vec<Event>& events,
+                                   const hidl_vec<SensorInfo>& /* dynamicSensorsAdded */) {
+            received += events.size();
+            benchmark::DoNotOptimize(events.data());
+        });
+    }
+    state.SetItemsProcessed(received);
+}
+BENCHMARK(BM_Poll)->Arg(1)->Arg(16)->Arg(128);
+
+}  // namespace implementation
+}  // namespace V1_0
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
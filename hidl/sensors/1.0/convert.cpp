@@ -18,6 +18,9 @@
 
 #include <android-base/logging.h>
 
+#include <array>
+#include <cstring>
+
 namespace android {
 namespace hardware {
 namespace sensors {
@@ -61,139 +64,175 @@ void convertToSensor(const ::android::hardware::sensors::V1_0::SensorInfo& src,
     dst->reserved[0] = dst->reserved[1] = 0;
 }
 
-void convertFromSensorEvent(const sensors_event_t& src, Event* dst) {
-    typedef ::android::hardware::sensors::V1_0::SensorType SensorType;
-    typedef ::android::hardware::sensors::V1_0::MetaDataEventType MetaDataEventType;
+namespace {
 
-    *dst = {
-            .timestamp = src.timestamp,
-            .sensorHandle = src.sensor,
-            .sensorType = (SensorType)src.type,
+typedef ::android::hardware::sensors::V1_0::EventPayload EventPayload;
+
+/*
+ * The event payload and the union following the timestamp in sensors_event_t share the same
+ * layout for every sensor type except meta data and dynamic sensor meta events, so converting
+ * a payload is a single copy of the bytes the type actually uses.
+ */
+constexpr size_t kPayloadSize = sizeof(sensors_event_t::data);
+static_assert(sizeof(EventPayload) == kPayloadSize, "payload size mismatch");
+static_assert(sizeof(sensors_vec_t) == 4 * sizeof(float), "vec3 layout mismatch");
+static_assert(sizeof(uncalibrated_event_t) == 6 * sizeof(float), "uncal layout mismatch");
+static_assert(sizeof(heart_rate_event_t) == 2 * sizeof(float), "heart rate layout mismatch");
+static_assert(sizeof(additional_info_event_t) == kPayloadSize, "additional info mismatch");
+
+struct PayloadLayout {
+    enum Kind : uint8_t {
+        COPY,
+        META_DATA,
+        DYNAMIC_SENSOR_META,
     };
 
-    switch (dst->sensorType) {
-        case SensorType::META_DATA: {
-            dst->u.meta.what = (MetaDataEventType)src.meta_data.what;
-            // Legacy HALs contain the handle reference in the meta data field.
-            // Copy that over to the handle of the event. In legacy HALs this
-            // field was expected to be 0.
-            dst->sensorHandle = src.meta_data.sensor;
-            break;
-        }
+    Kind kind;
+    // Bytes copied for COPY, the rest of the payload is zeroed.
+    uint8_t size;
+};
 
-        case SensorType::ACCELEROMETER:
-        case SensorType::MAGNETIC_FIELD:
-        case SensorType::ORIENTATION:
-        case SensorType::GYROSCOPE:
-        case SensorType::GRAVITY:
-        case SensorType::LINEAR_ACCELERATION: {
-            dst->u.vec3.x = src.acceleration.x;
-            dst->u.vec3.y = src.acceleration.y;
-            dst->u.vec3.z = src.acceleration.z;
-            dst->u.vec3.status = (SensorStatus)src.acceleration.status;
-            break;
-        }
+// Sensor types past this, including device private ones, copy the whole payload.
+constexpr size_t kNumPayloadLayouts =
+        static_cast<size_t>(SensorType::ACCELEROMETER_UNCALIBRATED) + 1;
 
-        case SensorType::GAME_ROTATION_VECTOR: {
-            dst->u.vec4.x = src.data[0];
-            dst->u.vec4.y = src.data[1];
-            dst->u.vec4.z = src.data[2];
-            dst->u.vec4.w = src.data[3];
-            break;
-        }
+constexpr std::array<PayloadLayout, kNumPayloadLayouts> makePayloadLayouts() {
+    std::array<PayloadLayout, kNumPayloadLayouts> layouts{};
+    auto set = [&layouts](SensorType type, PayloadLayout layout) {
+        layouts[static_cast<size_t>(type)] = layout;
+    };
 
-        case SensorType::ROTATION_VECTOR:
-        case SensorType::GEOMAGNETIC_ROTATION_VECTOR: {
-            dst->u.data[0] = src.data[0];
-            dst->u.data[1] = src.data[1];
-            dst->u.data[2] = src.data[2];
-            dst->u.data[3] = src.data[3];
-            dst->u.data[4] = src.data[4];
-            break;
-        }
+    for (auto& layout : layouts) {
+        layout = {PayloadLayout::COPY, kPayloadSize};
+    }
 
-        case SensorType::MAGNETIC_FIELD_UNCALIBRATED:
-        case SensorType::GYROSCOPE_UNCALIBRATED:
-        case SensorType::ACCELEROMETER_UNCALIBRATED: {
-            dst->u.uncal.x = src.uncalibrated_gyro.x_uncalib;
-            dst->u.uncal.y = src.uncalibrated_gyro.y_uncalib;
-            dst->u.uncal.z = src.uncalibrated_gyro.z_uncalib;
-            dst->u.uncal.x_bias = src.uncalibrated_gyro.x_bias;
-            dst->u.uncal.y_bias = src.uncalibrated_gyro.y_bias;
-            dst->u.uncal.z_bias = src.uncalibrated_gyro.z_bias;
-            break;
-        }
+    set(SensorType::META_DATA, {PayloadLayout::META_DATA, 0});
+    set(SensorType::DYNAMIC_SENSOR_META, {PayloadLayout::DYNAMIC_SENSOR_META, 0});
 
-        case SensorType::DEVICE_ORIENTATION:
-        case SensorType::LIGHT:
-        case SensorType::PRESSURE:
-        case SensorType::TEMPERATURE:
-        case SensorType::PROXIMITY:
-        case SensorType::RELATIVE_HUMIDITY:
-        case SensorType::AMBIENT_TEMPERATURE:
-        case SensorType::SIGNIFICANT_MOTION:
-        case SensorType::STEP_DETECTOR:
-        case SensorType::TILT_DETECTOR:
-        case SensorType::WAKE_GESTURE:
-        case SensorType::GLANCE_GESTURE:
-        case SensorType::PICK_UP_GESTURE:
-        case SensorType::WRIST_TILT_GESTURE:
-        case SensorType::STATIONARY_DETECT:
-        case SensorType::MOTION_DETECT:
-        case SensorType::HEART_BEAT:
-        case SensorType::LOW_LATENCY_OFFBODY_DETECT: {
-            dst->u.scalar = src.data[0];
-            break;
-        }
+    for (SensorType type : {SensorType::ACCELEROMETER, SensorType::MAGNETIC_FIELD,
+                            SensorType::ORIENTATION, SensorType::GYROSCOPE, SensorType::GRAVITY,
+                            SensorType::LINEAR_ACCELERATION}) {
+        set(type, {PayloadLayout::COPY, sizeof(sensors_vec_t)});
+    }
 
-        case SensorType::STEP_COUNTER: {
-            dst->u.stepCount = src.u64.step_counter;
-            break;
-        }
+    set(SensorType::GAME_ROTATION_VECTOR, {PayloadLayout::COPY, 4 * sizeof(float)});
+    set(SensorType::ROTATION_VECTOR, {PayloadLayout::COPY, 5 * sizeof(float)});
+    set(SensorType::GEOMAGNETIC_ROTATION_VECTOR, {PayloadLayout::COPY, 5 * sizeof(float)});
 
-        case SensorType::HEART_RATE: {
-            dst->u.heartRate.bpm = src.heart_rate.bpm;
-            dst->u.heartRate.status = (SensorStatus)src.heart_rate.status;
-            break;
-        }
+    for (SensorType type : {SensorType::MAGNETIC_FIELD_UNCALIBRATED,
+                            SensorType::GYROSCOPE_UNCALIBRATED,
+                            SensorType::ACCELEROMETER_UNCALIBRATED}) {
+        set(type, {PayloadLayout::COPY, sizeof(uncalibrated_event_t)});
+    }
 
-        case SensorType::POSE_6DOF: {  // 15 floats
-            for (size_t i = 0; i < 15; ++i) {
-                dst->u.pose6DOF[i] = src.data[i];
-            }
-            break;
-        }
+    for (SensorType type :
+         {SensorType::DEVICE_ORIENTATION, SensorType::LIGHT, SensorType::PRESSURE,
+          SensorType::TEMPERATURE, SensorType::PROXIMITY, SensorType::RELATIVE_HUMIDITY,
+          SensorType::AMBIENT_TEMPERATURE, SensorType::SIGNIFICANT_MOTION,
+          SensorType::STEP_DETECTOR, SensorType::TILT_DETECTOR, SensorType::WAKE_GESTURE,
+          SensorType::GLANCE_GESTURE, SensorType::PICK_UP_GESTURE, SensorType::WRIST_TILT_GESTURE,
+          SensorType::STATIONARY_DETECT, SensorType::MOTION_DETECT, SensorType::HEART_BEAT,
+          SensorType::LOW_LATENCY_OFFBODY_DETECT}) {
+        set(type, {PayloadLayout::COPY, sizeof(float)});
+    }
 
-        case SensorType::DYNAMIC_SENSOR_META: {
-            dst->u.dynamic.connected = src.dynamic_sensor_meta.connected;
-            dst->u.dynamic.sensorHandle = src.dynamic_sensor_meta.handle;
+    set(SensorType::STEP_COUNTER, {PayloadLayout::COPY, sizeof(uint64_t)});
+    set(SensorType::HEART_RATE, {PayloadLayout::COPY, sizeof(heart_rate_event_t)});
+    set(SensorType::POSE_6DOF, {PayloadLayout::COPY, 15 * sizeof(float)});
+    set(SensorType::ADDITIONAL_INFO, {PayloadLayout::COPY, sizeof(additional_info_event_t)});
 
-            memcpy(dst->u.dynamic.uuid.data(), src.dynamic_sensor_meta.uuid, 16);
+    return layouts;
+}
 
-            break;
-        }
+constexpr std::array<PayloadLayout, kNumPayloadLayouts> kPayloadLayouts = makePayloadLayouts();
 
-        case SensorType::ADDITIONAL_INFO: {
-            ::android::hardware::sensors::V1_0::AdditionalInfo* dstInfo = &dst->u.additional;
+inline PayloadLayout getPayloadLayout(int32_t type) {
+    if (type >= 0 && static_cast<size_t>(type) < kNumPayloadLayouts) {
+        return kPayloadLayouts[type];
+    }
+    return {PayloadLayout::COPY, kPayloadSize};
+}
 
-            const additional_info_event_t& srcInfo = src.additional_info;
+/*
+ * Copies the first N bytes of a payload and zeroes the rest. With the sizes known at compile
+ * time this is a few register moves, where a memcpy and memset of variable length turn into
+ * string instructions or library calls whose startup cost is well above moving 64 bytes.
+ */
+template <size_t N>
+inline void copyPayload(void* dst, const void* src) {
+    memcpy(dst, src, N);
+    memset(static_cast<uint8_t*>(dst) + N, 0, kPayloadSize - N);
+}
 
-            dstInfo->type = (::android::hardware::sensors::V1_0::AdditionalInfoType)srcInfo.type;
+inline void copyPayload(void* dst, const void* src, size_t size) {
+    // Every size in kPayloadLayouts.
+    switch (size) {
+        case sizeof(float):
+            return copyPayload<sizeof(float)>(dst, src);
+        case sizeof(uint64_t):
+            return copyPayload<sizeof(uint64_t)>(dst, src);
+        case sizeof(sensors_vec_t):
+            return copyPayload<sizeof(sensors_vec_t)>(dst, src);
+        case 5 * sizeof(float):
+            return copyPayload<5 * sizeof(float)>(dst, src);
+        case sizeof(uncalibrated_event_t):
+            return copyPayload<sizeof(uncalibrated_event_t)>(dst, src);
+        case 15 * sizeof(float):
+            return copyPayload<15 * sizeof(float)>(dst, src);
+        case kPayloadSize:
+            return copyPayload<kPayloadSize>(dst, src);
+        default:
+            memcpy(dst, src, size);
+            memset(static_cast<uint8_t*>(dst) + size, 0, kPayloadSize - size);
+            return;
+    }
+}
+
+}  // namespace
+
+void convertFromSensorEvent(const sensors_event_t& src, Event* dst) {
+    typedef ::android::hardware::sensors::V1_0::SensorType SensorType;
+    typedef ::android::hardware::sensors::V1_0::MetaDataEventType MetaDataEventType;
 
-            dstInfo->serial = srcInfo.serial;
+    dst->timestamp = src.timestamp;
+    dst->sensorHandle = src.sensor;
+    dst->sensorType = (SensorType)src.type;
 
-            CHECK_EQ(sizeof(dstInfo->u), sizeof(srcInfo.data_int32));
-            memcpy(&dstInfo->u, srcInfo.data_int32, sizeof(srcInfo.data_int32));
+    PayloadLayout layout = getPayloadLayout(src.type);
+    switch (layout.kind) {
+        case PayloadLayout::COPY: {
+            copyPayload(&dst->u, src.data, layout.size);
             break;
         }
 
-        default: {
-            memcpy(dst->u.data.data(), src.data, 16 * sizeof(float));
+        case PayloadLayout::META_DATA: {
+            memset(&dst->u, 0, kPayloadSize);
+            dst->u.meta.what = (MetaDataEventType)src.meta_data.what;
+            // Legacy HALs contain the handle reference in the meta data field.
+            // Copy that over to the handle of the event. In legacy HALs this
+            // field was expected to be 0.
+            dst->sensorHandle = src.meta_data.sensor;
+            break;
+        }
+
+        case PayloadLayout::DYNAMIC_SENSOR_META: {
+            memset(&dst->u, 0, kPayloadSize);
+            dst->u.dynamic.connected = src.dynamic_sensor_meta.connected;
+            dst->u.dynamic.sensorHandle = src.dynamic_sensor_meta.handle;
+
+            memcpy(dst->u.dynamic.uuid.data(), src.dynamic_sensor_meta.uuid, 16);
+
             break;
         }
     }
 }
 
+void convertFromSensorEventBatch(const sensors_event_t* src, size_t count, Event* dst) {
+    for (size_t i = 0; i < count; ++i) {
+        convertFromSensorEvent(src[i], &dst[i]);
+    }
+}
+
 void convertToSensorEvent(const Event& src, sensors_event_t* dst) {
     *dst = {.version = sizeof(sensors_event_t),
             .sensor = src.sensorHandle,
@@ -201,8 +240,14 @@ void convertToSensorEvent(const Event& src, sensors_event_t* dst) {
             .reserved0 = 0,
             .timestamp = src.timestamp};
 
-    switch (src.sensorType) {
-        case SensorType::META_DATA: {
+    PayloadLayout layout = getPayloadLayout(dst->type);
+    switch (layout.kind) {
+        case PayloadLayout::COPY: {
+            copyPayload(dst->data, &src.u, layout.size);
+            break;
+        }
+
+        case PayloadLayout::META_DATA: {
             // Legacy HALs expect the handle reference in the meta data field.
             // Copy it over from the handle of the event.
             dst->meta_data.what = (int32_t)src.u.meta.what;
@@ -212,90 +257,7 @@ void convertToSensorEvent(const Event& src, sensors_event_t* dst) {
             break;
         }
 
-        case SensorType::ACCELEROMETER:
-        case SensorType::MAGNETIC_FIELD:
-        case SensorType::ORIENTATION:
-        case SensorType::GYROSCOPE:
-        case SensorType::GRAVITY:
-        case SensorType::LINEAR_ACCELERATION: {
-            dst->acceleration.x = src.u.vec3.x;
-            dst->acceleration.y = src.u.vec3.y;
-            dst->acceleration.z = src.u.vec3.z;
-            dst->acceleration.status = (int8_t)src.u.vec3.status;
-            break;
-        }
-
-        case SensorType::GAME_ROTATION_VECTOR: {
-            dst->data[0] = src.u.vec4.x;
-            dst->data[1] = src.u.vec4.y;
-            dst->data[2] = src.u.vec4.z;
-            dst->data[3] = src.u.vec4.w;
-            break;
-        }
-
-        case SensorType::ROTATION_VECTOR:
-        case SensorType::GEOMAGNETIC_ROTATION_VECTOR: {
-            dst->data[0] = src.u.data[0];
-            dst->data[1] = src.u.data[1];
-            dst->data[2] = src.u.data[2];
-            dst->data[3] = src.u.data[3];
-            dst->data[4] = src.u.data[4];
-            break;
-        }
-
-        case SensorType::MAGNETIC_FIELD_UNCALIBRATED:
-        case SensorType::GYROSCOPE_UNCALIBRATED:
-        case SensorType::ACCELEROMETER_UNCALIBRATED: {
-            dst->uncalibrated_gyro.x_uncalib = src.u.uncal.x;
-            dst->uncalibrated_gyro.y_uncalib = src.u.uncal.y;
-            dst->uncalibrated_gyro.z_uncalib = src.u.uncal.z;
-            dst->uncalibrated_gyro.x_bias = src.u.uncal.x_bias;
-            dst->uncalibrated_gyro.y_bias = src.u.uncal.y_bias;
-            dst->uncalibrated_gyro.z_bias = src.u.uncal.z_bias;
-            break;
-        }
-
-        case SensorType::DEVICE_ORIENTATION:
-        case SensorType::LIGHT:
-        case SensorType::PRESSURE:
-        case SensorType::TEMPERATURE:
-        case SensorType::PROXIMITY:
-        case SensorType::RELATIVE_HUMIDITY:
-        case SensorType::AMBIENT_TEMPERATURE:
-        case SensorType::SIGNIFICANT_MOTION:
-        case SensorType::STEP_DETECTOR:
-        case SensorType::TILT_DETECTOR:
-        case SensorType::WAKE_GESTURE:
-        case SensorType::GLANCE_GESTURE:
-        case SensorType::PICK_UP_GESTURE:
-        case SensorType::WRIST_TILT_GESTURE:
-        case SensorType::STATIONARY_DETECT:
-        case SensorType::MOTION_DETECT:
-        case SensorType::HEART_BEAT:
-        case SensorType::LOW_LATENCY_OFFBODY_DETECT: {
-            dst->data[0] = src.u.scalar;
-            break;
-        }
-
-        case SensorType::STEP_COUNTER: {
-            dst->u64.step_counter = src.u.stepCount;
-            break;
-        }
-
-        case SensorType::HEART_RATE: {
-            dst->heart_rate.bpm = src.u.heartRate.bpm;
-            dst->heart_rate.status = (int8_t)src.u.heartRate.status;
-            break;
-        }
-
-        case SensorType::POSE_6DOF: {  // 15 floats
-            for (size_t i = 0; i < 15; ++i) {
-                dst->data[i] = src.u.pose6DOF[i];
-            }
-            break;
-        }
-
-        case SensorType::DYNAMIC_SENSOR_META: {
+        case PayloadLayout::DYNAMIC_SENSOR_META: {
             dst->dynamic_sensor_meta.connected = src.u.dynamic.connected;
             dst->dynamic_sensor_meta.handle = src.u.dynamic.sensorHandle;
             dst->dynamic_sensor_meta.sensor = NULL;  // to be filled in later
@@ -304,25 +266,6 @@ void convertToSensorEvent(const Event& src, sensors_event_t* dst) {
 
             break;
         }
-
-        case SensorType::ADDITIONAL_INFO: {
-            const ::android::hardware::sensors::V1_0::AdditionalInfo& srcInfo = src.u.additional;
-
-            additional_info_event_t* dstInfo = &dst->additional_info;
-            dstInfo->type = (int32_t)srcInfo.type;
-            dstInfo->serial = srcInfo.serial;
-
-            CHECK_EQ(sizeof(srcInfo.u), sizeof(dstInfo->data_int32));
-
-            memcpy(dstInfo->data_int32, &srcInfo.u, sizeof(dstInfo->data_int32));
-
-            break;
-        }
-
-        default: {
-            memcpy(dst->data, src.u.data.data(), 16 * sizeof(float));
-            break;
-        }
     }
 }
 
@@ -29,6 +29,7 @@ void convertFromSensor(const sensor_t& src, SensorInfo* dst);
 void convertToSensor(const SensorInfo& src, sensor_t* dst);
 
 void convertFromSensorEvent(const sensors_event_t& src, Event* dst);
+void convertFromSensorEventBatch(const sensors_event_t* src, size_t count, Event* dst);
 void convertToSensorEvent(const Event& src, sensors_event_t* dst);
 
 bool convertFromSharedMemInfo(const SharedMemInfo& memIn, sensors_direct_mem_t* memOut);
@@ -0,0 +1,185 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "convert.h"
+
+#include <gtest/gtest.h>
+#include <hidl/HidlSupport.h>
+
+#include <cstring>
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V1_0 {
+namespace implementation {
+
+namespace {
+
+constexpr int32_t kSensorHandle = 5;
+constexpr int64_t kTimestamp = 123456789;
+
+Event makeEvent(SensorType type) {
+    Event event;
+    event.timestamp = kTimestamp;
+    event.sensorHandle = kSensorHandle;
+    event.sensorType = type;
+    // A distinct non-zero value in every byte, so a field copied from the wrong offset shows.
+    uint8_t* payload = reinterpret_cast<uint8_t*>(&event.u);
+    for (size_t i = 0; i < sizeof(event.u); i++) {
+        payload[i] = static_cast<uint8_t>(i + 1);
+    }
+    return event;
+}
+
+void expectBytesEqual(const void* expected, const void* actual, size_t size) {
+    EXPECT_EQ(0, memcmp(expected, actual, size));
+}
+
+//! Compare the payload fields the sensor type defines, as the field by field conversion did.
+void expectPayloadEqual(const Event& expected, const Event& actual) {
+    const EventPayload& e = expected.u;
+    const EventPayload& a = actual.u;
+    switch (expected.sensorType) {
+        case SensorType::META_DATA:
+            EXPECT_EQ(e.meta.what, a.meta.what);
+            break;
+        case SensorType::DYNAMIC_SENSOR_META:
+            EXPECT_EQ(e.dynamic.connected, a.dynamic.connected);
+            EXPECT_EQ(e.dynamic.sensorHandle, a.dynamic.sensorHandle);
+            expectBytesEqual(e.dynamic.uuid.data(), a.dynamic.uuid.data(), 16);
+            break;
+        case SensorType::ACCELEROMETER:
+        case SensorType::MAGNETIC_FIELD:
+        case SensorType::ORIENTATION:
+        case SensorType::GYROSCOPE:
+        case SensorType::GRAVITY:
+        case SensorType::LINEAR_ACCELERATION:
+            expectBytesEqual(&e.vec3.x, &a.vec3.x, 3 * sizeof(float));
+            EXPECT_EQ(e.vec3.status, a.vec3.status);
+            break;
+        case SensorType::GAME_ROTATION_VECTOR:
+            expectBytesEqual(&e.vec4, &a.vec4, 4 * sizeof(float));
+            break;
+        case SensorType::ROTATION_VECTOR:
+        case SensorType::GEOMAGNETIC_ROTATION_VECTOR:
+            expectBytesEqual(e.data.data(), a.data.data(), 5 * sizeof(float));
+            break;
+        case SensorType::MAGNETIC_FIELD_UNCALIBRATED:
+        case SensorType::GYROSCOPE_UNCALIBRATED:
+        case SensorType::ACCELEROMETER_UNCALIBRATED:
+            expectBytesEqual(&e.uncal, &a.uncal, 6 * sizeof(float));
+            break;
+        case SensorType::DEVICE_ORIENTATION:
+        case SensorType::LIGHT:
+        case SensorType::PRESSURE:
+        case SensorType::TEMPERATURE:
+        case SensorType::PROXIMITY:
+        case SensorType::RELATIVE_HUMIDITY:
+        case SensorType::AMBIENT_TEMPERATURE:
+        case SensorType::SIGNIFICANT_MOTION:
+        case SensorType::STEP_DETECTOR:
+        case SensorType::TILT_DETECTOR:
+        case SensorType::WAKE_GESTURE:
+        case SensorType::GLANCE_GESTURE:
+        case SensorType::PICK_UP_GESTURE:
+        case SensorType::WRIST_TILT_GESTURE:
+        case SensorType::STATIONARY_DETECT:
+        case SensorType::MOTION_DETECT:
+        case SensorType::HEART_BEAT:
+        case SensorType::LOW_LATENCY_OFFBODY_DETECT:
+            expectBytesEqual(&e.scalar, &a.scalar, sizeof(float));
+            break;
+        case SensorType::STEP_COUNTER:
+            EXPECT_EQ(e.stepCount, a.stepCount);
+            break;
+        case SensorType::HEART_RATE:
+            expectBytesEqual(&e.heartRate.bpm, &a.heartRate.bpm, sizeof(float));
+            EXPECT_EQ(e.heartRate.status, a.heartRate.status);
+            break;
+        case SensorType::POSE_6DOF:
+            expectBytesEqual(e.pose6DOF.data(), a.pose6DOF.data(), 15 * sizeof(float));
+            break;
+        case SensorType::ADDITIONAL_INFO:
+            expectBytesEqual(&e.additional, &a.additional, sizeof(e.additional));
+            break;
+        default:
+            // Device private and unknown types carry the raw payload.
+            expectBytesEqual(e.data.data(), a.data.data(), 16 * sizeof(float));
+            break;
+    }
+}
+
+void expectRoundTrip(SensorType type) {
+    SCOPED_TRACE("sensor type " + toString(type));
+    Event event = makeEvent(type);
+
+    sensors_event_t legacy;
+    convertToSensorEvent(event, &legacy);
+    EXPECT_EQ(static_cast<int32_t>(type), legacy.type);
+    EXPECT_EQ(kTimestamp, legacy.timestamp);
+    if (type == SensorType::META_DATA) {
+        // Legacy HALs carry the handle in the meta data event instead.
+        EXPECT_EQ(0, legacy.sensor);
+        EXPECT_EQ(kSensorHandle, legacy.meta_data.sensor);
+    } else {
+        EXPECT_EQ(kSensorHandle, legacy.sensor);
+    }
+
+    Event converted;
+    convertFromSensorEvent(legacy, &converted);
+    EXPECT_EQ(type, converted.sensorType);
+    EXPECT_EQ(kTimestamp, converted.timestamp);
+    EXPECT_EQ(kSensorHandle, converted.sensorHandle);
+    expectPayloadEqual(event, converted);
+
+    // Converting the result again must not change anything, including the bytes past the
+    // fields of the type.
+    sensors_event_t legacyAgain;
+    convertToSensorEvent(converted, &legacyAgain);
+    Event convertedAgain;
+    convertFromSensorEvent(legacyAgain, &convertedAgain);
+    expectBytesEqual(&converted.u, &convertedAgain.u, sizeof(converted.u));
+}
+
+}  // namespace
+
+TEST(ConvertTest, EveryEventTypeRoundTrips) {
+    for (SensorType type : hidl_enum_range<SensorType>()) {
+        expectRoundTrip(type);
+    }
+}
+
+TEST(ConvertTest, DevicePrivateTypesRoundTrip) {
+    for (int32_t offset : {1, 2, 1000}) {
+        expectRoundTrip(static_cast<SensorType>(
+                static_cast<int32_t>(SensorType::DEVICE_PRIVATE_BASE) + offset));
+    }
+}
+
+TEST(ConvertTest, UnusedLegacyPayloadIsNotCopied) {
+    sensors_event_t legacy;
+    memset(&legacy, 0xff, sizeof(legacy));
+    legacy.sensor = kSensorHandle;
+    legacy.type = static_cast<int32_t>(SensorType::LIGHT);
+    legacy.timestamp = kTimestamp;
+    legacy.light = 42.0f;
+
+    Event event;
+    convertFromSensorEvent(legacy, &event);
+    EXPECT_EQ(42.0f, event.u.scalar);
+    const uint8_t* payload = reinterpret_cast<const uint8_t*>(&event.u);
+    for (size_t i = sizeof(float); i < sizeof(event.u); i++) {
+        ASSERT_EQ(0, payload[i]) << "at byte " << i;
+    }
+}
+
+}  // namespace implementation
+}  // namespace V1_0
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
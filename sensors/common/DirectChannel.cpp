@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "DirectChannel.h"
+
+#include <log/log.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+using ::android::hardware::sensors::V1_0::SensorsEventFormatOffset;
+using ::android::hardware::sensors::V1_0::SharedMemFormat;
+using ::android::hardware::sensors::V1_0::SharedMemType;
+
+namespace {
+
+constexpr size_t offsetOf(SensorsEventFormatOffset offset) {
+    return static_cast<size_t>(offset);
+}
+
+constexpr size_t kRecordSize = offsetOf(SensorsEventFormatOffset::TOTAL_LENGTH);
+constexpr size_t kDataSize =
+        offsetOf(SensorsEventFormatOffset::RESERVED) - offsetOf(SensorsEventFormatOffset::DATA);
+
+template <typename T>
+void writeField(uint8_t* record, SensorsEventFormatOffset offset, T value) {
+    memcpy(record + offsetOf(offset), &value, sizeof(value));
+}
+
+}  // namespace
+
+std::unique_ptr<DirectChannel> DirectChannel::create(const SharedMemInfo& mem) {
+    if (mem.type != SharedMemType::ASHMEM || mem.format != SharedMemFormat::SENSORS_EVENT ||
+        mem.size < kRecordSize || mem.memoryHandle == nullptr ||
+        mem.memoryHandle->numFds < 1) {
+        return nullptr;
+    }
+    // The mapping stays valid once the caller closes the handle.
+    void* base = mmap(nullptr, mem.size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                      mem.memoryHandle->data[0], 0);
+    if (base == MAP_FAILED) {
+        ALOGE("failed to map direct channel memory: %s", strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<DirectChannel>(
+            new DirectChannel(static_cast<uint8_t*>(base), mem.size));
+}
+
+DirectChannel::DirectChannel(uint8_t* base, size_t size)
+    : mBase(base), mSize(size), mNumRecords(size / kRecordSize) {}
+
+DirectChannel::~DirectChannel() {
+    munmap(mBase, mSize);
+}
+
+void DirectChannel::write(int32_t sensorHandle, int32_t sensorType, int64_t timestamp,
+                          const float* data) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mReportedSensors.count(sensorHandle) == 0) {
+        return;
+    }
+
+    uint8_t* record = mBase + mNextRecord * kRecordSize;
+    mNextRecord = (mNextRecord + 1) % mNumRecords;
+    // The counter starts at 1 and skips 0 when it wraps, 0 marks a record never written.
+    if (++mCounter == 0) {
+        mCounter = 1;
+    }
+
+    writeField(record, SensorsEventFormatOffset::SIZE_FIELD, static_cast<int32_t>(kRecordSize));
+    writeField(record, SensorsEventFormatOffset::REPORT_TOKEN, sensorHandle);
+    writeField(record, SensorsEventFormatOffset::SENSOR_TYPE, sensorType);
+    writeField(record, SensorsEventFormatOffset::TIMESTAMP, timestamp);
+    memcpy(record + offsetOf(SensorsEventFormatOffset::DATA), data, kDataSize);
+    memset(record + offsetOf(SensorsEventFormatOffset::RESERVED), 0,
+           kRecordSize - offsetOf(SensorsEventFormatOffset::RESERVED));
+    __atomic_store_n(reinterpret_cast<uint32_t*>(
+                             record + offsetOf(SensorsEventFormatOffset::ATOMIC_COUNTER)),
+                     mCounter, __ATOMIC_RELEASE);
+}
+
+void DirectChannel::setReported(int32_t sensorHandle, bool reported) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (reported) {
+        mReportedSensors.insert(sensorHandle);
+    } else {
+        mReportedSensors.erase(sensorHandle);
+    }
+}
+
+bool DirectChannel::isReported(int32_t sensorHandle) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mReportedSensors.count(sensorHandle) > 0;
+}
+
+std::set<int32_t> DirectChannel::clearReported() {
+    std::set<int32_t> reported;
+    std::lock_guard<std::mutex> lock(mMutex);
+    reported.swap(mReportedSensors);
+    return reported;
+}
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
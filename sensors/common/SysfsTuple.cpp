@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SysfsTuple.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+namespace {
+
+// Touch panel attributes are a few short numbers, anything past this is not a tuple we know.
+constexpr size_t kMaxAttributeSize = 64;
+
+}  // anonymous namespace
+
+size_t parseIntTuple(const char* buf, size_t len, int* values, size_t maxValues) {
+    const char* end = buf + len;
+    size_t count = 0;
+
+    while (count < maxValues) {
+        while (buf < end && (*buf == ' ' || *buf == '\t')) buf++;
+
+        bool negative = buf < end && *buf == '-';
+        buf += negative;
+
+        const char* digits = buf;
+        long long value = 0;
+        while (buf < end && static_cast<unsigned>(*buf - '0') < 10) {
+            // Saturate instead of overflowing, the result is clamped to an int below anyway.
+            value = value < LLONG_MAX / 10 ? value * 10 + (*buf - '0') : LLONG_MAX;
+            buf++;
+        }
+        if (buf == digits) break;
+
+        value = negative ? -value : value;
+        values[count++] = value > INT_MAX ? INT_MAX : value < INT_MIN ? INT_MIN : value;
+
+        if (buf == end || *buf != ',') break;
+        buf++;
+    }
+
+    return count;
+}
+
+int readSysfsIntTuple(int fd, int* values, size_t maxValues) {
+    char buf[kMaxAttributeSize];
+    ssize_t rc;
+
+    do {
+        rc = pread(fd, buf, sizeof(buf), 0);
+    } while (rc < 0 && errno == EINTR);
+
+    if (rc < 0) {
+        return -errno;
+    }
+
+    return static_cast<int>(parseIntTuple(buf, rc, values, maxValues));
+}
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
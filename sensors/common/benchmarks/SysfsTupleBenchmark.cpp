@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <SysfsTuple.h>
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+namespace {
+
+using ::android::base::TemporaryFile;
+using ::android::base::WriteStringToFile;
+
+//! A finger down at x=540, y=1800 as fod_press_status reports it.
+constexpr char kFingerDown[] = "540,1800,1\n";
+constexpr size_t kNumValues = 3;
+
+//! How udfps_hal.cpp parsed the attribute before parseIntTuple.
+int parseWithSscanf(const char* buf, int* values) {
+    return sscanf(buf, "%d,%d,%d", &values[0], &values[1], &values[2]);
+}
+
+//! How the v2 sub-HAL parsed the attribute before parseIntTuple.
+size_t parseWithStrtol(char* buf, int* values, size_t maxValues) {
+    size_t count = 0;
+    for (char* pos = buf; count < maxValues;) {
+        char* end;
+        values[count] = strtol(pos, &end, 10);
+        if (end == pos) break;
+        count++;
+        if (*end != ',') break;
+        pos = end + 1;
+    }
+    return count;
+}
+
+//! The old read of both HALs: seek back, read and parse the NUL terminated buffer.
+int readWithLseek(int fd, int* values) {
+    char buf[512];
+    if (lseek(fd, 0, SEEK_SET) < 0) return -1;
+    ssize_t rc = read(fd, buf, sizeof(buf) - 1);
+    if (rc < 0) return -1;
+    buf[rc] = '\0';
+    return parseWithSscanf(buf, values);
+}
+
+}  // namespace
+
+static void BM_ParseSscanf(benchmark::State& state) {
+    int values[kNumValues];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parseWithSscanf(kFingerDown, values));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ParseSscanf);
+
+static void BM_ParseStrtol(benchmark::State& state) {
+    char buf[sizeof(kFingerDown)];
+    int values[kNumValues];
+    for (auto _ : state) {
+        memcpy(buf, kFingerDown, sizeof(buf));
+        benchmark::DoNotOptimize(parseWithStrtol(buf, values, kNumValues));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ParseStrtol);
+
+static void BM_ParseIntTuple(benchmark::State& state) {
+    int values[kNumValues];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+                parseIntTuple(kFingerDown, sizeof(kFingerDown) - 1, values, kNumValues));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ParseIntTuple);
+
+// The reads below go to a regular file rather than sysfs, so they compare the syscalls and
+// parsing but not the cost of the touch driver's show function.
+static void BM_ReadLseekSscanf(benchmark::State& state) {
+    TemporaryFile attribute;
+    WriteStringToFile(kFingerDown, attribute.path);
+    int values[kNumValues];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(readWithLseek(attribute.fd, values));
+    }
+}
+BENCHMARK(BM_ReadLseekSscanf);
+
+static void BM_ReadSysfsIntTuple(benchmark::State& state) {
+    TemporaryFile attribute;
+    WriteStringToFile(kFingerDown, attribute.path);
+    int values[kNumValues];
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(readSysfsIntTuple(attribute.fd, values, kNumValues));
+    }
+}
+BENCHMARK(BM_ReadSysfsIntTuple);
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
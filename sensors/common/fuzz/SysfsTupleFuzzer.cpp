@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <SysfsTuple.h>
+
+#include <fuzzer/FuzzedDataProvider.h>
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using ::android::sensors::xiaomi::parseIntTuple;
+
+namespace {
+
+//! Longer digit runs may not fit an int, where sscanf behaviour is undefined.
+constexpr size_t kMaxComparableDigits = 9;
+
+/**
+ * The sscanf parsing the HALs did before parseIntTuple, generalised from "%d,%d,%d" to any
+ * number of values.
+ */
+size_t parseIntTupleWithSscanf(const std::string& s, int* values, size_t maxValues) {
+    const char* pos = s.c_str();
+    size_t count = 0;
+    while (count < maxValues) {
+        int consumed;
+        if (sscanf(pos, "%d%n", &values[count], &consumed) != 1) break;
+        count++;
+        pos += consumed;
+        if (*pos != ',') break;
+        pos++;
+    }
+    return count;
+}
+
+/**
+ * Whether both parsers must agree on buf. sscanf additionally skips newlines and the like
+ * before a value, accepts a '+' sign and stops at a NUL byte. parseIntTuple does neither,
+ * sysfs attributes only separate values with commas and maybe blanks.
+ */
+bool isComparable(const std::vector<char>& buf) {
+    size_t digits = 0;
+    for (char c : buf) {
+        if (c >= '0' && c <= '9') {
+            if (++digits > kMaxComparableDigits) return false;
+            continue;
+        }
+        digits = 0;
+        if (c == '\0' || c == '+' || (c != ' ' && c != '\t' && isspace(c))) return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FuzzedDataProvider provider(data, size);
+    size_t maxValues = provider.ConsumeIntegralInRange<size_t>(0, 16);
+    // Exactly sized heap copies, so reading past len or writing past maxValues trips ASan.
+    std::vector<char> buf = provider.ConsumeRemainingBytes<char>();
+    std::unique_ptr<int[]> values(new int[maxValues]);
+
+    size_t count = parseIntTuple(buf.data(), buf.size(), values.get(), maxValues);
+    if (count > maxValues) {
+        abort();
+    }
+
+    if (isComparable(buf)) {
+        std::vector<int> expected(maxValues);
+        size_t expectedCount = parseIntTupleWithSscanf(std::string(buf.begin(), buf.end()),
+                                                       expected.data(), maxValues);
+        if (count != expectedCount || !std::equal(expected.begin(), expected.begin() + count,
+                                                  values.get())) {
+            abort();
+        }
+    }
+    return 0;
+}
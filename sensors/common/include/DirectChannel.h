@@ -0,0 +1,76 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android/hardware/sensors/1.0/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+using ::android::hardware::sensors::V1_0::SharedMemInfo;
+
+/**
+ * A shared memory ring a HAL writes sensors_event_t formatted records into for a direct channel
+ * client. Works with ashmem as well as memfd backed regions since both are plain mappable fds.
+ */
+class DirectChannel {
+  public:
+    /**
+     * Map the shared memory described by mem.
+     *
+     * @return The channel or nullptr if the memory is not usable.
+     */
+    static std::unique_ptr<DirectChannel> create(const SharedMemInfo& mem);
+
+    ~DirectChannel();
+
+    /**
+     * Write one record if the sensor is reported on this channel. The atomic counter is stored
+     * last, so a reader never sees a partially written record as new.
+     *
+     * @param data The 16 floats of the event payload, copied straight into the ring.
+     */
+    void write(int32_t sensorHandle, int32_t sensorType, int64_t timestamp, const float* data);
+
+    //! Write a HIDL event of any version.
+    template <typename EventType>
+    void write(const EventType& event) {
+        write(event.sensorHandle, static_cast<int32_t>(event.sensorType), event.timestamp,
+              event.u.data.data());
+    }
+
+    //! Start or stop reporting a sensor, its handle doubles as the report token.
+    void setReported(int32_t sensorHandle, bool reported);
+
+    bool isReported(int32_t sensorHandle);
+
+    //! Stop reporting every sensor and return the handles that were reported.
+    std::set<int32_t> clearReported();
+
+  private:
+    DirectChannel(uint8_t* base, size_t size);
+
+    uint8_t* const mBase;
+    const size_t mSize;
+    const size_t mNumRecords;
+
+    std::mutex mMutex;
+    std::set<int32_t> mReportedSensors;
+    size_t mNextRecord = 0;
+    uint32_t mCounter = 0;
+};
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
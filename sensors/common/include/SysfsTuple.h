@@ -0,0 +1,34 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+/**
+ * Parse a comma separated list of decimal integers such as "540,1800,1\n". Parsing stops at the
+ * end of the buffer, at the first character that does not continue the list or once maxValues
+ * values were stored. Values that do not fit an int are clamped.
+ *
+ * @return The number of values stored.
+ */
+size_t parseIntTuple(const char* buf, size_t len, int* values, size_t maxValues);
+
+/**
+ * Read a sysfs attribute from its start with a single pread and parse it with parseIntTuple.
+ * Reading the attribute also rearms it for the next POLLPRI notification.
+ *
+ * @return The number of values stored or -errno if the read failed.
+ */
+int readSysfsIntTuple(int fd, int* values, size_t maxValues);
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
@@ -0,0 +1,176 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "DirectChannel.h"
+
+#include <android-base/unique_fd.h>
+#include <android/hardware/sensors/2.1/types.h>
+#include <cutils/native_handle.h>
+#include <gtest/gtest.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace android {
+namespace sensors {
+namespace xiaomi {
+
+using ::android::base::unique_fd;
+using ::android::hardware::sensors::V1_0::SensorsEventFormatOffset;
+using ::android::hardware::sensors::V1_0::SharedMemFormat;
+using ::android::hardware::sensors::V1_0::SharedMemType;
+using ::android::hardware::sensors::V2_1::Event;
+using ::android::hardware::sensors::V2_1::SensorType;
+
+namespace {
+
+constexpr size_t kRecordSize = static_cast<size_t>(SensorsEventFormatOffset::TOTAL_LENGTH);
+constexpr size_t kNumRecords = 3;
+constexpr size_t kMemSize = kRecordSize * kNumRecords;
+constexpr int32_t kSensorHandle = 5;
+
+template <typename T>
+T readField(const uint8_t* base, size_t record, SensorsEventFormatOffset offset) {
+    T value;
+    memcpy(&value, base + record * kRecordSize + static_cast<size_t>(offset), sizeof(value));
+    return value;
+}
+
+Event makeEvent(int64_t timestamp) {
+    Event event{};
+    event.sensorHandle = kSensorHandle;
+    event.sensorType = SensorType::ACCELEROMETER;
+    event.timestamp = timestamp;
+    for (size_t i = 0; i < event.u.data.size(); i++) {
+        event.u.data[i] = i + 0.5f;
+    }
+    return event;
+}
+
+class DirectChannelTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mFd.reset(memfd_create("direct_channel_test", 0));
+        ASSERT_GE(mFd.get(), 0);
+        ASSERT_EQ(0, ftruncate(mFd.get(), kMemSize));
+        mHandle = native_handle_create(1, 0);
+        mHandle->data[0] = mFd.get();
+
+        mMem.type = SharedMemType::ASHMEM;
+        mMem.format = SharedMemFormat::SENSORS_EVENT;
+        mMem.size = kMemSize;
+        mMem.memoryHandle = mHandle;
+
+        void* base = mmap(nullptr, kMemSize, PROT_READ, MAP_SHARED, mFd.get(), 0);
+        ASSERT_NE(MAP_FAILED, base);
+        mBase = static_cast<const uint8_t*>(base);
+    }
+
+    void TearDown() override {
+        if (mBase != nullptr) {
+            munmap(const_cast<uint8_t*>(mBase), kMemSize);
+        }
+        native_handle_delete(mHandle);
+    }
+
+    uint32_t counterAt(size_t record) {
+        return readField<uint32_t>(mBase, record, SensorsEventFormatOffset::ATOMIC_COUNTER);
+    }
+
+    unique_fd mFd;
+    native_handle_t* mHandle = nullptr;
+    SharedMemInfo mMem{};
+    const uint8_t* mBase = nullptr;
+};
+
+}  // namespace
+
+TEST_F(DirectChannelTest, RejectsUnusableMemory) {
+    SharedMemInfo mem = mMem;
+    mem.type = SharedMemType::GRALLOC;
+    EXPECT_EQ(nullptr, DirectChannel::create(mem));
+
+    mem = mMem;
+    mem.size = kRecordSize - 1;
+    EXPECT_EQ(nullptr, DirectChannel::create(mem));
+
+    EXPECT_NE(nullptr, DirectChannel::create(mMem));
+}
+
+TEST_F(DirectChannelTest, SkipsSensorsNotReported) {
+    auto channel = DirectChannel::create(mMem);
+    ASSERT_NE(nullptr, channel);
+
+    channel->write(makeEvent(1));
+    EXPECT_EQ(0u, counterAt(0));
+
+    channel->setReported(kSensorHandle, true);
+    channel->setReported(kSensorHandle, false);
+    channel->write(makeEvent(2));
+    EXPECT_EQ(0u, counterAt(0));
+}
+
+TEST_F(DirectChannelTest, WritesSensorsEventRecord) {
+    auto channel = DirectChannel::create(mMem);
+    ASSERT_NE(nullptr, channel);
+    channel->setReported(kSensorHandle, true);
+
+    Event event = makeEvent(42);
+    channel->write(event);
+
+    EXPECT_EQ(static_cast<int32_t>(kRecordSize),
+              readField<int32_t>(mBase, 0, SensorsEventFormatOffset::SIZE_FIELD));
+    EXPECT_EQ(kSensorHandle, readField<int32_t>(mBase, 0, SensorsEventFormatOffset::REPORT_TOKEN));
+    EXPECT_EQ(static_cast<int32_t>(SensorType::ACCELEROMETER),
+              readField<int32_t>(mBase, 0, SensorsEventFormatOffset::SENSOR_TYPE));
+    EXPECT_EQ(42, readField<int64_t>(mBase, 0, SensorsEventFormatOffset::TIMESTAMP));
+    EXPECT_EQ(1u, counterAt(0));
+
+    float data[16];
+    memcpy(data, mBase + static_cast<size_t>(SensorsEventFormatOffset::DATA), sizeof(data));
+    for (size_t i = 0; i < 16; i++) {
+        EXPECT_EQ(event.u.data[i], data[i]) << "data[" << i << "]";
+    }
+    for (size_t i = static_cast<size_t>(SensorsEventFormatOffset::RESERVED); i < kRecordSize;
+         i++) {
+        EXPECT_EQ(0, mBase[i]) << "reserved byte " << i;
+    }
+    EXPECT_EQ(0u, counterAt(1));
+}
+
+TEST_F(DirectChannelTest, CounterKeepsIncreasingAcrossRingWrap) {
+    auto channel = DirectChannel::create(mMem);
+    ASSERT_NE(nullptr, channel);
+    channel->setReported(kSensorHandle, true);
+
+    for (size_t i = 0; i < kNumRecords + 1; i++) {
+        channel->write(makeEvent(100 + static_cast<int64_t>(i)));
+    }
+
+    // The fourth record overwrote the first slot.
+    EXPECT_EQ(4u, counterAt(0));
+    EXPECT_EQ(103, readField<int64_t>(mBase, 0, SensorsEventFormatOffset::TIMESTAMP));
+    EXPECT_EQ(2u, counterAt(1));
+    EXPECT_EQ(101, readField<int64_t>(mBase, 1, SensorsEventFormatOffset::TIMESTAMP));
+    EXPECT_EQ(3u, counterAt(2));
+    EXPECT_EQ(102, readField<int64_t>(mBase, 2, SensorsEventFormatOffset::TIMESTAMP));
+}
+
+TEST_F(DirectChannelTest, ClearReportedReturnsReportedSensors) {
+    auto channel = DirectChannel::create(mMem);
+    ASSERT_NE(nullptr, channel);
+    channel->setReported(kSensorHandle, true);
+    channel->setReported(kSensorHandle + 1, true);
+
+    EXPECT_EQ((std::set<int32_t>{kSensorHandle, kSensorHandle + 1}), channel->clearReported());
+    EXPECT_FALSE(channel->isReported(kSensorHandle));
+    EXPECT_TRUE(channel->clearReported().empty());
+}
+
+}  // namespace xiaomi
+}  // namespace sensors
+}  // namespace android
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// The module keeps its state in statics, include it to point the probe at fake sysfs nodes.
+#include "../udfps_hal.cpp"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace {
+
+using ::android::base::TemporaryDir;
+using ::android::base::WriteStringToFile;
+
+class UdfpsHalTest : public ::testing::Test {
+  protected:
+    static void SetUpTestSuite() {
+        sFakeSysfs = new TemporaryDir();
+        for (size_t i = 0; i < UDFPS_MAX_SENSORS; i++) {
+            sNodePaths[i] = std::string(sFakeSysfs->path) + "/fp_state" + std::to_string(i);
+            udfps_state_paths[i] = sNodePaths[i].c_str();
+        }
+        createNodes();
+
+        // Probe once, as the framework does when it lists the sensors before opening.
+        const struct sensor_t* list;
+        ASSERT_EQ(static_cast<int>(UDFPS_MAX_SENSORS),
+                  HAL_MODULE_INFO_SYM.get_sensors_list(&HAL_MODULE_INFO_SYM, &list));
+    }
+
+    static void TearDownTestSuite() { delete sFakeSysfs; }
+
+    void TearDown() override {
+        if (mDevice) {
+            mDevice->common.close(&mDevice->common);
+        }
+        createNodes();
+    }
+
+    //! Recreate every node a test removed, with a released finger.
+    static void createNodes() {
+        for (const std::string& path : sNodePaths) {
+            ASSERT_TRUE(WriteStringToFile("0,0,0\n", path));
+        }
+    }
+
+    int open() {
+        struct hw_device_t* device = nullptr;
+        int rc = HAL_MODULE_INFO_SYM.common.methods->open(&HAL_MODULE_INFO_SYM.common,
+                                                          SENSORS_HARDWARE_POLL, &device);
+        mDevice = reinterpret_cast<sensors_poll_device_1_t*>(device);
+        return rc;
+    }
+
+    int activate(int handle) { return mDevice->activate(&mDevice->v0, handle, 1); }
+
+    static TemporaryDir* sFakeSysfs;
+    static std::string sNodePaths[UDFPS_MAX_SENSORS];
+
+    sensors_poll_device_1_t* mDevice = nullptr;
+};
+
+TemporaryDir* UdfpsHalTest::sFakeSysfs;
+std::string UdfpsHalTest::sNodePaths[UDFPS_MAX_SENSORS];
+
+}  // namespace
+
+TEST_F(UdfpsHalTest, OpensEveryNode) {
+    ASSERT_EQ(0, open());
+    for (int handle = 0; handle < static_cast<int>(UDFPS_MAX_SENSORS); handle++) {
+        EXPECT_EQ(0, activate(handle));
+    }
+}
+
+TEST_F(UdfpsHalTest, SkipsNodesThatFailToOpen) {
+    // The node went away between probing and opening.
+    ASSERT_EQ(0, unlink(sNodePaths[0].c_str()));
+
+    ASSERT_EQ(0, open());
+    ASSERT_NE(nullptr, mDevice);
+    // The handles stay as listed, only the missing node's sensor is unusable.
+    EXPECT_EQ(-ENODEV, activate(0));
+    EXPECT_EQ(0, activate(1));
+}
+
+TEST_F(UdfpsHalTest, FailsWhenNoNodeOpens) {
+    for (const std::string& path : sNodePaths) {
+        ASSERT_EQ(0, unlink(path.c_str()));
+    }
+
+    EXPECT_EQ(-ENODEV, open());
+    EXPECT_EQ(nullptr, mDevice);
+}
@@ -11,18 +11,32 @@
 #include <hardware/sensors.h>
 #include <log/log.h>
 #include <poll.h>
+#include <pthread.h>
 #include <stdint.h>
-#include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <utils/SystemClock.h>
 
+#include <SysfsTuple.h>
+
+using ::android::sensors::xiaomi::readSysfsIntTuple;
+
 static const char *udfps_state_paths[] = {
         "/sys/devices/virtual/touch/tp_dev/fp_state",
         "/sys/touchpanel/fp_state",
         NULL,
 };
 
-static struct sensor_t udfps_sensor = {
+#define UDFPS_MAX_SENSORS (sizeof(udfps_state_paths) / sizeof(udfps_state_paths[0]) - 1)
+
+// Upper bound for a single poll() call so the HIDL poll thread never blocks forever.
+static const int udfps_poll_timeout_ms = 1000;
+
+// Non-blocking passes after the first wakeup, bounds the loop if an fd keeps failing to read.
+static const int udfps_max_drain_passes = 4;
+
+static const struct sensor_t udfps_sensor_template = {
         .name = "UDFPS Sensor",
         .vendor = "The LineageOS Project",
         .version = 1,
@@ -41,43 +55,78 @@ static struct sensor_t udfps_sensor = {
         .reserved = {},
 };
 
+// One sensor per distinct fp_state node on this device, the handle is the index.
+static struct sensor_t udfps_sensors[UDFPS_MAX_SENSORS];
+static const char* udfps_sensor_paths[UDFPS_MAX_SENSORS];
+static int udfps_sensor_count;
+static pthread_once_t udfps_probe_once = PTHREAD_ONCE_INIT;
+
+static void udfps_probe_sensors() {
+    struct stat probed[UDFPS_MAX_SENSORS];
+
+    for (size_t i = 0; udfps_state_paths[i]; i++) {
+        struct stat st;
+        if (access(udfps_state_paths[i], R_OK) || stat(udfps_state_paths[i], &st)) {
+            continue;
+        }
+
+        // Several paths may lead to the same node, which would report every press twice.
+        bool duplicate = false;
+        for (int j = 0; j < udfps_sensor_count; j++) {
+            if (probed[j].st_dev == st.st_dev && probed[j].st_ino == st.st_ino) {
+                duplicate = true;
+                break;
+            }
+        }
+        if (duplicate) {
+            continue;
+        }
+        probed[udfps_sensor_count] = st;
+
+        udfps_sensors[udfps_sensor_count] = udfps_sensor_template;
+        udfps_sensors[udfps_sensor_count].handle = udfps_sensor_count;
+        udfps_sensor_paths[udfps_sensor_count] = udfps_state_paths[i];
+        udfps_sensor_count++;
+    }
+}
+
 struct udfps_context_t {
     sensors_poll_device_1_t device;
-    int fd;
+    struct pollfd fds[UDFPS_MAX_SENSORS];
+    int count;
 };
 
-static int udfps_read_line(int fd, char* buf, size_t len) {
+static int udfps_read_state(int fd, int& pos_x, int& pos_y) {
+    int values[3];
     int rc;
 
-    rc = lseek(fd, 0, SEEK_SET);
+    rc = readSysfsIntTuple(fd, values, 3);
     if (rc < 0) {
-        ALOGE("Failed to seek: %d", -errno);
-        return rc;
+        ALOGE("Failed to read fp_state: %d", rc);
+        return 0;
+    } else if (rc != 3) {
+        ALOGE("Failed to parse fp_state: %d", rc);
+        return 0;
     }
 
-    rc = read(fd, buf, len);
-    if (rc < 0) {
-        ALOGE("Failed to read: %d", -errno);
-        return rc;
-    }
+    pos_x = values[0];
+    pos_y = values[1];
 
-    return rc;
+    return values[2];
 }
 
-static int udfps_read_state(int fd, int& pos_x, int& pos_y) {
-    int rc, state = 0;
-    char buf[64];
-
-    rc = udfps_read_line(fd, buf, sizeof(buf));
-    if (rc > 0) {
-        rc = sscanf(buf, "%d,%d,%d", &pos_x, &pos_y, &state);
-        if (rc != 3) {
-            ALOGE("Failed to parse fp_state: %d", rc);
-            state = 0;
-        }
+static int udfps_wait_events(udfps_context_t* ctx, int timeout) {
+    int rc;
+
+    for (int i = 0; i < ctx->count; i++) {
+        ctx->fds[i].revents = 0;
     }
 
-    return state;
+    do {
+        rc = poll(ctx->fds, ctx->count, timeout);
+    } while (rc < 0 && errno == EINTR);
+
+    return rc;
 }
 
 static int udfps_wait_event(int fd, int timeout) {
@@ -96,10 +145,10 @@ static int udfps_wait_event(int fd, int timeout) {
 }
 
 static void udfps_flush_events(int fd) {
-    char buf[64];
+    int values[3];
 
     while (udfps_wait_event(fd, 0) > 0) {
-        udfps_read_line(fd, buf, sizeof(buf));
+        readSysfsIntTuple(fd, values, 3);
     }
 }
 
@@ -107,7 +156,9 @@ static int udfps_close(struct hw_device_t* dev) {
     udfps_context_t* ctx = reinterpret_cast<udfps_context_t*>(dev);
 
     if (ctx) {
-        close(ctx->fd);
+        for (int i = 0; i < ctx->count; i++) {
+            if (ctx->fds[i].fd >= 0) close(ctx->fds[i].fd);
+        }
         delete ctx;
     }
 
@@ -117,12 +168,16 @@ static int udfps_close(struct hw_device_t* dev) {
 static int udfps_activate(struct sensors_poll_device_t* dev, int handle, int enabled) {
     udfps_context_t* ctx = reinterpret_cast<udfps_context_t*>(dev);
 
-    if (!ctx || handle) {
+    if (!ctx || handle < 0 || handle >= ctx->count) {
         return -EINVAL;
     }
 
+    if (ctx->fds[handle].fd < 0) {
+        return -ENODEV;
+    }
+
     // Flush any pending events
-    if (enabled) udfps_flush_events(ctx->fd);
+    if (enabled) udfps_flush_events(ctx->fds[handle].fd);
 
     return 0;
 }
@@ -130,41 +185,60 @@ static int udfps_activate(struct sensors_poll_device_t* dev, int handle, int ena
 static int udfps_setDelay(struct sensors_poll_device_t* dev, int handle, int64_t /* ns */) {
     udfps_context_t* ctx = reinterpret_cast<udfps_context_t*>(dev);
 
-    if (!ctx || handle) {
+    if (!ctx || handle < 0 || handle >= ctx->count) {
         return -EINVAL;
     }
 
     return 0;
 }
 
-static int udfps_poll(struct sensors_poll_device_t* dev, sensors_event_t* data, int /* count */) {
+static int udfps_poll(struct sensors_poll_device_t* dev, sensors_event_t* data, int count) {
     udfps_context_t* ctx = reinterpret_cast<udfps_context_t*>(dev);
 
-    if (!ctx) {
+    if (!ctx || count <= 0) {
         return -EINVAL;
     }
 
-    int fod_x, fod_y, fod_state = 0;
+    int events = 0;
+    int passes = 0;
+    int timeout = udfps_poll_timeout_ms;
+    int rc;
 
+    // Wait for the first change, then drain whatever else is already pending without blocking.
     do {
-        int rc = udfps_wait_event(ctx->fd, -1);
+        rc = udfps_wait_events(ctx, timeout);
         if (rc < 0) {
             ALOGE("Failed to poll fp_state: %d", -errno);
-            return -errno;
-        } else if (rc > 0) {
-            fod_state = udfps_read_state(ctx->fd, fod_x, fod_y);
+            return events ? events : -errno;
+        }
+
+        int64_t timestamp = ::android::elapsedRealtimeNano();
+
+        // A change left unread once the buffer is full stays pending for the next call.
+        for (int i = 0; i < ctx->count && events < count; i++) {
+            if (!(ctx->fds[i].revents & (POLLERR | POLLPRI))) {
+                continue;
+            }
+
+            int fod_x, fod_y;
+            if (!udfps_read_state(ctx->fds[i].fd, fod_x, fod_y)) {
+                continue;
+            }
+
+            sensors_event_t* event = &data[events++];
+            memset(event, 0, sizeof(sensors_event_t));
+            event->version = sizeof(sensors_event_t);
+            event->sensor = udfps_sensors[i].handle;
+            event->type = udfps_sensors[i].type;
+            event->timestamp = timestamp;
+            event->data[0] = fod_x;
+            event->data[1] = fod_y;
         }
-    } while (!fod_state);
 
-    memset(data, 0, sizeof(sensors_event_t));
-    data->version = sizeof(sensors_event_t);
-    data->sensor = udfps_sensor.handle;
-    data->type = udfps_sensor.type;
-    data->timestamp = ::android::elapsedRealtimeNano();
-    data->data[0] = fod_x;
-    data->data[1] = fod_y;
+        timeout = 0;
+    } while (rc > 0 && events < count && passes++ < udfps_max_drain_passes);
 
-    return 1;
+    return events;
 }
 
 static int udfps_batch(struct sensors_poll_device_1* /* dev */, int /* handle */, int /* flags */,
@@ -191,16 +265,24 @@ static int open_sensors(const struct hw_module_t* module, const char* /* name */
     ctx->device.batch = udfps_batch;
     ctx->device.flush = udfps_flush;
 
-    for (int i = 0; udfps_state_paths[i]; i++) {
-        ctx->fd = open(udfps_state_paths[i], O_RDONLY);
-        if (ctx->fd >= 0) {
-            break;
+    pthread_once(&udfps_probe_once, udfps_probe_sensors);
+
+    int opened = 0;
+    for (int i = 0; i < udfps_sensor_count; i++) {
+        // Handles index fds, so a node that fails to open keeps its slot. poll() skips its -1.
+        ctx->fds[i].fd = open(udfps_sensor_paths[i], O_RDONLY);
+        ctx->fds[i].events = POLLERR | POLLPRI;
+        ctx->count++;
+        if (ctx->fds[i].fd < 0) {
+            ALOGE("Failed to open %s: %d", udfps_sensor_paths[i], -errno);
+            continue;
         }
+        opened++;
     }
 
-    if (ctx->fd < 0) {
-        ALOGE("Failed to open fp state: %d", -errno);
-        delete ctx;
+    if (!opened) {
+        ALOGE("Failed to find fp state");
+        udfps_close(&ctx->device.common);
 
         return -ENODEV;
     }
@@ -215,9 +297,10 @@ static struct hw_module_methods_t udfps_module_methods = {
 };
 
 static int udfps_get_sensors_list(struct sensors_module_t*, struct sensor_t const** list) {
-    *list = &udfps_sensor;
+    pthread_once(&udfps_probe_once, udfps_probe_sensors);
+    *list = udfps_sensors;
 
-    return 1;
+    return udfps_sensor_count;
 }
 
 static int udfps_set_operation_mode(unsigned int mode) {
@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "LatencyStats.h"
+
+#include <algorithm>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+void LatencyStats::record(int64_t latencyNs) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mSamples[mNextSample] = latencyNs;
+    mNextSample = (mNextSample + 1) % kNumSamples;
+    mNumSamples = std::min(mNumSamples + 1, kNumSamples);
+}
+
+void LatencyStats::dump(std::ostream& stream) const {
+    std::array<int64_t, kNumSamples> samples;
+    size_t numSamples;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        numSamples = mNumSamples;
+        std::copy_n(mSamples.begin(), numSamples, samples.begin());
+    }
+    if (numSamples == 0) return;
+
+    std::sort(samples.begin(), samples.begin() + numSamples);
+    int64_t sum = 0;
+    for (size_t i = 0; i < numSamples; i++) {
+        sum += samples[i];
+    }
+    size_t p99 = std::min(numSamples - 1, (numSamples * 99 + 99) / 100 - 1);
+
+    stream << "Wake to post latency: min " << samples[0] / 1000 << " us, avg "
+           << sum / static_cast<int64_t>(numSamples) / 1000 << " us, p99 " << samples[p99] / 1000
+           << " us (" << numSamples << " samples)" << std::endl;
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+/**
+ * Keeps the most recent latency samples of a sensor so debug can report min/avg/p99 over them.
+ */
+class LatencyStats {
+  public:
+    static constexpr size_t kNumSamples = 128;
+
+    void record(int64_t latencyNs);
+
+    //! Write a one line summary, or nothing if no sample was recorded yet.
+    void dump(std::ostream& stream) const;
+
+  private:
+    mutable std::mutex mMutex;
+    std::array<int64_t, kNumSamples> mSamples;
+    size_t mNextSample = 0;
+    size_t mNumSamples = 0;
+};
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
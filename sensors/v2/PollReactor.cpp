@@ -0,0 +1,266 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PollReactor.h"
+
+#include <log/log.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <utils/SystemClock.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+namespace {
+
+constexpr int kMaxEventsPerWait = 8;
+constexpr int64_t kNanosecondsInSeconds = 1000 * 1000 * 1000;
+
+}  // namespace
+
+PollReactor::PollReactor() {
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (mEpollFd < 0) {
+        ALOGE("failed to create epoll fd: %s", strerror(errno));
+    }
+
+    mEventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (mEventFd < 0) {
+        ALOGE("failed to create event fd: %s", strerror(errno));
+    } else if (mEpollFd >= 0) {
+        struct epoll_event event = {.events = EPOLLIN, .data = {.fd = mEventFd}};
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mEventFd, &event) < 0) {
+            ALOGE("failed to watch event fd: %s", strerror(errno));
+        }
+    }
+
+    mTimerFd = timerfd_create(CLOCK_BOOTTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (mTimerFd < 0) {
+        ALOGE("failed to create timer fd: %s", strerror(errno));
+    } else if (mEpollFd >= 0) {
+        struct epoll_event event = {.events = EPOLLIN, .data = {.fd = mTimerFd}};
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mTimerFd, &event) < 0) {
+            ALOGE("failed to watch timer fd: %s", strerror(errno));
+        }
+    }
+}
+
+PollReactor::~PollReactor() {
+    if (mThread.joinable()) {
+        mStopThread = true;
+        uint64_t value = 1;
+        write(mEventFd, &value, sizeof(value));
+        mThread.join();
+    }
+    if (mTimerFd >= 0) close(mTimerFd);
+    if (mEventFd >= 0) close(mEventFd);
+    if (mEpollFd >= 0) close(mEpollFd);
+}
+
+void PollReactor::add(int fd, Callback callback) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCallbacks[fd] = std::make_shared<Callback>(std::move(callback));
+    mArmed[fd] = false;
+}
+
+bool PollReactor::arm(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto armed = mArmed.find(fd);
+    if (mEpollFd < 0 || armed == mArmed.end()) {
+        return false;
+    }
+
+    struct epoll_event event = {.events = events, .data = {.fd = fd}};
+    if (epoll_ctl(mEpollFd, armed->second ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &event) < 0) {
+        ALOGE("failed to watch fd %d: %s", fd, strerror(errno));
+        return false;
+    }
+    armed->second = true;
+
+    startThreadLocked();
+    return true;
+}
+
+void PollReactor::startThreadLocked() {
+    if (!mThread.joinable()) {
+        mThread = std::thread(&PollReactor::run, this);
+    }
+}
+
+void PollReactor::disarm(int fd) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto armed = mArmed.find(fd);
+    if (armed == mArmed.end() || !armed->second) return;
+
+    if (epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr) < 0) {
+        ALOGE("failed to stop watching fd %d: %s", fd, strerror(errno));
+    }
+    armed->second = false;
+}
+
+void PollReactor::remove(int fd) {
+    disarm(fd);
+
+    std::unique_lock<std::mutex> lock(mMutex);
+    mCallbacks.erase(fd);
+    mArmed.erase(fd);
+    mCallbackDone.wait(lock, [&] { return mRunningFd != fd; });
+}
+
+int PollReactor::addTimer(TimerCallback callback) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    int id = mNextTimerId++;
+    mTimers[id].callback = std::make_shared<TimerCallback>(std::move(callback));
+    return id;
+}
+
+void PollReactor::scheduleTimer(int id, int64_t deadlineNs) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto timer = mTimers.find(id);
+    if (timer == mTimers.end() || mTimerFd < 0) return;
+
+    timer->second.deadlineNs = deadlineNs;
+    if (deadlineNs < mTimerFdDeadlineNs) {
+        armTimerFdLocked();
+    }
+    startThreadLocked();
+}
+
+void PollReactor::cancelTimer(int id) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto timer = mTimers.find(id);
+    if (timer == mTimers.end()) return;
+
+    // The timerfd may still fire for it, which then finds nothing due and rearms.
+    timer->second.deadlineNs = INT64_MAX;
+}
+
+void PollReactor::removeTimer(int id) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTimers.erase(id);
+    mCallbackDone.wait(lock, [&] { return mRunningTimer != id; });
+}
+
+std::map<int, PollReactor::Timer>::iterator PollReactor::earliestTimerLocked() {
+    return std::min_element(mTimers.begin(), mTimers.end(), [](const auto& a, const auto& b) {
+        return a.second.deadlineNs < b.second.deadlineNs;
+    });
+}
+
+void PollReactor::armTimerFdLocked() {
+    auto timer = earliestTimerLocked();
+
+    struct itimerspec spec = {};
+    mTimerFdDeadlineNs = INT64_MAX;
+    if (timer != mTimers.end() && timer->second.deadlineNs != INT64_MAX) {
+        // A zero it_value disarms the timer, so never ask for the epoch itself.
+        int64_t deadlineNs = std::max<int64_t>(timer->second.deadlineNs, 1);
+        spec.it_value.tv_sec = deadlineNs / kNanosecondsInSeconds;
+        spec.it_value.tv_nsec = deadlineNs % kNanosecondsInSeconds;
+        mTimerFdDeadlineNs = deadlineNs;
+    }
+    if (timerfd_settime(mTimerFd, TFD_TIMER_ABSTIME, &spec, nullptr) < 0) {
+        ALOGE("failed to arm timer fd: %s", strerror(errno));
+    }
+}
+
+void PollReactor::runTimers(int64_t timestampNs) {
+    // Run each timer at most about once per wakeup, one that reschedules itself into the past
+    // then fires again on the next epoll_wait instead of starving the fds.
+    size_t budget;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        budget = mTimers.size();
+    }
+
+    for (; budget > 0 && !mStopThread; budget--) {
+        std::shared_ptr<TimerCallback> callback;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto timer = earliestTimerLocked();
+            if (timer == mTimers.end() || timer->second.deadlineNs > timestampNs) break;
+
+            mRunningTimer = timer->first;
+            timer->second.deadlineNs = INT64_MAX;
+            callback = timer->second.callback;
+        }
+
+        (*callback)(timestampNs);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRunningTimer = -1;
+        }
+        mCallbackDone.notify_all();
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    armTimerFdLocked();
+}
+
+void PollReactor::run() {
+    struct epoll_event events[kMaxEventsPerWait];
+
+    while (!mStopThread) {
+        int count = epoll_wait(mEpollFd, events, kMaxEventsPerWait, -1);
+        int64_t timestamp = ::android::elapsedRealtimeNano();
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ALOGE("failed to wait for events: %s", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < count && !mStopThread; i++) {
+            int fd = events[i].data.fd;
+            if (fd == mEventFd) {
+                uint64_t value;
+                read(mEventFd, &value, sizeof(value));
+                continue;
+            }
+            if (fd == mTimerFd) {
+                uint64_t expirations;
+                read(mTimerFd, &expirations, sizeof(expirations));
+                runTimers(timestamp);
+                continue;
+            }
+
+            std::shared_ptr<Callback> callback;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                // The fd may have been disarmed since epoll_wait returned.
+                auto armed = mArmed.find(fd);
+                if (armed == mArmed.end() || !armed->second) continue;
+                callback = mCallbacks[fd];
+                mRunningFd = fd;
+            }
+
+            (*callback)(events[i].events, timestamp);
+
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mRunningFd = -1;
+            }
+            mCallbackDone.notify_all();
+        }
+    }
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
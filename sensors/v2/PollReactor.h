@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+/**
+ * One epoll thread shared by every sensor of the sub-HAL that waits on a file descriptor or a
+ * sampling deadline. Sampling deadlines share a single CLOCK_BOOTTIME timerfd. A sensor has at
+ * most one timer, so the earliest deadline is found by scanning the few there are. The thread
+ * is only started once the first descriptor or timer is armed, so a sub-HAL whose sensors are
+ * never enabled costs no thread at all.
+ */
+class PollReactor {
+  public:
+    /**
+     * Called with the ready epoll events and the CLOCK_BOOTTIME time at which epoll_wait
+     * returned, before any locking or parsing delays the callback.
+     */
+    using Callback = std::function<void(uint32_t events, int64_t timestampNs)>;
+
+    PollReactor();
+    ~PollReactor();
+
+    /**
+     * Register the callback to run on the reactor thread whenever fd becomes ready. The fd is
+     * not watched until it is armed.
+     */
+    void add(int fd, Callback callback);
+
+    //! Start watching fd for the given epoll events.
+    bool arm(int fd, uint32_t events);
+
+    /**
+     * Stop watching fd. A callback that is already running may still complete, so the owner
+     * must check its own state in the callback.
+     */
+    void disarm(int fd);
+
+    /**
+     * Forget fd and wait for any running callback for it to return. Must not be called from the
+     * callback itself.
+     */
+    void remove(int fd);
+
+    //! Called with the CLOCK_BOOTTIME time at which the timer was found to be due.
+    using TimerCallback = std::function<void(int64_t timestampNs)>;
+
+    //! Register a timer callback and return its id. The timer is not scheduled yet.
+    int addTimer(TimerCallback callback);
+
+    //! Run the timer once at the given CLOCK_BOOTTIME deadline, replacing any earlier schedule.
+    void scheduleTimer(int id, int64_t deadlineNs);
+
+    //! Unschedule the timer. Like disarm(), a running callback may still complete.
+    void cancelTimer(int id);
+
+    //! Forget the timer and wait for its running callback to return.
+    void removeTimer(int id);
+
+  private:
+    struct Timer {
+        std::shared_ptr<TimerCallback> callback;
+        //! INT64_MAX while not scheduled.
+        int64_t deadlineNs = INT64_MAX;
+    };
+
+    void run();
+
+    //! Must hold mMutex.
+    void startThreadLocked();
+
+    //! @return The timer with the earliest deadline. Must hold mMutex.
+    std::map<int, Timer>::iterator earliestTimerLocked();
+
+    //! Point the timerfd at the earliest deadline. Must hold mMutex.
+    void armTimerFdLocked();
+
+    //! Run every due timer.
+    void runTimers(int64_t timestampNs);
+
+    int mEpollFd;
+
+    //! Wakes the reactor thread up to exit.
+    int mEventFd;
+
+    std::mutex mMutex;
+    std::condition_variable mCallbackDone;
+    std::map<int, std::shared_ptr<Callback>> mCallbacks;
+    std::map<int, bool> mArmed;
+    int mRunningFd = -1;
+
+    int mTimerFd;
+    std::map<int, Timer> mTimers;
+    int64_t mTimerFdDeadlineNs = INT64_MAX;
+    int mNextTimerId = 0;
+    int mRunningTimer = -1;
+
+    std::atomic_bool mStopThread = false;
+    std::thread mThread;
+};
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -18,8 +18,11 @@
 
 #include <hardware/sensors.h>
 #include <log/log.h>
+#include <sys/epoll.h>
 #include <utils/SystemClock.h>
 
+#include <SysfsTuple.h>
+
 #include <cmath>
 
 namespace {
@@ -62,13 +65,16 @@ using ::android::hardware::sensors::V1_0::SensorStatus;
 using ::android::hardware::sensors::V2_1::Event;
 using ::android::hardware::sensors::V2_1::SensorInfo;
 using ::android::hardware::sensors::V2_1::SensorType;
+using ::android::sensors::xiaomi::readSysfsIntTuple;
 
-Sensor::Sensor(int32_t sensorHandle, ISensorsEventCallback* callback)
+Sensor::Sensor(int32_t sensorHandle, ISensorsEventCallback* callback, PollReactor* reactor)
     : mIsEnabled(false),
       mSamplingPeriodNs(0),
       mLastSampleTimeNs(0),
       mCallback(callback),
-      mMode(OperationMode::NORMAL) {
+      mReactor(reactor),
+      mMode(OperationMode::NORMAL),
+      mSampleTimerId(-1) {
     mSensorInfo.sensorHandle = sensorHandle;
     mSensorInfo.vendor = "The LineageOS Project";
     mSensorInfo.version = 1;
@@ -78,19 +84,20 @@ Sensor::Sensor(int32_t sensorHandle, ISensorsEventCallback* callback)
     mSensorInfo.fifoMaxEventCount = 0;
     mSensorInfo.requiredPermission = "";
     mSensorInfo.flags = 0;
-    mRunThread = std::thread(startThread, this);
 }
 
 Sensor::~Sensor() {
-    // Ensure that lock is unlocked before calling mRunThread.join() or a
-    // deadlock will occur.
-    {
-        std::unique_lock<std::mutex> lock(mRunMutex);
-        mStopThread = true;
-        mIsEnabled = false;
-        mWaitCV.notify_all();
+    // By now the derived part is gone, a sample still running would call into it.
+    LOG_ALWAYS_FATAL_IF(mSampleTimerId >= 0, "%s destroyed without stopSampling()",
+                        mSensorInfo.name.c_str());
+}
+
+void Sensor::stopSampling() {
+    // The timer callback takes mRunMutex, so it must not be held while waiting for it.
+    if (mSampleTimerId >= 0) {
+        mReactor->removeTimer(mSampleTimerId);
+        mSampleTimerId = -1;
     }
-    mRunThread.join();
 }
 
 const SensorInfo& Sensor::getSensorInfo() const {
@@ -101,10 +108,11 @@ void Sensor::batch(int32_t samplingPeriodNs) {
     samplingPeriodNs =
             std::clamp(samplingPeriodNs, mSensorInfo.minDelay * 1000, mSensorInfo.maxDelay * 1000);
 
+    std::lock_guard<std::mutex> lock(mRunMutex);
     if (mSamplingPeriodNs != samplingPeriodNs) {
         mSamplingPeriodNs = samplingPeriodNs;
-        // Wake up the 'run' thread to check if a new event should be generated now
-        mWaitCV.notify_all();
+        // Check if a new event should be generated now
+        updateSamplingLocked();
     }
 }
 
@@ -112,7 +120,7 @@ void Sensor::activate(bool enable) {
     std::lock_guard<std::mutex> lock(mRunMutex);
     if (mIsEnabled != enable) {
         mIsEnabled = enable;
-        mWaitCV.notify_all();
+        updateSamplingLocked();
     }
 }
 
@@ -129,49 +137,49 @@ Result Sensor::flush() {
     ev.sensorHandle = mSensorInfo.sensorHandle;
     ev.sensorType = SensorType::META_DATA;
     ev.u.meta.what = MetaDataEventType::META_DATA_FLUSH_COMPLETE;
-    std::vector<Event> evs{ev};
-    mCallback->postEvents(evs, isWakeUpSensor());
+    mCallback->postEvents(&ev, 1, isWakeUpSensor());
 
     return Result::OK;
 }
 
-void Sensor::startThread(Sensor* sensor) {
-    sensor->run();
-}
-
-void Sensor::run() {
-    std::unique_lock<std::mutex> runLock(mRunMutex);
-    constexpr int64_t kNanosecondsInSeconds = 1000 * 1000 * 1000;
-
-    while (!mStopThread) {
-        if (!mIsEnabled || mMode == OperationMode::DATA_INJECTION) {
-            mWaitCV.wait(runLock, [&] {
-                return ((mIsEnabled && mMode == OperationMode::NORMAL) || mStopThread);
-            });
-        } else {
-            timespec curTime;
-            clock_gettime(CLOCK_REALTIME, &curTime);
-            int64_t now = (curTime.tv_sec * kNanosecondsInSeconds) + curTime.tv_nsec;
-            int64_t nextSampleTime = mLastSampleTimeNs + mSamplingPeriodNs;
-
-            if (now >= nextSampleTime) {
-                mLastSampleTimeNs = now;
-                nextSampleTime = mLastSampleTimeNs + mSamplingPeriodNs;
-                mCallback->postEvents(readEvents(), isWakeUpSensor());
-            }
-
-            mWaitCV.wait_for(runLock, std::chrono::nanoseconds(nextSampleTime - now));
+void Sensor::updateSamplingLocked() {
+    if (!mIsEnabled || mMode != OperationMode::NORMAL) {
+        if (mSampleTimerId >= 0) {
+            mReactor->cancelTimer(mSampleTimerId);
         }
+        return;
+    }
+
+    if (mSampleTimerId < 0) {
+        mSampleTimerId = mReactor->addTimer(
+                [this](int64_t timestampNs) { handleSampleTimer(timestampNs); });
     }
+    // A deadline in the past samples right away.
+    mReactor->scheduleTimer(mSampleTimerId, mLastSampleTimeNs + mSamplingPeriodNs);
+}
+
+void Sensor::handleSampleTimer(int64_t timestampNs) {
+    std::lock_guard<std::mutex> lock(mRunMutex);
+    // The timer may have been cancelled while the reactor was dispatching.
+    if (!mIsEnabled || mMode != OperationMode::NORMAL) return;
+
+    // Keep to the sampling grid, unless we fell more than a period behind.
+    int64_t nextSampleTime = mLastSampleTimeNs + mSamplingPeriodNs;
+    mLastSampleTimeNs = timestampNs - nextSampleTime < mSamplingPeriodNs ? nextSampleTime
+                                                                         : timestampNs;
+    size_t count = readEvents();
+    mCallback->postEvents(mEvents.data(), count, isWakeUpSensor());
+    mPostLatency.record(::android::elapsedRealtimeNano() - timestampNs);
+
+    mReactor->scheduleTimer(mSampleTimerId, mLastSampleTimeNs + mSamplingPeriodNs);
 }
 
 bool Sensor::isWakeUpSensor() {
     return mSensorInfo.flags & static_cast<uint32_t>(SensorFlagBits::WAKE_UP);
 }
 
-std::vector<Event> Sensor::readEvents() {
-    std::vector<Event> events;
-    Event event;
+size_t Sensor::readEvents() {
+    Event& event = mEvents[0];
     event.sensorHandle = mSensorInfo.sensorHandle;
     event.sensorType = mSensorInfo.type;
     event.timestamp = ::android::elapsedRealtimeNano();
@@ -179,15 +187,14 @@ std::vector<Event> Sensor::readEvents() {
     event.u.vec3.y = 0;
     event.u.vec3.z = 0;
     event.u.vec3.status = SensorStatus::ACCURACY_HIGH;
-    events.push_back(event);
-    return events;
+    return 1;
 }
 
 void Sensor::setOperationMode(OperationMode mode) {
     std::lock_guard<std::mutex> lock(mRunMutex);
     if (mMode != mode) {
         mMode = mode;
-        mWaitCV.notify_all();
+        updateSamplingLocked();
     }
 }
 
@@ -203,67 +210,65 @@ Result Sensor::injectEvent(const Event& event) {
     } else if (!supportsDataInjection()) {
         result = Result::INVALID_OPERATION;
     } else if (mMode == OperationMode::DATA_INJECTION) {
-        mCallback->postEvents(std::vector<Event>{event}, isWakeUpSensor());
+        mCallback->postEvents(&event, 1, isWakeUpSensor());
     } else {
         result = Result::BAD_VALUE;
     }
     return result;
 }
 
-OneShotSensor::OneShotSensor(int32_t sensorHandle, ISensorsEventCallback* callback)
-    : Sensor(sensorHandle, callback) {
+OneShotSensor::OneShotSensor(int32_t sensorHandle, ISensorsEventCallback* callback,
+                             PollReactor* reactor)
+    : Sensor(sensorHandle, callback, reactor) {
     mSensorInfo.minDelay = -1;
     mSensorInfo.maxDelay = 0;
     mSensorInfo.flags |= SensorFlagBits::ONE_SHOT_MODE;
 }
 
-SysfsPollingOneShotSensor::SysfsPollingOneShotSensor(
-        int32_t sensorHandle, ISensorsEventCallback* callback, const std::string& pollPath,
-        const std::string& enablePath, const std::string& name, const std::string& typeAsString,
-        SensorType type)
-    : OneShotSensor(sensorHandle, callback) {
-    mSensorInfo.name = name;
-    mSensorInfo.type = type;
-    mSensorInfo.typeAsString = typeAsString;
+SysfsPollingOneShotSensor::SysfsPollingOneShotSensor(int32_t sensorHandle,
+                                                     ISensorsEventCallback* callback,
+                                                     PollReactor* reactor,
+                                                     const SysfsSensorDescriptor& descriptor)
+    : OneShotSensor(sensorHandle, callback, reactor),
+      mPolling(false),
+      mParser(descriptor.parser),
+      mStateIndex(descriptor.stateIndex),
+      mPayloadIndexes(descriptor.payload),
+      mPayloadSize(descriptor.payloadSize),
+      mWakeTimestampNs(0),
+      mPayload{} {
+    mSensorInfo.name = descriptor.name;
+    mSensorInfo.type = static_cast<SensorType>(
+            static_cast<int32_t>(SensorType::DEVICE_PRIVATE_BASE) + descriptor.privateType);
+    mSensorInfo.typeAsString = descriptor.typeAsString;
     mSensorInfo.maxRange = 2048.0f;
     mSensorInfo.resolution = 1.0f;
     mSensorInfo.power = 0;
-    mSensorInfo.flags |= SensorFlagBits::WAKE_UP;
-
-    mEnableStream.open(enablePath);
-
-    int rc;
+    if (descriptor.wakeUp) {
+        mSensorInfo.flags |= SensorFlagBits::WAKE_UP;
+    }
 
-    rc = pipe(mWaitPipeFd);
-    if (rc < 0) {
-        mWaitPipeFd[0] = -1;
-        mWaitPipeFd[1] = -1;
-        ALOGE("failed to open wait pipe: %d", rc);
+    if (!descriptor.enablePath.empty()) {
+        mEnableStream.open(descriptor.enablePath);
     }
 
-    mPollFd = open(pollPath.c_str(), O_RDONLY);
+    mPollFd = open(descriptor.pollPath.c_str(), O_RDONLY | O_CLOEXEC);
     if (mPollFd < 0) {
         ALOGE("failed to open poll fd: %d", mPollFd);
-    }
-
-    if (mWaitPipeFd[0] < 0 || mWaitPipeFd[1] < 0 || mPollFd < 0) {
-        mStopThread = true;
         return;
     }
 
-    mPolls[0] = {
-            .fd = mWaitPipeFd[0],
-            .events = POLLIN,
-    };
-
-    mPolls[1] = {
-            .fd = mPollFd,
-            .events = POLLERR | POLLPRI,
-    };
+    mReactor->add(mPollFd, [this](uint32_t /* events */, int64_t timestampNs) {
+        handlePollEvent(timestampNs);
+    });
 }
 
 SysfsPollingOneShotSensor::~SysfsPollingOneShotSensor() {
-    interruptPoll();
+    stopSampling();
+    if (mPollFd >= 0) {
+        mReactor->remove(mPollFd);
+        close(mPollFd);
+    }
 }
 
 void SysfsPollingOneShotSensor::writeEnable(bool enable) {
@@ -272,125 +277,105 @@ void SysfsPollingOneShotSensor::writeEnable(bool enable) {
     }
 }
 
-void SysfsPollingOneShotSensor::activate(bool enable, bool notify, bool lock) {
-    std::unique_lock<std::mutex> runLock(mRunMutex, std::defer_lock);
-
-    if (lock) {
-        runLock.lock();
-    }
-
+void SysfsPollingOneShotSensor::activate(bool enable) {
+    std::lock_guard<std::mutex> runLock(mRunMutex);
     if (mIsEnabled != enable) {
         writeEnable(enable);
-
         mIsEnabled = enable;
-
-        if (notify) {
-            interruptPoll();
-            mWaitCV.notify_all();
-        }
-    }
-
-    if (lock) {
-        runLock.unlock();
+        updatePollingLocked();
     }
 }
 
-void SysfsPollingOneShotSensor::activate(bool enable) {
-    activate(enable, true, true);
-}
-
 void SysfsPollingOneShotSensor::setOperationMode(OperationMode mode) {
-    Sensor::setOperationMode(mode);
-    interruptPoll();
+    std::lock_guard<std::mutex> runLock(mRunMutex);
+    mMode = mode;
+    updatePollingLocked();
 }
 
-void SysfsPollingOneShotSensor::run() {
-    std::unique_lock<std::mutex> runLock(mRunMutex);
-
-    while (!mStopThread) {
-        if (!mIsEnabled || mMode == OperationMode::DATA_INJECTION) {
-            mWaitCV.wait(runLock, [&] {
-                return ((mIsEnabled && mMode == OperationMode::NORMAL) || mStopThread);
-            });
-        } else {
-            // Cannot hold lock while polling.
-            runLock.unlock();
-            int rc = poll(mPolls, 2, -1);
-            runLock.lock();
-
-            if (rc < 0) {
-                ALOGE("failed to poll: %d", rc);
-                mStopThread = true;
-                continue;
-            }
+void SysfsPollingOneShotSensor::updatePollingLocked() {
+    bool polling = mIsEnabled && mMode == OperationMode::NORMAL && mPollFd >= 0;
+    if (mPolling == polling) return;
 
-            if (mPolls[1].revents == mPolls[1].events && readFd(mPollFd)) {
-                activate(false, false, false);
-                mCallback->postEvents(readEvents(), isWakeUpSensor());
-            } else if (mPolls[0].revents == mPolls[0].events) {
-                readBool(mWaitPipeFd[0], false /* seek */);
-            }
-        }
+    if (polling) {
+        // Sysfs attributes signal a change with POLLPRI | POLLERR, the fd is level triggered until
+        // it is read again.
+        polling = mReactor->arm(mPollFd, EPOLLPRI | EPOLLERR);
+    } else {
+        mReactor->disarm(mPollFd);
     }
+    mPolling = polling;
 }
 
-void SysfsPollingOneShotSensor::interruptPoll() {
-    if (mWaitPipeFd[1] < 0) return;
+void SysfsPollingOneShotSensor::handlePollEvent(int64_t timestampNs) {
+    std::lock_guard<std::mutex> runLock(mRunMutex);
+    // The fd may have been disarmed while the reactor was dispatching.
+    if (!mPolling) return;
 
-    char c = '1';
-    write(mWaitPipeFd[1], &c, sizeof(c));
+    if (readFd(mPollFd)) {
+        mIsEnabled = false;
+        writeEnable(false);
+        updatePollingLocked();
+        // Stamp the event with the wakeup rather than the time it took to get here.
+        mWakeTimestampNs = timestampNs;
+        size_t count = readEvents();
+        mCallback->postEvents(mEvents.data(), count, isWakeUpSensor());
+        mPostLatency.record(::android::elapsedRealtimeNano() - timestampNs);
+    }
 }
 
-std::vector<Event> SysfsPollingOneShotSensor::readEvents() {
-    std::vector<Event> events;
-    Event event;
+size_t SysfsPollingOneShotSensor::readEvents() {
+    Event& event = mEvents[0];
     event.sensorHandle = mSensorInfo.sensorHandle;
     event.sensorType = mSensorInfo.type;
-    event.timestamp = ::android::elapsedRealtimeNano();
+    event.timestamp = mWakeTimestampNs;
     fillEventData(event);
-    events.push_back(event);
-    return events;
+    return 1;
 }
 
 void SysfsPollingOneShotSensor::fillEventData(Event& event) {
-    event.u.data[0] = 0;
-    event.u.data[1] = 0;
+    for (size_t i = 0; i < SysfsSensorDescriptor::kMaxPayloadValues; i++) {
+        event.u.data[i] = i < mPayloadSize ? mPayload[i] : 0;
+    }
 }
 
 bool SysfsPollingOneShotSensor::readFd(const int fd) {
-    return readBool(fd, true /* seek */);
-}
-
-void UdfpsSensor::fillEventData(Event& event) {
-    event.u.data[0] = mScreenX;
-    event.u.data[1] = mScreenY;
+    switch (mParser) {
+        case SysfsParser::BOOL:
+            return readBool(fd, true /* seek */);
+        case SysfsParser::INT_TUPLE:
+            return readIntTuple(fd);
+    }
+    return false;
 }
 
-bool UdfpsSensor::readFd(const int fd) {
-    char buffer[512];
-    int state = 0;
-    int rc;
-
-    rc = lseek(fd, 0, SEEK_SET);
-    if (rc < 0) {
-        ALOGE("failed to seek: %d", rc);
-        return false;
-    }
-    rc = read(fd, &buffer, sizeof(buffer));
+bool SysfsPollingOneShotSensor::readIntTuple(const int fd) {
+    std::array<int, SysfsSensorDescriptor::kMaxPayloadValues + 1> values;
+    int rc = readSysfsIntTuple(fd, values.data(), values.size());
     if (rc < 0) {
         ALOGE("failed to read state: %d", rc);
         return false;
     }
-    rc = sscanf(buffer, "%d,%d,%d", &mScreenX, &mScreenY, &state);
-    if (rc == 1) {
-        // If fod_press_status contains only one value,
+    size_t count = rc;
+
+    int state;
+    if (count == 1) {
+        // If the attribute contains only one value,
         // assume that just reports the state
-        state = mScreenX;
-        mScreenX = 0;
-        mScreenY = 0;
-    } else if (rc < 3) {
-        ALOGE("failed to parse fp state: %d", rc);
-        return false;
+        state = values[0];
+        mPayload.fill(0);
+    } else {
+        if (count <= mStateIndex) {
+            ALOGE("failed to parse %s state: %zu", mSensorInfo.name.c_str(), count);
+            return false;
+        }
+        for (size_t i = 0; i < mPayloadSize; i++) {
+            if (mPayloadIndexes[i] >= count) {
+                ALOGE("failed to parse %s state: %zu", mSensorInfo.name.c_str(), count);
+                return false;
+            }
+            mPayload[i] = values[mPayloadIndexes[i]];
+        }
+        state = values[mStateIndex];
     }
     return state > 0;
 }
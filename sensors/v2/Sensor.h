@@ -18,16 +18,18 @@
 
 #include <android/hardware/sensors/2.1/types.h>
 #include <fcntl.h>
-#include <poll.h>
 #include <unistd.h>
 
-#include <condition_variable>
+#include <array>
 #include <fstream>
 #include <memory>
 #include <mutex>
-#include <thread>
 #include <vector>
 
+#include "LatencyStats.h"
+#include "PollReactor.h"
+#include "SysfsSensorDescriptor.h"
+
 using ::android::hardware::sensors::V1_0::OperationMode;
 using ::android::hardware::sensors::V1_0::Result;
 using ::android::hardware::sensors::V2_1::Event;
@@ -44,12 +46,16 @@ namespace implementation {
 class ISensorsEventCallback {
   public:
     virtual ~ISensorsEventCallback(){};
-    virtual void postEvents(const std::vector<Event>& events, bool wakeup) = 0;
+    virtual void postEvents(const Event* events, size_t count, bool wakeup) = 0;
+
+    void postEvents(const std::vector<Event>& events, bool wakeup) {
+        postEvents(events.data(), events.size(), wakeup);
+    }
 };
 
 class Sensor {
   public:
-    Sensor(int32_t sensorHandle, ISensorsEventCallback* callback);
+    Sensor(int32_t sensorHandle, ISensorsEventCallback* callback, PollReactor* reactor);
     virtual ~Sensor();
 
     const SensorInfo& getSensorInfo() const;
@@ -61,31 +67,55 @@ class Sensor {
     bool supportsDataInjection() const;
     Result injectEvent(const Event& event);
 
+    //! Time from the sensor waking up to its event being handed to the callback.
+    const LatencyStats& getPostLatency() const { return mPostLatency; }
+
   protected:
-    virtual void run();
-    virtual std::vector<Event> readEvents();
-    static void startThread(Sensor* sensor);
+    //! Events read in one go never exceed this, so mEvents is allocated once per sensor.
+    static constexpr size_t kMaxEventsPerRead = 1;
+
+    //! Fill mEvents and return the number of events read.
+    virtual size_t readEvents();
 
     bool isWakeUpSensor();
 
+    /**
+     * Stop periodic sampling and wait for a running sample to finish. The sample calls the
+     * virtual readEvents, so the destructor of every sensor that can be enabled through
+     * Sensor::activate must call this before its own members go away. Must not hold mRunMutex.
+     */
+    void stopSampling();
+
     bool mIsEnabled;
     int64_t mSamplingPeriodNs;
     int64_t mLastSampleTimeNs;
     SensorInfo mSensorInfo;
 
-    std::atomic_bool mStopThread;
-    std::condition_variable mWaitCV;
     std::mutex mRunMutex;
-    std::thread mRunThread;
 
     ISensorsEventCallback* mCallback;
+    PollReactor* mReactor;
 
     OperationMode mMode;
+
+    std::array<Event, kMaxEventsPerRead> mEvents;
+
+    LatencyStats mPostLatency;
+
+  private:
+    //! Runs on the reactor thread when the next sample is due.
+    void handleSampleTimer(int64_t timestampNs);
+
+    //! Schedule the next sample while enabled in normal mode. Must hold mRunMutex.
+    void updateSamplingLocked();
+
+    //! Registered with the reactor on first use, -1 until then.
+    int mSampleTimerId;
 };
 
 class OneShotSensor : public Sensor {
   public:
-    OneShotSensor(int32_t sensorHandle, ISensorsEventCallback* callback);
+    OneShotSensor(int32_t sensorHandle, ISensorsEventCallback* callback, PollReactor* reactor);
 
     virtual void batch(int32_t /* samplingPeriodNs */) override {}
 
@@ -95,69 +125,41 @@ class OneShotSensor : public Sensor {
 class SysfsPollingOneShotSensor : public OneShotSensor {
   public:
     SysfsPollingOneShotSensor(int32_t sensorHandle, ISensorsEventCallback* callback,
-                              const std::string& pollPath, const std::string& enablePath,
-                              const std::string& name, const std::string& typeAsString,
-                              SensorType type);
+                              PollReactor* reactor, const SysfsSensorDescriptor& descriptor);
     virtual ~SysfsPollingOneShotSensor() override;
 
     virtual void activate(bool enable) override;
-    virtual void activate(bool enable, bool notify, bool lock);
     virtual void writeEnable(bool enable);
     virtual void setOperationMode(OperationMode mode) override;
-    virtual std::vector<Event> readEvents() override;
+    virtual size_t readEvents() override;
     virtual void fillEventData(Event& event);
     virtual bool readFd(const int fd);
 
   protected:
-    virtual void run() override;
-
     std::ofstream mEnableStream;
 
   private:
-    void interruptPoll();
+    //! Runs on the reactor thread when the sysfs attribute changes.
+    void handlePollEvent(int64_t timestampNs);
 
-    struct pollfd mPolls[2];
-    int mWaitPipeFd[2];
-    int mPollFd;
-};
+    //! Watch the poll fd only while enabled in normal mode. Must hold mRunMutex.
+    void updatePollingLocked();
 
-class UdfpsSensor : public SysfsPollingOneShotSensor {
-  public:
-    UdfpsSensor(int32_t sensorHandle, ISensorsEventCallback* callback)
-        : SysfsPollingOneShotSensor(
-                  sensorHandle, callback, "/sys/class/touch/touch_dev/fod_press_status",
-                  "/sys/class/touch/touch_dev/fod_longpress_gesture_enabled", "UDFPS Sensor",
-                  "org.lineageos.sensor.udfps",
-                  static_cast<SensorType>(static_cast<int32_t>(SensorType::DEVICE_PRIVATE_BASE) +
-                                          1)) {}
-    virtual void fillEventData(Event& event);
-    virtual bool readFd(const int fd);
+    bool readIntTuple(const int fd);
 
-  private:
-    int mScreenX;
-    int mScreenY;
-};
+    int mPollFd;
+    bool mPolling;
 
-class SingleTapSensor : public SysfsPollingOneShotSensor {
-  public:
-    SingleTapSensor(int32_t sensorHandle, ISensorsEventCallback* callback)
-        : SysfsPollingOneShotSensor(
-                  sensorHandle, callback, "/sys/class/touch/touch_dev/gesture_single_tap_state",
-                  "/sys/class/touch/touch_dev/gesture_single_tap_enabled", "Single Tap Sensor",
-                  "org.lineageos.sensor.single_tap",
-                  static_cast<SensorType>(static_cast<int32_t>(SensorType::DEVICE_PRIVATE_BASE) +
-                                          2)) {}
-};
+    SysfsParser mParser;
+    uint8_t mStateIndex;
+    std::array<uint8_t, SysfsSensorDescriptor::kMaxPayloadValues> mPayloadIndexes;
+    uint8_t mPayloadSize;
 
-class DoubleTapSensor : public SysfsPollingOneShotSensor {
-  public:
-    DoubleTapSensor(int32_t sensorHandle, ISensorsEventCallback* callback)
-        : SysfsPollingOneShotSensor(
-                  sensorHandle, callback, "/sys/class/touch/touch_dev/gesture_double_tap_state",
-                  "/sys/class/touch/touch_dev/gesture_double_tap_enabled", "Double Tap Sensor",
-                  "org.lineageos.sensor.double_tap",
-                  static_cast<SensorType>(static_cast<int32_t>(SensorType::DEVICE_PRIVATE_BASE) +
-                                          3)) {}
+    //! When the reactor woke up for the last event, used as its timestamp.
+    int64_t mWakeTimestampNs;
+
+    //! Payload of the last event read from the poll fd.
+    std::array<int, SysfsSensorDescriptor::kMaxPayloadValues> mPayload;
 };
 
 }  // namespace implementation
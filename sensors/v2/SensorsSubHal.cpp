@@ -16,7 +16,6 @@
 
 #include "SensorsSubHal.h"
 
-#include <android-base/properties.h>
 #include <android/hardware/sensors/2.1/types.h>
 #include <log/log.h>
 
@@ -30,19 +29,12 @@ namespace V2_1 {
 namespace subhal {
 namespace implementation {
 
-using ::android::base::GetBoolProperty;
 using ::android::hardware::Void;
 using ::android::hardware::sensors::V2_0::implementation::ScopedWakelock;
 
 SensorsSubHal::SensorsSubHal() : mCallback(nullptr), mNextHandle(1) {
-    if (GetBoolProperty("ro.vendor.sensors.xiaomi.udfps", false)) {
-        AddSensor<UdfpsSensor>();
-    }
-    if (GetBoolProperty("ro.vendor.sensors.xiaomi.single_tap", false)) {
-        AddSensor<SingleTapSensor>();
-    }
-    if (GetBoolProperty("ro.vendor.sensors.xiaomi.double_tap", false)) {
-        AddSensor<DoubleTapSensor>();
+    for (const SysfsSensorDescriptor& descriptor : loadSysfsSensorDescriptors()) {
+        AddSensor<SysfsPollingOneShotSensor>(descriptor);
     }
 }
 
@@ -138,6 +130,7 @@ Return<void> SensorsSubHal::debug(const hidl_handle& fd, const hidl_vec<hidl_str
         stream << "Name: " << info.name << std::endl;
         stream << "Min delay: " << info.minDelay << std::endl;
         stream << "Flags: " << info.flags << std::endl;
+        sensor.second->getPostLatency().dump(stream);
     }
     stream << std::endl;
 
@@ -153,9 +146,13 @@ Return<Result> SensorsSubHal::initialize(const sp<IHalProxyCallback>& halProxyCa
     return Result::OK;
 }
 
-void SensorsSubHal::postEvents(const std::vector<Event>& events, bool wakeup) {
+void SensorsSubHal::postEvents(const Event* events, size_t count, bool wakeup) {
+    // The proxy callback takes a vector, reuse one per posting thread so steady state posting
+    // does not allocate.
+    thread_local std::vector<Event> frameworkEvents;
+    frameworkEvents.assign(events, events + count);
     ScopedWakelock wakelock = mCallback->createScopedWakelock(wakeup);
-    mCallback->postEvents(events, std::move(wakelock));
+    mCallback->postEvents(frameworkEvents, std::move(wakelock));
 }
 
 }  // namespace implementation
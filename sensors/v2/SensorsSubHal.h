@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <vector>
 
 #include "Sensor.h"
@@ -67,16 +69,21 @@ class SensorsSubHal : public ISensorsSubHal, public ISensorsEventCallback {
 
     const std::string getName() { return "FakeSubHal"; }
 
-    void postEvents(const std::vector<Event>& events, bool wakeup) override;
+    using ISensorsEventCallback::postEvents;
+    void postEvents(const Event* events, size_t count, bool wakeup) override;
 
   protected:
-    template <class SensorType>
-    void AddSensor() {
+    template <class SensorType, typename... Args>
+    void AddSensor(Args&&... args) {
         std::shared_ptr<SensorType> sensor =
-                std::make_shared<SensorType>(mNextHandle++ /* sensorHandle */, this /* callback */);
+                std::make_shared<SensorType>(mNextHandle++ /* sensorHandle */, this /* callback */,
+                                             &mPollReactor, std::forward<Args>(args)...);
         mSensors[sensor->getSensorInfo().sensorHandle] = sensor;
     }
 
+    //! Shared by every sysfs sensor, declared first so it outlives them.
+    PollReactor mPollReactor;
+
     std::map<int32_t, std::shared_ptr<Sensor>> mSensors;
 
     sp<IHalProxyCallback> mCallback;
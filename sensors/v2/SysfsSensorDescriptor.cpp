@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SysfsSensorDescriptor.h"
+
+#include <android-base/file.h>
+#include <android-base/properties.h>
+#include <log/log.h>
+#include <utils/SystemClock.h>
+
+#include <charconv>
+#include <cinttypes>
+#include <iterator>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+using ::android::base::GetBoolProperty;
+using ::android::base::ReadFileToString;
+
+namespace {
+
+constexpr char kDescriptorFile[] = "/vendor/etc/sensors/xiaomi_sysfs_sensors.conf";
+
+struct BuiltinSensor {
+    const char* property;
+    SysfsSensorDescriptor descriptor;
+};
+
+const BuiltinSensor kBuiltinSensors[] = {
+        {"ro.vendor.sensors.xiaomi.udfps",
+         {"UDFPS Sensor", "org.lineageos.sensor.udfps",
+          "/sys/class/touch/touch_dev/fod_press_status",
+          "/sys/class/touch/touch_dev/fod_longpress_gesture_enabled", 1, true,
+          SysfsParser::INT_TUPLE, 2, {0, 1}, 2}},
+        {"ro.vendor.sensors.xiaomi.single_tap",
+         {"Single Tap Sensor", "org.lineageos.sensor.single_tap",
+          "/sys/class/touch/touch_dev/gesture_single_tap_state",
+          "/sys/class/touch/touch_dev/gesture_single_tap_enabled", 2, true, SysfsParser::BOOL, 0,
+          {}, 0}},
+        {"ro.vendor.sensors.xiaomi.double_tap",
+         {"Double Tap Sensor", "org.lineageos.sensor.double_tap",
+          "/sys/class/touch/touch_dev/gesture_double_tap_state",
+          "/sys/class/touch/touch_dev/gesture_double_tap_enabled", 3, true, SysfsParser::BOOL, 0,
+          {}, 0}},
+};
+
+std::string_view trim(std::string_view s) {
+    size_t begin = s.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) return {};
+    size_t end = s.find_last_not_of(" \t\r");
+    return s.substr(begin, end - begin + 1);
+}
+
+//! Split off everything up to the first delimiter, or all of s if there is none.
+std::string_view nextToken(std::string_view& s, char delimiter) {
+    size_t pos = s.find(delimiter);
+    std::string_view token = s.substr(0, pos);
+    s = pos == std::string_view::npos ? std::string_view() : s.substr(pos + 1);
+    return token;
+}
+
+template <typename T>
+bool parseInt(std::string_view s, T& value) {
+    auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+    return ec == std::errc() && end == s.data() + s.size();
+}
+
+//! Tuples are read with room for one value more than the payload, see readIntTuple.
+bool parseIndex(std::string_view s, uint8_t& index) {
+    return parseInt(s, index) && index <= SysfsSensorDescriptor::kMaxPayloadValues;
+}
+
+bool isBuiltinId(int32_t privateType) {
+    for (const BuiltinSensor& sensor : kBuiltinSensors) {
+        if (sensor.descriptor.privateType == privateType) return true;
+    }
+    return false;
+}
+
+bool parseLine(std::string_view line, SysfsSensorDescriptor& descriptor) {
+    descriptor = {};
+    descriptor.wakeUp = true;
+    descriptor.parser = SysfsParser::BOOL;
+    bool hasId = false;
+    bool hasState = false;
+
+    while (!line.empty()) {
+        std::string_view pair = trim(nextToken(line, ';'));
+        if (pair.empty()) continue;
+
+        size_t eq = pair.find('=');
+        if (eq == std::string_view::npos) return false;
+        std::string_view key = trim(pair.substr(0, eq));
+        std::string_view value = trim(pair.substr(eq + 1));
+
+        if (key == "name") {
+            descriptor.name = value;
+        } else if (key == "type") {
+            descriptor.typeAsString = value;
+        } else if (key == "poll") {
+            descriptor.pollPath = value;
+        } else if (key == "enable") {
+            descriptor.enablePath = value;
+        } else if (key == "id") {
+            if (!parseInt(value, descriptor.privateType) || descriptor.privateType <= 0 ||
+                isBuiltinId(descriptor.privateType)) {
+                return false;
+            }
+            hasId = true;
+        } else if (key == "wake") {
+            descriptor.wakeUp = value != "0";
+        } else if (key == "parser") {
+            if (value == "bool") {
+                descriptor.parser = SysfsParser::BOOL;
+            } else if (value == "tuple") {
+                descriptor.parser = SysfsParser::INT_TUPLE;
+            } else {
+                return false;
+            }
+        } else if (key == "state") {
+            if (!parseIndex(value, descriptor.stateIndex)) return false;
+            hasState = true;
+        } else if (key == "payload") {
+            while (!value.empty()) {
+                if (descriptor.payloadSize == SysfsSensorDescriptor::kMaxPayloadValues ||
+                    !parseIndex(trim(nextToken(value, ',')),
+                                descriptor.payload[descriptor.payloadSize])) {
+                    return false;
+                }
+                descriptor.payloadSize++;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    // Boolean attributes have no tuple to index into.
+    if (descriptor.parser == SysfsParser::BOOL && (hasState || descriptor.payloadSize > 0)) {
+        return false;
+    }
+
+    return hasId && !descriptor.name.empty() && !descriptor.typeAsString.empty() &&
+           !descriptor.pollPath.empty();
+}
+
+}  // namespace
+
+std::vector<SysfsSensorDescriptor> parseSysfsSensorDescriptors(std::string_view config) {
+    std::vector<SysfsSensorDescriptor> descriptors;
+    int lineNumber = 0;
+
+    while (!config.empty()) {
+        std::string_view line = trim(nextToken(config, '\n'));
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+
+        SysfsSensorDescriptor descriptor;
+        if (parseLine(line, descriptor)) {
+            descriptors.push_back(std::move(descriptor));
+        } else {
+            ALOGE("ignoring malformed sensor descriptor on line %d", lineNumber);
+        }
+    }
+
+    return descriptors;
+}
+
+std::vector<SysfsSensorDescriptor> loadSysfsSensorDescriptors() {
+    int64_t startTime = ::android::elapsedRealtimeNano();
+    std::vector<SysfsSensorDescriptor> descriptors;
+
+    for (const BuiltinSensor& sensor : kBuiltinSensors) {
+        if (GetBoolProperty(sensor.property, false)) {
+            descriptors.push_back(sensor.descriptor);
+        }
+    }
+
+    std::string config;
+    if (ReadFileToString(kDescriptorFile, &config)) {
+        std::vector<SysfsSensorDescriptor> configured = parseSysfsSensorDescriptors(config);
+        descriptors.insert(descriptors.end(), std::make_move_iterator(configured.begin()),
+                           std::make_move_iterator(configured.end()));
+    }
+
+    ALOGI("loaded %zu sysfs sensors in %" PRId64 " us", descriptors.size(),
+          (::android::elapsedRealtimeNano() - startTime) / 1000);
+    return descriptors;
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
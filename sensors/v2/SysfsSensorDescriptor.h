@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+//! How the poll attribute of a sysfs sensor is read.
+enum class SysfsParser : uint8_t {
+    //! A single character, anything but '0' triggers the sensor.
+    BOOL,
+    //! Comma separated integers, see SysfsSensorDescriptor::stateIndex.
+    INT_TUPLE,
+};
+
+/**
+ * Everything needed to expose a touch panel gesture reported through sysfs as a one-shot sensor.
+ */
+struct SysfsSensorDescriptor {
+    static constexpr size_t kMaxPayloadValues = 8;
+
+    std::string name;
+    std::string typeAsString;
+    std::string pollPath;
+    std::string enablePath;
+
+    //! Offset of the sensor type from SensorType::DEVICE_PRIVATE_BASE.
+    int32_t privateType;
+
+    bool wakeUp;
+    SysfsParser parser;
+
+    /**
+     * Tuple value that triggers the sensor when positive. A tuple with a single value always
+     * reports just the state and leaves the payload zeroed.
+     */
+    uint8_t stateIndex;
+
+    //! Tuple values copied to the event data, in order.
+    std::array<uint8_t, kMaxPayloadValues> payload;
+    uint8_t payloadSize;
+};
+
+/**
+ * Parse a descriptor file. Every non-empty line not starting with '#' describes one sensor as
+ * ';' separated key=value pairs, for example:
+ *
+ *   name=Long Press Sensor;type=org.lineageos.sensor.long_press;id=4;
+ *   poll=/sys/class/touch/touch_dev/gesture_long_press_state;
+ *   enable=/sys/class/touch/touch_dev/gesture_long_press_enabled;parser=bool;wake=1
+ *
+ * (on a single line). Tuple sensors additionally take state=<index> and payload=<i>,<j>,...
+ * with indexes up to kMaxPayloadValues. Ids 1 to 3 belong to the built-in sensors. Malformed
+ * lines are logged and skipped.
+ */
+std::vector<SysfsSensorDescriptor> parseSysfsSensorDescriptors(std::string_view config);
+
+/**
+ * @return The built-in sensors enabled by their ro.vendor.sensors.xiaomi.* property, followed by
+ *         the sensors of the vendor descriptor file if present.
+ */
+std::vector<SysfsSensorDescriptor> loadSysfsSensorDescriptors();
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PollReactor.h"
+
+#include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <utils/SystemClock.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+namespace {
+
+//! As many fake attributes as the built-in UDFPS, single tap and double tap sensors.
+constexpr size_t kNumAttributes = 3;
+constexpr size_t kNumChanges = 300;
+constexpr int64_t kChangeIntervalNs = 2 * 1000 * 1000;
+
+/**
+ * Pipes standing in for sysfs attributes. A pipe signals EPOLLIN where the kernel signals
+ * EPOLLPRI for sysfs, the reactor itself does not care which events it waits for.
+ */
+class FakeAttribute {
+  public:
+    FakeAttribute() { EXPECT_EQ(0, pipe(mFds)); }
+
+    ~FakeAttribute() {
+        close(mFds[0]);
+        close(mFds[1]);
+    }
+
+    int readFd() const { return mFds[0]; }
+
+    void change() { EXPECT_EQ(1, write(mFds[1], "1", 1)); }
+
+    void consume() {
+        char value;
+        EXPECT_EQ(1, read(mFds[0], &value, 1));
+    }
+
+  private:
+    int mFds[2];
+};
+
+class PollReactorTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        for (size_t i = 0; i < kNumAttributes; i++) {
+            FakeAttribute* attribute = &mAttributes[i];
+            mReactor.add(attribute->readFd(), [this, attribute](uint32_t, int64_t timestampNs) {
+                attribute->consume();
+                int64_t nowNs = ::android::elapsedRealtimeNano();
+                std::lock_guard<std::mutex> lock(mMutex);
+                mWakeTimestampsNs.push_back(timestampNs);
+                mDeliveryTimestampsNs.push_back(nowNs);
+                mDelivered.notify_all();
+            });
+            ASSERT_TRUE(mReactor.arm(attribute->readFd(), EPOLLIN));
+        }
+    }
+
+    void TearDown() override {
+        for (FakeAttribute& attribute : mAttributes) {
+            mReactor.remove(attribute.readFd());
+        }
+    }
+
+    //! @return Whether the callback for change number count ran within a second.
+    bool waitForDeliveries(size_t count) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        return mDelivered.wait_for(lock, std::chrono::seconds(1),
+                                   [&] { return mDeliveryTimestampsNs.size() >= count; });
+    }
+
+    std::array<FakeAttribute, kNumAttributes> mAttributes;
+    PollReactor mReactor;
+
+    std::mutex mMutex;
+    std::condition_variable mDelivered;
+    std::vector<int64_t> mWakeTimestampsNs;
+    std::vector<int64_t> mDeliveryTimestampsNs;
+};
+
+//! Ten periodic sensors at 100 Hz down to 10 Hz, sampled on their period grid like Sensor does.
+constexpr size_t kNumPeriodicSensors = 10;
+constexpr int64_t kBasePeriodNs = 10 * 1000 * 1000;
+constexpr int64_t kSamplingDurationNs = 1000 * 1000 * 1000;
+
+struct Sample {
+    int64_t deadlineNs;
+    int64_t timestampNs;
+};
+
+int64_t percentile(std::vector<int64_t> samples, size_t percent) {
+    std::sort(samples.begin(), samples.end());
+    return samples[(samples.size() - 1) * percent / 100];
+}
+
+}  // namespace
+
+TEST_F(PollReactorTest, DeliversAttributeChangesPromptly) {
+    std::vector<int64_t> changeTimestampsNs;
+    for (size_t i = 0; i < kNumChanges; i++) {
+        changeTimestampsNs.push_back(::android::elapsedRealtimeNano());
+        mAttributes[i % kNumAttributes].change();
+        ASSERT_TRUE(waitForDeliveries(i + 1)) << "change " << i << " was never delivered";
+        std::this_thread::sleep_for(std::chrono::nanoseconds(kChangeIntervalNs));
+    }
+
+    std::vector<int64_t> latenciesNs;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ASSERT_EQ(kNumChanges, mDeliveryTimestampsNs.size());
+        for (size_t i = 0; i < kNumChanges; i++) {
+            // The wakeup is stamped between the change and the callback.
+            EXPECT_GE(mWakeTimestampsNs[i], changeTimestampsNs[i]);
+            EXPECT_LE(mWakeTimestampsNs[i], mDeliveryTimestampsNs[i]);
+            latenciesNs.push_back(mDeliveryTimestampsNs[i] - changeTimestampsNs[i]);
+        }
+    }
+
+    int64_t medianNs = percentile(latenciesNs, 50);
+    int64_t p99Ns = percentile(latenciesNs, 99);
+    RecordProperty("median_latency_us", std::to_string(medianNs / 1000));
+    RecordProperty("p99_latency_us", std::to_string(p99Ns / 1000));
+    // Loose enough for a loaded test host, an idle device is well below a millisecond.
+    EXPECT_LT(medianNs, 2 * 1000 * 1000);
+    EXPECT_LT(p99Ns, 20 * 1000 * 1000);
+}
+
+TEST_F(PollReactorTest, IgnoresDisarmedAttributes) {
+    mReactor.disarm(mAttributes[0].readFd());
+    mAttributes[0].change();
+    mAttributes[1].change();
+
+    ASSERT_TRUE(waitForDeliveries(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::lock_guard<std::mutex> lock(mMutex);
+    EXPECT_EQ(1u, mDeliveryTimestampsNs.size());
+}
+
+// Sensors sampling on a common grid share reactor wakeups: the 10 sensors below ask for about
+// 290 samples per second, but each due deadline lies on the 10 ms grid of the fastest one.
+TEST(PollReactorTimerTest, MeasuresWakeupsAndJitterOfTenPeriodicSensors) {
+    PollReactor reactor;
+    std::mutex mutex;
+    std::vector<Sample> samples;
+    std::array<int, kNumPeriodicSensors> timerIds;
+    std::array<int64_t, kNumPeriodicSensors> deadlinesNs;
+
+    int64_t startNs = ::android::elapsedRealtimeNano() + kBasePeriodNs;
+    int64_t endNs = startNs + kSamplingDurationNs;
+    for (size_t i = 0; i < kNumPeriodicSensors; i++) {
+        int64_t periodNs = kBasePeriodNs * static_cast<int64_t>(i + 1);
+        timerIds[i] = reactor.addTimer([&, i, periodNs](int64_t timestampNs) {
+            std::lock_guard<std::mutex> lock(mutex);
+            samples.push_back({deadlinesNs[i], timestampNs});
+            deadlinesNs[i] += periodNs;
+            if (deadlinesNs[i] < endNs) {
+                reactor.scheduleTimer(timerIds[i], deadlinesNs[i]);
+            }
+        });
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 0; i < kNumPeriodicSensors; i++) {
+            deadlinesNs[i] = startNs;
+            reactor.scheduleTimer(timerIds[i], startNs);
+        }
+    }
+
+    std::this_thread::sleep_for(std::chrono::nanoseconds(endNs - startNs + 2 * kBasePeriodNs));
+    for (int id : timerIds) {
+        reactor.removeTimer(id);
+    }
+
+    size_t expectedSamples = 0;
+    for (size_t i = 0; i < kNumPeriodicSensors; i++) {
+        int64_t periodNs = kBasePeriodNs * static_cast<int64_t>(i + 1);
+        expectedSamples += (kSamplingDurationNs + periodNs - 1) / periodNs;
+    }
+
+    std::vector<int64_t> wakeupsNs;
+    std::vector<int64_t> jittersNs;
+    for (const Sample& sample : samples) {
+        // The timer never fires early.
+        EXPECT_GE(sample.timestampNs, sample.deadlineNs);
+        jittersNs.push_back(sample.timestampNs - sample.deadlineNs);
+        wakeupsNs.push_back(sample.timestampNs);
+    }
+    std::sort(wakeupsNs.begin(), wakeupsNs.end());
+    size_t numWakeups = std::unique(wakeupsNs.begin(), wakeupsNs.end()) - wakeupsNs.begin();
+
+    ASSERT_EQ(expectedSamples, samples.size());
+    int64_t medianJitterNs = percentile(jittersNs, 50);
+    int64_t p99JitterNs = percentile(jittersNs, 99);
+    RecordProperty("samples_per_second", std::to_string(samples.size()));
+    RecordProperty("wakeups_per_second", std::to_string(numWakeups));
+    RecordProperty("median_jitter_us", std::to_string(medianJitterNs / 1000));
+    RecordProperty("p99_jitter_us", std::to_string(p99JitterNs / 1000));
+    // One wakeup per grid point, a thread per sensor would wake up once per sample.
+    EXPECT_LE(numWakeups, static_cast<size_t>(kSamplingDurationNs / kBasePeriodNs));
+    EXPECT_LT(medianJitterNs, 2 * 1000 * 1000);
+    EXPECT_LT(p99JitterNs, 20 * 1000 * 1000);
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "Sensor.h"
+
+#include <gtest/gtest.h>
+#include <utils/SystemClock.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+namespace {
+
+using ::android::hardware::sensors::V1_0::SensorFlagBits;
+
+constexpr int64_t kSamplingPeriodNs = 10 * 1000 * 1000;
+
+class EventCollector : public ISensorsEventCallback {
+  public:
+    using ISensorsEventCallback::postEvents;
+
+    void postEvents(const Event* events, size_t count, bool /* wakeup */) override {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEvents.insert(mEvents.end(), events, events + count);
+        mEventsPosted.notify_all();
+    }
+
+    //! @return The events posted so far once there are at least count of them.
+    std::vector<Event> waitForEvents(size_t count) {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mEventsPosted.wait_for(lock, std::chrono::seconds(5),
+                               [&] { return mEvents.size() >= count; });
+        return mEvents;
+    }
+
+    size_t numEvents() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEvents.size();
+    }
+
+  private:
+    std::mutex mMutex;
+    std::condition_variable mEventsPosted;
+    std::vector<Event> mEvents;
+};
+
+//! A continuous sensor that only uses the sampling of the Sensor base class.
+class PeriodicSensor : public Sensor {
+  public:
+    PeriodicSensor(ISensorsEventCallback* callback, PollReactor* reactor)
+        : Sensor(1 /* sensorHandle */, callback, reactor) {
+        mSensorInfo.name = "Periodic Sensor";
+        mSensorInfo.type = SensorType::ACCELEROMETER;
+        mSensorInfo.minDelay = 1000;
+        mSensorInfo.flags = SensorFlagBits::CONTINUOUS_MODE;
+    }
+
+    ~PeriodicSensor() override { stopSampling(); }
+};
+
+class SensorTest : public ::testing::Test {
+  protected:
+    EventCollector mCollector;
+    PollReactor mReactor;
+    std::unique_ptr<PeriodicSensor> mSensor =
+            std::make_unique<PeriodicSensor>(&mCollector, &mReactor);
+};
+
+}  // namespace
+
+TEST_F(SensorTest, SamplesAtTheRequestedPeriod) {
+    mSensor->batch(kSamplingPeriodNs);
+    int64_t start = ::android::elapsedRealtimeNano();
+    mSensor->activate(true);
+
+    std::vector<Event> events = mCollector.waitForEvents(5);
+    ASSERT_GE(events.size(), 5u);
+    EXPECT_GE(events[0].timestamp, start);
+    for (size_t i = 1; i < events.size(); i++) {
+        EXPECT_EQ(1, events[i].sensorHandle);
+        // Samples stay on the period grid, only the time readEvents takes varies.
+        EXPECT_GE(events[i].timestamp - events[i - 1].timestamp, kSamplingPeriodNs / 2);
+    }
+    // The timer never fires early, so the samples cannot come in faster than requested.
+    int64_t slackNs = 1000 * 1000;
+    EXPECT_GE(events.back().timestamp - events.front().timestamp,
+              static_cast<int64_t>(events.size() - 1) * kSamplingPeriodNs - slackNs);
+}
+
+TEST_F(SensorTest, StopsSamplingWhenDisabled) {
+    mSensor->batch(kSamplingPeriodNs);
+    mSensor->activate(true);
+    mCollector.waitForEvents(2);
+    mSensor->activate(false);
+
+    size_t numEvents = mCollector.numEvents();
+    std::this_thread::sleep_for(std::chrono::nanoseconds(5 * kSamplingPeriodNs));
+    EXPECT_EQ(numEvents, mCollector.numEvents());
+}
+
+TEST_F(SensorTest, StopsSamplingInDataInjectionMode) {
+    mSensor->batch(kSamplingPeriodNs);
+    mSensor->activate(true);
+    mCollector.waitForEvents(2);
+    mSensor->setOperationMode(OperationMode::DATA_INJECTION);
+
+    size_t numEvents = mCollector.numEvents();
+    std::this_thread::sleep_for(std::chrono::nanoseconds(5 * kSamplingPeriodNs));
+    EXPECT_EQ(numEvents, mCollector.numEvents());
+
+    mSensor->setOperationMode(OperationMode::NORMAL);
+    EXPECT_GT(mCollector.waitForEvents(numEvents + 1).size(), numEvents);
+}
+
+TEST_F(SensorTest, CanBeDestroyedWhileSampling) {
+    // Short enough that a sample is likely running while the sensor goes away.
+    mSensor->batch(1000 * 1000);
+    mSensor->activate(true);
+    mCollector.waitForEvents(3);
+    mSensor.reset();
+
+    size_t numEvents = mCollector.numEvents();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(numEvents, mCollector.numEvents());
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
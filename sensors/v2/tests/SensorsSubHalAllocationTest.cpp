@@ -0,0 +1,184 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "HalProxyCallback.h"
+#include "SensorsSubHal.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+namespace {
+
+//! Allocations made by the calling thread while tCountAllocations is set.
+thread_local bool tCountAllocations = false;
+thread_local size_t tNumAllocations = 0;
+
+}  // namespace
+
+void* operator new(size_t size) {
+    if (tCountAllocations) {
+        tNumAllocations++;
+    }
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t /* size */) noexcept {
+    free(ptr);
+}
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+namespace {
+
+using ::android::base::TemporaryFile;
+using ::android::base::WriteStringToFile;
+using ::android::hardware::sensors::V2_0::implementation::HalProxyCallbackBase;
+using ::android::hardware::sensors::V2_0::implementation::IScopedWakelockRefCounter;
+using ::android::hardware::sensors::V2_0::implementation::ScopedWakelock;
+using ::android::hardware::sensors::V2_1::implementation::IHalProxyCallback;
+
+constexpr int32_t kPrivateType = 4;
+constexpr size_t kNumWarmUpGestures = 10;
+constexpr size_t kNumGestures = 100;
+
+class FakeWakelockRefCounter : public IScopedWakelockRefCounter {
+  public:
+    bool incrementRefCountAndMaybeAcquireWakelock(size_t /* delta */,
+                                                  int64_t* /* timeoutStart */) override {
+        return true;
+    }
+
+    void decrementRefCountAndMaybeReleaseWakelock(size_t /* delta */,
+                                                  int64_t /* timeoutStart */) override {}
+};
+
+//! Stands in for the proxy, keeping only what the test checks so it does not allocate itself.
+class FakeHalProxyCallback : public IHalProxyCallback {
+  public:
+    Return<void> onDynamicSensorsConnected_2_1(const hidl_vec<SensorInfo>& /* added */) override {
+        return Void();
+    }
+
+    Return<void> onDynamicSensorsConnected(
+            const hidl_vec<V1_0::SensorInfo>& /* added */) override {
+        return Void();
+    }
+
+    Return<void> onDynamicSensorsDisconnected(const hidl_vec<int32_t>& /* removed */) override {
+        return Void();
+    }
+
+    void postEvents(const std::vector<Event>& events, ScopedWakelock wakelock) override {
+        mNumEvents += events.size();
+        mLastEvent = events.back();
+        mWakelockHeld = wakelock.isLocked();
+    }
+
+    ScopedWakelock createScopedWakelock(bool lock) override {
+        // Only the proxy side can create wakelocks.
+        return mWakelockFactory.createScopedWakelock(lock);
+    }
+
+    size_t mNumEvents = 0;
+    Event mLastEvent;
+    bool mWakelockHeld = false;
+
+  private:
+    FakeWakelockRefCounter mRefCounter;
+    HalProxyCallbackBase mWakelockFactory{nullptr /* callback */, &mRefCounter,
+                                          0 /* subHalIndex */};
+};
+
+/**
+ * Does what the reactor callback does once the sysfs attribute changed, without waiting for
+ * POLLPRI that a regular file never raises.
+ */
+class FakeGestureSensor : public SysfsPollingOneShotSensor {
+  public:
+    using SysfsPollingOneShotSensor::SysfsPollingOneShotSensor;
+
+    void deliverChange(int fd) {
+        std::lock_guard<std::mutex> runLock(mRunMutex);
+        if (readFd(fd)) {
+            size_t count = readEvents();
+            mCallback->postEvents(mEvents.data(), count, isWakeUpSensor());
+        }
+    }
+};
+
+class TestSensorsSubHal : public SensorsSubHal {
+  public:
+    std::shared_ptr<FakeGestureSensor> addGestureSensor(const SysfsSensorDescriptor& descriptor) {
+        AddSensor<FakeGestureSensor>(descriptor);
+        return std::static_pointer_cast<FakeGestureSensor>(mSensors.rbegin()->second);
+    }
+};
+
+}  // namespace
+
+// A UDFPS style tuple attribute reports a finger down. Once the posting thread has warmed up,
+// reading the attribute, filling the event and handing it through the sub-HAL to the proxy
+// callback must not allocate.
+TEST(SensorsSubHalAllocationTest, PostingAGestureDoesNotAllocateOnceWarm) {
+    TemporaryFile attribute;
+    ASSERT_TRUE(WriteStringToFile("1,320,1200\n", attribute.path));
+
+    SysfsSensorDescriptor descriptor = {};
+    descriptor.name = "Fake UDFPS";
+    descriptor.typeAsString = "org.lineageos.sensor.fake_udfps";
+    descriptor.pollPath = attribute.path;
+    descriptor.privateType = kPrivateType;
+    descriptor.wakeUp = true;
+    descriptor.parser = SysfsParser::INT_TUPLE;
+    descriptor.stateIndex = 0;
+    descriptor.payload = {1, 2};
+    descriptor.payloadSize = 2;
+
+    TestSensorsSubHal subHal;
+    std::shared_ptr<FakeGestureSensor> sensor = subHal.addGestureSensor(descriptor);
+    sp<FakeHalProxyCallback> callback = new FakeHalProxyCallback();
+    ASSERT_EQ(Result::OK, subHal.initialize(callback));
+
+    for (size_t i = 0; i < kNumWarmUpGestures; i++) {
+        sensor->deliverChange(attribute.fd);
+    }
+    tCountAllocations = true;
+    for (size_t i = 0; i < kNumGestures; i++) {
+        sensor->deliverChange(attribute.fd);
+    }
+    tCountAllocations = false;
+
+    EXPECT_EQ(0u, tNumAllocations);
+    EXPECT_EQ(kNumWarmUpGestures + kNumGestures, callback->mNumEvents);
+    EXPECT_EQ(sensor->getSensorInfo().sensorHandle, callback->mLastEvent.sensorHandle);
+    EXPECT_EQ(320, callback->mLastEvent.u.data[0]);
+    EXPECT_EQ(1200, callback->mLastEvent.u.data[1]);
+    EXPECT_TRUE(callback->mWakelockHeld);
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SysfsSensorDescriptor.h"
+
+#include <gtest/gtest.h>
+
+namespace android {
+namespace hardware {
+namespace sensors {
+namespace V2_1 {
+namespace subhal {
+namespace implementation {
+
+TEST(SysfsSensorDescriptorTest, ParsesBoolSensor) {
+    auto descriptors = parseSysfsSensorDescriptors(
+            "name=Long Press Sensor;type=org.lineageos.sensor.long_press;id=4;"
+            "poll=/sys/long_press_state;enable=/sys/long_press_enabled;parser=bool;wake=0\n");
+    ASSERT_EQ(1u, descriptors.size());
+    const SysfsSensorDescriptor& descriptor = descriptors[0];
+    EXPECT_EQ("Long Press Sensor", descriptor.name);
+    EXPECT_EQ("org.lineageos.sensor.long_press", descriptor.typeAsString);
+    EXPECT_EQ("/sys/long_press_state", descriptor.pollPath);
+    EXPECT_EQ("/sys/long_press_enabled", descriptor.enablePath);
+    EXPECT_EQ(4, descriptor.privateType);
+    EXPECT_FALSE(descriptor.wakeUp);
+    EXPECT_EQ(SysfsParser::BOOL, descriptor.parser);
+    EXPECT_EQ(0u, descriptor.payloadSize);
+}
+
+TEST(SysfsSensorDescriptorTest, ParsesTupleSensor) {
+    auto descriptors = parseSysfsSensorDescriptors(
+            " name = UDFPS ; type=udfps;id=5;poll=/sys/fod;parser=tuple;state=2;"
+            "payload=0, 1 ");
+    ASSERT_EQ(1u, descriptors.size());
+    const SysfsSensorDescriptor& descriptor = descriptors[0];
+    EXPECT_EQ("UDFPS", descriptor.name);
+    EXPECT_TRUE(descriptor.enablePath.empty());
+    EXPECT_TRUE(descriptor.wakeUp);
+    EXPECT_EQ(SysfsParser::INT_TUPLE, descriptor.parser);
+    EXPECT_EQ(2, descriptor.stateIndex);
+    ASSERT_EQ(2, descriptor.payloadSize);
+    EXPECT_EQ(0, descriptor.payload[0]);
+    EXPECT_EQ(1, descriptor.payload[1]);
+}
+
+TEST(SysfsSensorDescriptorTest, SkipsCommentsAndBlankLines) {
+    auto descriptors = parseSysfsSensorDescriptors(
+            "# a comment\n"
+            "\n"
+            "name=A;type=a;id=4;poll=/sys/a\r\n"
+            "   \n"
+            "name=B;type=b;id=5;poll=/sys/b");
+    ASSERT_EQ(2u, descriptors.size());
+    EXPECT_EQ("A", descriptors[0].name);
+    EXPECT_EQ("/sys/a", descriptors[0].pollPath);
+    EXPECT_EQ("B", descriptors[1].name);
+}
+
+TEST(SysfsSensorDescriptorTest, SkipsMalformedLines) {
+    auto descriptors = parseSysfsSensorDescriptors(
+            // Missing id, type, name and poll path.
+            "name=A;type=a;poll=/sys/a\n"
+            "name=A;id=4;poll=/sys/a\n"
+            "type=a;id=4;poll=/sys/a\n"
+            "name=A;type=a;id=4\n"
+            // Bad values.
+            "name=A;type=a;id=0;poll=/sys/a\n"
+            "name=A;type=a;id=x;poll=/sys/a\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=float\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;state=-1\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;payload=0,1,2,3,4,5,6,7,8\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;payload=0,,1\n"
+            // Unknown key and a pair without a value separator.
+            "name=A;type=a;id=4;poll=/sys/a;color=red\n"
+            "name=A;type=a;id=4;poll=/sys/a;wake\n"
+            "name=Good;type=good;id=4;poll=/sys/good;parser=tuple;state=8;"
+            "payload=0,1,2,3,4,5,6,7\n");
+    ASSERT_EQ(1u, descriptors.size());
+    EXPECT_EQ("Good", descriptors[0].name);
+    EXPECT_EQ(SysfsSensorDescriptor::kMaxPayloadValues, descriptors[0].payloadSize);
+}
+
+TEST(SysfsSensorDescriptorTest, SkipsOutOfRangeValues) {
+    auto descriptors = parseSysfsSensorDescriptors(
+            // Indexes past the last value a tuple is read with.
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;state=9\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;state=255\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;state=256\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;payload=0,9\n"
+            "name=A;type=a;id=4;poll=/sys/a;parser=tuple;payload=200\n"
+            // Ids of the built-in sensors.
+            "name=A;type=a;id=1;poll=/sys/a\n"
+            "name=A;type=a;id=2;poll=/sys/a\n"
+            "name=A;type=a;id=3;poll=/sys/a\n"
+            // Tuple keys on a boolean attribute, in either order.
+            "name=A;type=a;id=4;poll=/sys/a;parser=bool;state=0\n"
+            "name=A;type=a;id=4;poll=/sys/a;payload=0;parser=bool\n"
+            "name=A;type=a;id=4;poll=/sys/a;state=1\n"
+            "name=Good;type=good;id=4;poll=/sys/good;parser=tuple;state=8;payload=8\n");
+    ASSERT_EQ(1u, descriptors.size());
+    EXPECT_EQ("Good", descriptors[0].name);
+    EXPECT_EQ(8, descriptors[0].stateIndex);
+    ASSERT_EQ(1, descriptors[0].payloadSize);
+    EXPECT_EQ(8, descriptors[0].payload[0]);
+}
+
+TEST(SysfsSensorDescriptorTest, EmptyConfig) {
+    EXPECT_TRUE(parseSysfsSensorDescriptors("").empty());
+    EXPECT_TRUE(parseSysfsSensorDescriptors("\n\n# nothing\n").empty());
+}
+
+}  // namespace implementation
+}  // namespace subhal
+}  // namespace V2_1
+}  // namespace sensors
+}  // namespace hardware
+}  // namespace android